@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Load test for the TCP API server (port 4403).
+
+Opens several API connections at once, has each one go through the config handshake and then keep reading FromRadio
+frames for a while. Prints, per client, how long the handshake took and how many frames/bytes it received.
+
+Only needs the Python standard library, the few protobuf fields involved are encoded by hand.
+
+    bin/api-load-test.py --host 127.0.0.1 --clients 4 --duration 30
+"""
+
+import argparse
+import random
+import socket
+import struct
+import threading
+import time
+
+START1 = 0x94
+START2 = 0xC3
+FROMRADIO_CONFIG_COMPLETE_ID = 7  # FromRadio.config_complete_id
+TORADIO_WANT_CONFIG_ID = 3  # ToRadio.want_config_id
+TORADIO_HEARTBEAT = 7  # ToRadio.heartbeat
+HEARTBEAT_SECS = 60
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def read_varint(buf, pos):
+    value = shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def frame(payload):
+    return struct.pack(">BBH", START1, START2, len(payload)) + payload
+
+
+def want_config(nonce):
+    return frame(varint(TORADIO_WANT_CONFIG_ID << 3) + varint(nonce))
+
+
+def heartbeat():
+    # An empty length delimited submessage
+    return frame(varint(TORADIO_HEARTBEAT << 3 | 2) + b"\x00")
+
+
+def config_complete_id(payload):
+    """Return the nonce if this FromRadio is a config_complete_id, otherwise None"""
+    pos = 0
+    try:
+        while pos < len(payload):
+            key, pos = read_varint(payload, pos)
+            field, wire_type = key >> 3, key & 7
+            if wire_type == 0:
+                value, pos = read_varint(payload, pos)
+                if field == FROMRADIO_CONFIG_COMPLETE_ID:
+                    return value
+            elif wire_type == 2:
+                length, pos = read_varint(payload, pos)
+                pos += length
+            elif wire_type == 5:
+                pos += 4
+            elif wire_type == 1:
+                pos += 8
+            else:
+                return None
+    except IndexError:
+        pass
+    return None
+
+
+class Client(threading.Thread):
+    def __init__(self, num, host, port, duration):
+        super().__init__(daemon=True)
+        self.num = num
+        self.host = host
+        self.port = port
+        self.duration = duration
+        self.nonce = random.randint(1, 0xFFFFFFFF)
+        self.config_secs = None
+        self.frames = 0
+        self.bytes = 0
+        self.elapsed = 0
+        self.error = None
+
+    def run(self):
+        try:
+            self.exercise()
+        except OSError as e:
+            self.error = str(e)
+
+    def exercise(self):
+        start = time.monotonic()
+        sock = socket.create_connection((self.host, self.port), timeout=5)
+        sock.settimeout(0.5)
+        sock.sendall(want_config(self.nonce))
+        last_heartbeat = start
+
+        buf = bytearray()
+        while time.monotonic() - start < self.duration:
+            now = time.monotonic()
+            if now - last_heartbeat > HEARTBEAT_SECS:
+                sock.sendall(heartbeat())
+                last_heartbeat = now
+            try:
+                data = sock.recv(65536)
+            except socket.timeout:
+                continue
+            if not data:
+                self.error = "connection closed by the node"
+                break
+            self.bytes += len(data)
+            buf += data
+
+            # Cut out complete frames, skipping anything that isn't framed (debug output)
+            while len(buf) >= 4:
+                if buf[0] != START1 or buf[1] != START2:
+                    del buf[0]
+                    continue
+                length = buf[2] << 8 | buf[3]
+                if len(buf) < 4 + length:
+                    break
+                payload = bytes(buf[4 : 4 + length])
+                del buf[: 4 + length]
+                self.frames += 1
+                if self.config_secs is None and config_complete_id(payload) == self.nonce:
+                    self.config_secs = time.monotonic() - start
+        self.elapsed = time.monotonic() - start
+        sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure per client throughput of the TCP API server")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=4403)
+    parser.add_argument("--clients", type=int, default=4, help="number of concurrent connections")
+    parser.add_argument("--duration", type=float, default=30, help="seconds each client stays connected")
+    parser.add_argument("--stagger", type=float, default=0.1, help="seconds between opening connections")
+    args = parser.parse_args()
+
+    clients = [Client(i, args.host, args.port, args.duration) for i in range(args.clients)]
+    for client in clients:
+        client.start()
+        time.sleep(args.stagger)
+    for client in clients:
+        client.join()
+
+    print(f"{'client':>6} {'config s':>9} {'frames':>8} {'bytes':>10} {'frames/s':>9} {'bytes/s':>10}  error")
+    for c in clients:
+        secs = c.elapsed or 1
+        config = f"{c.config_secs:.3f}" if c.config_secs is not None else "-"
+        print(
+            f"{c.num:>6} {config:>9} {c.frames:>8} {c.bytes:>10} {c.frames / secs:>9.1f} {c.bytes / secs:>10.0f}  "
+            f"{c.error or ''}"
+        )
+
+    completed = [c for c in clients if c.config_secs is not None]
+    print(f"{len(completed)}/{len(clients)} clients completed the config handshake")
+    return 0 if len(completed) == len(clients) else 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
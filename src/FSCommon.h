@@ -12,6 +12,7 @@
 #define FSBegin() true
 #define FILE_O_WRITE "w"
 #define FILE_O_READ "r"
+#define FILE_O_APPEND "a"
 #endif
 
 #if defined(ARCH_STM32WL)
@@ -20,6 +21,7 @@
 #define FSCom InternalFS
 #define FSBegin() FSCom.begin()
 using namespace STM32_LittleFS_Namespace;
+#define FILE_O_APPEND FILE_O_WRITE // Opening for writing already seeks to the end
 #endif
 
 #if defined(ARCH_RP2040)
@@ -29,6 +31,7 @@ using namespace STM32_LittleFS_Namespace;
 #define FSBegin() FSCom.begin() // set autoformat
 #define FILE_O_WRITE "w"
 #define FILE_O_READ "r"
+#define FILE_O_APPEND "a"
 #endif
 
 #if defined(ARCH_ESP32)
@@ -38,6 +41,7 @@ using namespace STM32_LittleFS_Namespace;
 #define FSBegin() FSCom.begin(true) // format on failure
 #define FILE_O_WRITE "w"
 #define FILE_O_READ "r"
+#define FILE_O_APPEND "a"
 #endif
 
 #if defined(ARCH_NRF52)
@@ -46,6 +50,7 @@ using namespace STM32_LittleFS_Namespace;
 #define FSCom InternalFS
 #define FSBegin() FSCom.begin() // InternalFS formats on failure
 using namespace Adafruit_LittleFS_Namespace;
+#define FILE_O_APPEND FILE_O_WRITE // Opening for writing already seeks to the end
 #endif
 
 void fsInit();
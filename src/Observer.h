@@ -1,16 +1,103 @@
 #pragma once
 
 #include <Arduino.h>
-#include <list>
+#include <string.h>
 
 template <class T> class Observable;
 
+/**
+ * Pointers kept in the order they were added, the first N inside the object itself and more in one heap array that grows by
+ * doubling. Subscribing therefore allocates nothing in the common case, and notifying walks contiguous memory.
+ *
+ * Entries removed while the list is walked (an observer unsubscribing or being deleted from inside onNotify) are only cleared
+ * to NULL, the list is compacted when the outermost walk ends. Entries added during a walk are appended and not visited by it.
+ */
+template <class P, size_t N> class ObserverList
+{
+    P inlineItems[N];
+    P *items = inlineItems;
+    uint16_t count = 0;
+    uint16_t capacity = N;
+    uint8_t walking = 0; // Nesting depth of walks in progress
+    bool holes = false;
+
+    void compact()
+    {
+        uint16_t kept = 0;
+        for (uint16_t i = 0; i < count; i++)
+            if (items[i])
+                items[kept++] = items[i];
+        count = kept;
+        holes = false;
+    }
+
+  public:
+    ObserverList() {}
+    ObserverList(const ObserverList &other) { *this = other; }
+    ~ObserverList()
+    {
+        if (items != inlineItems)
+            delete[] items;
+    }
+
+    ObserverList &operator=(const ObserverList &other)
+    {
+        if (this != &other) {
+            count = 0;
+            for (uint16_t i = 0; i < other.count; i++)
+                if (other.items[i])
+                    add(other.items[i]);
+        }
+        return *this;
+    }
+
+    void add(P p)
+    {
+        if (count == capacity) {
+            P *grown = new P[2 * capacity];
+            memcpy(grown, items, count * sizeof(P));
+            if (items != inlineItems)
+                delete[] items;
+            items = grown;
+            capacity *= 2;
+        }
+        items[count++] = p;
+    }
+
+    /// Remove every occurrence of p
+    void remove(P p)
+    {
+        for (uint16_t i = 0; i < count; i++) {
+            if (items[i] == p) {
+                items[i] = NULL;
+                holes = true;
+            }
+        }
+        if (holes && !walking)
+            compact();
+    }
+
+    /// Number of entries, including cleared ones while a walk is in progress
+    uint16_t size() const { return count; }
+
+    /// @return entry i, NULL if it was removed during the current walk
+    P operator[](uint16_t i) const { return items[i]; }
+
+    /// Bracket every loop over the entries that may call out to code which adds or removes entries
+    void beginWalk() { walking++; }
+    void endWalk()
+    {
+        if (--walking == 0 && holes)
+            compact();
+    }
+};
+
 /**
  * An observer which can be mixed in as a baseclass.  Implement onNotify as a method in your class.
  */
 template <class T> class Observer
 {
-    std::list<Observable<T> *> observables;
+    ObserverList<Observable<T> *, 2> observables;
 
   public:
     virtual ~Observer();
@@ -55,42 +142,54 @@ template <class Callback, class T> class CallbackObserver : public Observer<T>
  */
 template <class T> class Observable
 {
-    std::list<Observer<T> *> observers;
+    ObserverList<Observer<T> *, 4> observers;
 
   public:
+    ~Observable()
+    {
+        // Observers outliving us must not try to unsubscribe later
+        for (uint16_t i = 0; i < observers.size(); i++) {
+            if (observers[i])
+                observers[i]->observables.remove(this);
+        }
+    }
+
     /**
      * Tell all observers about a change, observers can process arg as they wish
      *
+     * Observers may unobserve, or be deleted, from inside onNotify. Observers added meanwhile are first notified next time.
+     *
      * returns !0 if an observer chose to abort processing by returning this code
      */
     int notifyObservers(T arg)
     {
-        for (typename std::list<Observer<T> *>::const_iterator iterator = observers.begin(); iterator != observers.end();
-             ++iterator) {
-            int result = (*iterator)->onNotify(arg);
-            if (result != 0)
-                return result;
+        int result = 0;
+        observers.beginWalk();
+        for (uint16_t i = 0, n = observers.size(); i < n && result == 0; i++) {
+            Observer<T> *o = observers[i];
+            if (o)
+                result = o->onNotify(arg);
         }
+        observers.endWalk();
 
-        return 0;
+        return result;
     }
 
   private:
     friend class Observer<T>;
 
     // Not called directly, instead call observer.observe
-    void addObserver(Observer<T> *o) { observers.push_back(o); }
+    void addObserver(Observer<T> *o) { observers.add(o); }
 
     void removeObserver(Observer<T> *o) { observers.remove(o); }
 };
 
 template <class T> Observer<T>::~Observer()
 {
-    for (typename std::list<Observable<T> *>::const_iterator iterator = observables.begin(); iterator != observables.end();
-         ++iterator) {
-        (*iterator)->removeObserver(this);
+    for (uint16_t i = 0; i < observables.size(); i++) {
+        if (observables[i])
+            observables[i]->removeObserver(this);
     }
-    observables.clear();
 }
 
 template <class T> void Observer<T>::unobserve(Observable<T> *o)
@@ -101,6 +200,6 @@ template <class T> void Observer<T>::unobserve(Observable<T> *o)
 
 template <class T> void Observer<T>::observe(Observable<T> *o)
 {
-    observables.push_back(o);
+    observables.add(o);
     o->addObserver(this);
 }
\ No newline at end of file
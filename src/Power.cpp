@@ -767,6 +767,9 @@ void Power::readPowerStatus()
         LOG_DEBUG(threadlist.c_str());
         LOG_DEBUG("Heap status: %d/%d bytes free (%d), running %d/%d threads", memGet.getFreeHeap(), memGet.getHeapSize(),
                   memGet.getFreeHeap() - lastheap, running, concurrency::mainController.size(false));
+        AllocatorStats packetStats = packetPool.getStats();
+        LOG_DEBUG("Packet pool: %u/%u in use, high water %u, %u failed", packetStats.inUse, packetStats.capacity,
+                  packetStats.highWater, packetStats.failed);
         lastheap = memGet.getFreeHeap();
     }
 #ifdef DEBUG_HEAP_MQTT
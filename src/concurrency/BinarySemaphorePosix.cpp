@@ -15,13 +15,32 @@ BinarySemaphorePosix::~BinarySemaphorePosix() {}
  */
 bool BinarySemaphorePosix::take(uint32_t msec)
 {
+#if defined(__unix__) || defined(__APPLE__)
+    std::unique_lock<std::mutex> lock(mutex);
+    bool wasGiven = cond.wait_for(lock, std::chrono::milliseconds(msec), [this] { return given; });
+    given = false;
+    return wasGiven;
+#else
     delay(msec); // FIXME
     return false;
+#endif
 }
 
-void BinarySemaphorePosix::give() {}
+void BinarySemaphorePosix::give()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        given = true;
+    }
+    cond.notify_one();
+#endif
+}
 
-IRAM_ATTR void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken) {}
+IRAM_ATTR void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken)
+{
+    give();
+}
 
 } // namespace concurrency
 
@@ -2,6 +2,11 @@
 
 #include "../freertosinc.h"
 
+#if !defined(HAS_FREE_RTOS) && (defined(__unix__) || defined(__APPLE__))
+#include <condition_variable>
+#include <mutex>
+#endif
+
 namespace concurrency
 {
 
@@ -9,7 +14,12 @@ namespace concurrency
 
 class BinarySemaphorePosix
 {
-    // SemaphoreHandle_t semaphore;
+#if defined(__unix__) || defined(__APPLE__)
+    // Native builds run their "ISRs" (GPIO, sockets) on other threads, which may give while the main loop takes
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool given = false;
+#endif
 
   public:
     BinarySemaphorePosix();
@@ -19,6 +19,7 @@ const OSThread *OSThread::currentThread;
 
 ThreadController mainController, timerController;
 InterruptableDelay mainDelay;
+Scheduler mainScheduler;
 
 void OSThread::setup()
 {
@@ -37,14 +38,28 @@ OSThread::OSThread(const char *_name, uint32_t period, ThreadController *_contro
         bool added = controller->add(this);
         assert(added);
     }
+    // mainController only keeps the list of threads, mainScheduler decides when they run
+    if (controller == &mainController) {
+        scheduler = &mainScheduler;
+        scheduler->add(this);
+    }
 }
 
 OSThread::~OSThread()
 {
+    if (scheduler)
+        scheduler->remove(this);
     if (controller)
         controller->remove(this);
 }
 
+IRAM_ATTR void OSThread::setInterval(unsigned long _interval)
+{
+    Thread::setInterval(_interval);
+    if (scheduler)
+        scheduler->reschedule(this);
+}
+
 /**
  * Wait a specified number msecs starting from the current time (rather than the last time we were run)
  */
@@ -55,6 +70,18 @@ void OSThread::setIntervalFromNow(unsigned long _interval)
 
     // Cache the next run based on the last_run
     _cached_next_run = millis() + interval;
+
+    if (scheduler)
+        scheduler->reschedule(this);
+}
+
+void OSThread::wakeFromOtherThread()
+{
+    if (!scheduler)
+        return;
+    wakeRequested = true;
+    scheduler->markWakePending();
+    mainDelay.interrupt();
 }
 
 bool OSThread::shouldRun(unsigned long time)
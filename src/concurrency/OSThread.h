@@ -1,11 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <cstdlib>
 #include <stdint.h>
 
 #include "Thread.h"
 #include "ThreadController.h"
 #include "concurrency/InterruptableDelay.h"
+#include "concurrency/Scheduler.h"
 
 namespace concurrency
 {
@@ -30,8 +32,24 @@ extern InterruptableDelay mainDelay;
  */
 class OSThread : public Thread
 {
+    friend class Scheduler;
+
     ThreadController *controller;
 
+    /// Set for threads on mainController, which mainScheduler runs
+    Scheduler *scheduler = NULL;
+
+    // Scheduler bookkeeping
+    static const int16_t NOT_SCHEDULED = -1, PARKED = -2;
+    int16_t heapIndex = NOT_SCHEDULED;
+    uint32_t dueTime = 0;                   // Heap key, the next run time capped to Scheduler::MAX_AHEAD_MSEC from now
+    uint32_t placedTime = 0;                // When it was put in the heap with its current dueTime
+    std::atomic<bool> wakeRequested{false}; // Set by wakeFromOtherThread(), applied by the scheduler
+
+    uint32_t runCount = 0;
+    uint64_t cpuMicros = 0;
+    uint32_t maxMicros = 0;
+
     /// Show debugging info for disabled threads
     static bool showDisabled;
 
@@ -60,6 +78,20 @@ class OSThread : public Thread
      */
     void setIntervalFromNow(unsigned long _interval);
 
+    /// Same as Thread::setInterval, and tells the scheduler. Safe to call from an ISR
+    void setInterval(unsigned long _interval);
+
+    /**
+     * Run as soon as possible, like setIntervalFromNow(0), but safe to call from another OS thread: it only sets flags and
+     * interrupts mainDelay, the main loop changes the timing on its next pass. Not for ISRs.
+     */
+    void wakeFromOtherThread();
+
+    /// How often runOnce has been called, and the total and longest time it took
+    uint32_t getRunCount() const { return runCount; }
+    uint64_t getCpuMicros() const { return cpuMicros; }
+    uint32_t getMaxMicros() const { return maxMicros; }
+
   protected:
     /**
      * The method that will be called each time our thread gets a chance to run
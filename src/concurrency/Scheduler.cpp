@@ -0,0 +1,246 @@
+#include "Scheduler.h"
+#include "OSThread.h"
+#include "configuration.h"
+#include <algorithm>
+#include <stdio.h>
+
+namespace concurrency
+{
+
+bool Scheduler::before(const OSThread *a, const OSThread *b)
+{
+    return (int32_t)(a->dueTime - b->dueTime) < 0;
+}
+
+void Scheduler::siftUp(size_t i)
+{
+    OSThread *t = heap[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!before(t, heap[parent]))
+            break;
+        heap[i] = heap[parent];
+        heap[i]->heapIndex = i;
+        i = parent;
+    }
+    heap[i] = t;
+    t->heapIndex = i;
+}
+
+void Scheduler::siftDown(size_t i)
+{
+    OSThread *t = heap[i];
+    size_t n = heap.size();
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && before(heap[child + 1], heap[child]))
+            child++;
+        if (!before(heap[child], t))
+            break;
+        heap[i] = heap[child];
+        heap[i]->heapIndex = i;
+        i = child;
+    }
+    heap[i] = t;
+    t->heapIndex = i;
+}
+
+void Scheduler::removeFromHeap(size_t i)
+{
+    heap[i]->heapIndex = OSThread::NOT_SCHEDULED;
+    OSThread *last = heap.back();
+    heap.pop_back();
+    if (i < heap.size()) {
+        heap[i] = last;
+        last->heapIndex = i;
+        siftUp(i);
+        siftDown(last->heapIndex);
+    }
+}
+
+void Scheduler::place(OSThread *t, uint32_t now)
+{
+    if (!t->enabled) {
+        t->heapIndex = OSThread::PARKED;
+        parked.push_back(t);
+        return;
+    }
+
+    uint32_t next = t->_cached_next_run;
+    if ((int32_t)(next - now) > (int32_t)MAX_AHEAD_MSEC)
+        next = now + MAX_AHEAD_MSEC; // Surfaces early, gets a fresh key then
+    // A rebuild places everything again, a thread that was already waiting in the heap keeps counting lag from back then
+    if (t->heapIndex < 0 || next != t->dueTime)
+        t->placedTime = now;
+    t->dueTime = next;
+    heap.push_back(t);
+    siftUp(heap.size() - 1);
+}
+
+void Scheduler::rebuild(uint32_t now)
+{
+    heap.clear();
+    parked.clear();
+    for (OSThread *t : threads)
+        if (t->heapIndex != OSThread::NOT_SCHEDULED) // Threads taken off to run get placed after their run
+            place(t, now);
+}
+
+void Scheduler::add(OSThread *t)
+{
+    threads.push_back(t);
+    place(t, millis());
+}
+
+void Scheduler::remove(OSThread *t)
+{
+    if (t->heapIndex >= 0)
+        removeFromHeap(t->heapIndex);
+    else if (t->heapIndex == OSThread::PARKED)
+        parked.erase(std::find(parked.begin(), parked.end(), t));
+    t->heapIndex = OSThread::NOT_SCHEDULED;
+
+    threads.erase(std::find(threads.begin(), threads.end(), t));
+    std::replace(due.begin(), due.end(), t, (OSThread *)NULL);
+    if (running == t)
+        running = NULL;
+}
+
+IRAM_ATTR void Scheduler::reschedule(OSThread *t)
+{
+    // A thread changing its own timing while it runs is placed by its new timing afterwards anyway
+    if (t != running)
+        rebuildNeeded = true;
+}
+
+void Scheduler::refresh(uint32_t now)
+{
+    if (wakesPending.exchange(false)) {
+        for (OSThread *t : threads)
+            if (t->wakeRequested.exchange(false))
+                t->setIntervalFromNow(0); // Sets rebuildNeeded
+    }
+
+    if (rebuildNeeded) {
+        rebuildNeeded = false;
+        rebuild(now);
+        return;
+    }
+
+    // Somebody set enabled, without a setInterval() we would have heard about
+    for (size_t i = 0; i < parked.size();) {
+        OSThread *t = parked[i];
+        if (t->enabled) {
+            parked[i] = parked.back();
+            parked.pop_back();
+            place(t, now);
+        } else {
+            i++;
+        }
+    }
+}
+
+long Scheduler::runOrDelay()
+{
+    uint32_t now = millis();
+    refresh(now);
+
+    // Take everything due off the heap first, so a thread that asks to run again right away waits for the next pass
+    due.clear();
+    while (!heap.empty() && (int32_t)(now - heap[0]->dueTime) >= 0) {
+        due.push_back(heap[0]);
+        removeFromHeap(0);
+    }
+
+    for (size_t i = 0; i < due.size(); i++) {
+        OSThread *t = due[i];
+        if (!t) // Deleted by a thread that ran before it
+            continue;
+
+        // The key can be stale, e.g. the thread was disabled since, shouldRun has the final say
+        if (t->shouldRun(now)) {
+            // From when it became runnable: a thread woken by setInterval(0) is due at its last run, which can be long ago
+            uint32_t runnable = (int32_t)(t->dueTime - t->placedTime) > 0 ? t->dueTime : t->placedTime;
+            int32_t late = millis() - runnable;
+            if (late > 0) {
+                lagSumMsec += late;
+                if ((uint32_t)late > lagMaxMsec)
+                    lagMaxMsec = late;
+            }
+            lagRuns++;
+
+            running = t;
+            uint32_t start = micros();
+            t->run();
+            uint32_t us = micros() - start;
+            if (!running) // Deleted itself
+                continue;
+            running = NULL;
+
+            t->runCount++;
+            t->cpuMicros += us;
+            if (us > t->maxMicros)
+                t->maxMicros = us;
+        }
+        place(t, millis());
+    }
+    due.clear();
+
+    // The threads that ran may have woken others
+    now = millis();
+    refresh(now);
+
+    if (heap.empty())
+        return MAX_DELAY_MSEC;
+    int32_t delay = heap[0]->dueTime - now;
+    if (delay < 0)
+        return 0;
+    return delay < MAX_DELAY_MSEC ? delay : MAX_DELAY_MSEC;
+}
+
+void Scheduler::toJson(std::string &out) const
+{
+    char buf[160];
+
+    out += "[";
+    for (size_t i = 0; i < threads.size(); i++) {
+        const OSThread *t = threads[i];
+        snprintf(buf, sizeof(buf), "%s{\"name\":\"%s\",\"runs\":%lu,\"cpu_us\":%llu,\"max_us\":%lu,\"enabled\":%s}",
+                 i ? "," : "", t->ThreadName.c_str(), (unsigned long)t->runCount, (unsigned long long)t->cpuMicros,
+                 (unsigned long)t->maxMicros, t->enabled ? "true" : "false");
+        out += buf;
+    }
+    out += "]";
+}
+
+void Scheduler::takeLag(uint32_t &meanMsec, uint32_t &maxMsec)
+{
+    meanMsec = lagRuns ? lagSumMsec / lagRuns : 0;
+    maxMsec = lagMaxMsec;
+    lagSumMsec = lagRuns = lagMaxMsec = 0;
+}
+
+void Scheduler::logSummary() const
+{
+    // Only the few threads with the most CPU time
+    const uint8_t numToLog = 3;
+    const OSThread *logged[numToLog] = {};
+    for (uint8_t n = 0; n < numToLog; n++) {
+        const OSThread *worst = NULL;
+        for (const OSThread *t : threads) {
+            if (!t->runCount || std::find(logged, logged + n, t) != logged + n)
+                continue;
+            if (!worst || t->cpuMicros > worst->cpuMicros)
+                worst = t;
+        }
+        if (!worst)
+            break;
+        logged[n] = worst;
+        LOG_INFO("Thread %s: runs=%u, cpu=%ums, mean=%uus, max=%uus", worst->ThreadName.c_str(), worst->runCount,
+                 (uint32_t)(worst->cpuMicros / 1000), (uint32_t)(worst->cpuMicros / worst->runCount), worst->maxMicros);
+    }
+}
+
+} // namespace concurrency
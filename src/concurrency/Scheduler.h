@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace concurrency
+{
+
+class OSThread;
+
+/**
+ * Runs the OSThreads of the main loop in the order they come due.
+ *
+ * Enabled threads sit in a binary min-heap keyed by their next run time, so a pass of the main loop only touches the threads
+ * that actually run, and the time until the top of the heap is exactly how long mainDelay may sleep. ThreadController instead
+ * asks every thread whether it should run on every pass.
+ *
+ * Disabled threads are parked outside the heap. Code all over the firmware flips OSThread::enabled directly, so each pass
+ * checks the parked threads' flags and moves the enabled ones back into the heap.
+ *
+ * setInterval() is also called from ISRs (NotifiedWorkerThread::notifyFromISR), so changing another thread's timing only sets
+ * a flag. The heap is only ever touched from the main loop, which rebuilds it before running threads and before working out
+ * how long it may sleep. Other OS threads (native builds) can't even do that, OSThread::wakeFromOtherThread() only sets
+ * atomic flags and the main loop applies the wake.
+ *
+ * Every run is timed, getRunCount() and getCpuMicros() on the thread return the totals.
+ */
+class Scheduler
+{
+  public:
+    /// How long runOrDelay() may ask the main loop to sleep
+    static const long MAX_DELAY_MSEC = 100 * 1000L;
+
+    void add(OSThread *t);
+    void remove(OSThread *t);
+
+    /// Timing of a thread was changed outside of its own run, safe to call from an ISR
+    void reschedule(OSThread *t);
+
+    /// A thread has wakeRequested set, safe to call from any OS thread
+    void markWakePending() { wakesPending = true; }
+
+    /// Run every thread that is due, each at most once. @return msecs until the next thread is due
+    long runOrDelay();
+
+    size_t size() const { return threads.size(); }
+
+    /// Append runs, CPU time and longest run of every thread to out, as a JSON array
+    void toJson(std::string &out) const;
+
+    /// Log the threads that used the most CPU time
+    void logSummary() const;
+
+    /**
+     * How late threads started compared to when they became runnable (due, or woken if that was later), since the last
+     * call: how far the main loop falls behind its schedule
+     */
+    void takeLag(uint32_t &meanMsec, uint32_t &maxMsec);
+
+  private:
+    // Keys are millis() values, and stay within 2^30 of each other so their differences can be compared as signed numbers
+    static const uint32_t MAX_AHEAD_MSEC = 1UL << 30;
+
+    std::vector<OSThread *> threads; // All of them, in the order they were added
+    std::vector<OSThread *> heap;
+    std::vector<OSThread *> parked;
+    std::vector<OSThread *> due; // Taken off the heap to run in this pass
+    OSThread *running = NULL;
+    volatile bool rebuildNeeded = false;
+    std::atomic<bool> wakesPending{false};
+
+    uint32_t lagSumMsec = 0, lagRuns = 0, lagMaxMsec = 0;
+
+    static bool before(const OSThread *a, const OSThread *b);
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void removeFromHeap(size_t i);
+
+    /// Put t in the heap by its next run time, or park it if it is disabled
+    void place(OSThread *t, uint32_t now);
+    void rebuild(uint32_t now);
+    /// Apply timing changes made outside of the scheduler since the last call
+    void refresh(uint32_t now);
+};
+
+extern Scheduler mainScheduler;
+
+} // namespace concurrency
@@ -961,6 +961,7 @@ static LGFX *tft = nullptr;
 
 #if defined(ST7701_CS) || defined(ST7735_CS) || defined(ST7789_CS) || defined(ILI9341_DRIVER) || defined(ILI9342_DRIVER) ||      \
     defined(RAK14014) || defined(HX8357_CS) || defined(ILI9488_CS) || defined(ST72xx_DE) || (ARCH_PORTDUINO && HAS_SCREEN != 0)
+#include "LatencyStats.h"
 #include "SPILock.h"
 #include "TFTDisplay.h"
 #include <SPI.h>
@@ -1004,37 +1005,82 @@ TFTDisplay::TFTDisplay(uint8_t address, int sda, int scl, OLEDDISPLAY_GEOMETRY g
 #endif
 }
 
+TFTDisplay::~TFTDisplay()
+{
+    // display() waits for its last DMA transfer before returning, nothing is still reading the line buffers
+    delete[] lineBuffers;
+}
+
+void TFTDisplay::pushSpan(uint16_t y, uint16_t x0, uint16_t x1, uint16_t *line)
+{
+    const uint8_t *page = buffer + (y / 8) * displayWidth;
+    const uint8_t mask = 1 << (y & 7);
+    for (uint16_t x = x0; x <= x1; x++)
+        line[x - x0] = (page[x] & mask) ? TFT_MESH : TFT_BLACK;
+
+#ifdef RAK14014
+    tft->pushImage(x0, y, x1 - x0 + 1, 1, line);
+#else
+    tft->waitDMA(); // The previous span may still be going out of the other line buffer
+    tft->pushImageDMA(x0, y, x1 - x0 + 1, 1, line);
+#endif
+}
+
 // Write the buffer to the display memory
 void TFTDisplay::display(bool fromBlank)
 {
+    LATENCY_SCOPE(LATENCY_DISPLAY_FRAME);
+
     if (fromBlank)
         tft->fillScreen(TFT_BLACK);
     // tft->clear();
     concurrency::LockGuard g(spiLock);
 
-    uint16_t x, y;
-
-    for (y = 0; y < displayHeight; y++) {
-        for (x = 0; x < displayWidth; x++) {
-            auto isset = buffer[x + (y / 8) * displayWidth] & (1 << (y & 7));
-            if (!fromBlank) {
-                // get src pixel in the page based ordering the OLED lib uses FIXME, super inefficent
-                auto dblbuf_isset = buffer_back[x + (y / 8) * displayWidth] & (1 << (y & 7));
-                if (isset != dblbuf_isset) {
-                    tft->drawPixel(x, y, isset ? TFT_MESH : TFT_BLACK);
+    if (!lineBuffers)
+        lineBuffers = new uint16_t[2 * displayWidth];
+
+    // Diff one 8 row page at a time: bytes first, to skip unchanged pages and narrow down the columns, then each row
+    // of a changed page is pushed as a single span from its first to its last changed pixel
+    uint8_t whichLine = 0;
+    tft->startWrite();
+    for (uint16_t pageY = 0; pageY < displayHeight; pageY += 8) {
+        const uint8_t *page = buffer + (pageY / 8) * displayWidth;
+        const uint8_t *oldPage = buffer_back + (pageY / 8) * displayWidth;
+
+        int32_t first = -1, last = -1;
+        for (uint16_t x = 0; x < displayWidth; x++) {
+            if (page[x] != (fromBlank ? 0 : oldPage[x])) {
+                if (first < 0)
+                    first = x;
+                last = x;
+            }
+        }
+        if (first < 0)
+            continue;
+
+        for (uint16_t y = pageY; y < pageY + 8 && y < displayHeight; y++) {
+            const uint8_t mask = 1 << (y & 7);
+            int32_t x0 = -1, x1 = -1;
+            for (int32_t x = first; x <= last; x++) {
+                if ((page[x] ^ (fromBlank ? 0 : oldPage[x])) & mask) {
+                    if (x0 < 0)
+                        x0 = x;
+                    x1 = x;
                 }
-            } else if (isset) {
-                tft->drawPixel(x, y, TFT_MESH);
+            }
+            if (x0 >= 0) {
+                pushSpan(y, x0, x1, lineBuffers + whichLine * displayWidth);
+                whichLine ^= 1;
             }
         }
     }
+#ifndef RAK14014
+    tft->waitDMA(); // Don't give the bus back to the radio while we are still using it
+#endif
+    tft->endWrite();
+
     // Copy the Buffer to the Back Buffer
-    for (y = 0; y < (displayHeight / 8); y++) {
-        for (x = 0; x < displayWidth; x++) {
-            uint16_t pos = x + y * displayWidth;
-            buffer_back[pos] = buffer[pos];
-        }
-    }
+    memcpy(buffer_back, buffer, displayBufferSize);
 }
 
 // Send a command to the display (low level function)
@@ -1174,7 +1220,6 @@ bool TFTDisplay::connect()
     tft->setRotation(0);
 #elif defined(RAK14014)
     tft->setRotation(1);
-    tft->setSwapBytes(true);
     //    tft->fillScreen(TFT_BLACK);
     ft6336u.begin();
     pinMode(SCREEN_TOUCH_INT, INPUT_PULLUP);
@@ -1188,6 +1233,7 @@ bool TFTDisplay::connect()
 #else
     tft->setRotation(3); // Orient horizontal and wide underneath the silkscreen name label
 #endif
+    tft->setSwapBytes(true); // display() pushes native RGB565 line buffers
     tft->fillScreen(TFT_BLACK);
 
     return true;
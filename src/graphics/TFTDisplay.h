@@ -6,8 +6,10 @@
 /**
  * An adapter class that allows using the LovyanGFX library as if it was an OLEDDisplay implementation.
  *
+ * display() diffs the page ordered OLED buffer against buffer_back and only pushes the changed span of every changed row,
+ * as RGB565 block writes (DMA where the library and bus support it).
+ *
  * Remaining TODO:
- * optimize display() to only draw changed pixels (see other OLED subclasses for examples)
  * Use the fast NRF52 SPI API rather than the slow standard arduino version
  *
  * turn radio back on - currently with both on spi bus is fucked? or are we leaving chip select asserted?
@@ -19,6 +21,7 @@ class TFTDisplay : public OLEDDisplay
     FIXME - the parameters are not used, just a temporary hack to keep working like the old displays
     */
     TFTDisplay(uint8_t, int, int, OLEDDISPLAY_GEOMETRY, HW_I2C);
+    ~TFTDisplay();
 
     // Write the buffer to the display memory
     virtual void display() override { display(false); };
@@ -57,4 +60,11 @@ class TFTDisplay : public OLEDDisplay
 
     // Connect to the display
     virtual bool connect() override;
+
+  private:
+    /// Two RGB565 lines, one is filled while the other one is still being sent by DMA
+    uint16_t *lineBuffers = nullptr;
+
+    /// Convert x0..x1 of row y to RGB565 and push it to the panel
+    void pushSpan(uint16_t y, uint16_t x0, uint16_t x1, uint16_t *line);
 };
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "graphics/images.h"
 #include "meshUtils.h"
 #include <algorithm>
+#include <unordered_map>
 
 // Forward declarations for functions defined in Screen.cpp
 namespace graphics
@@ -45,6 +46,20 @@ void drawScaledXBitmap16x16(int x, int y, int width, int height, const uint8_t *
 static NodeListMode currentMode = MODE_LAST_HEARD;
 static int scrollIndex = 0;
 
+// Distance and bearing of the nodes drawn with a position, so the trig only reruns when one end moves
+struct NodeGeoEntry {
+    // Positions the distance and bearing were computed for
+    int32_t fromLat = 0, fromLon = 0, toLat = 0, toLon = 0;
+    bool hasGeo = false;
+    float distanceKm = 0;
+    float bearing = 0;
+};
+static std::unordered_map<NodeNum, NodeGeoEntry> geoCache;
+
+// The list as sorted on the last frame, and scratch space for the next sort, kept to reuse their memory
+static std::vector<NodeNum> lastOrder;
+static std::vector<bool> listed; // By NodeDB position
+
 // =============================
 // Utility Functions
 // =============================
@@ -104,38 +119,98 @@ float calculateBearing(double lat1, double lon1, double lat2, double lon2)
     return fmod(bearing + 360.0, 360.0);
 }
 
+/**
+ * Distance and bearing from the given position (in 1e-7 degrees) to a node, from the cache unless either end moved
+ * @return NULL if the node has no valid position
+ */
+static const NodeGeoEntry *getNodeGeo(int32_t fromLat, int32_t fromLon, const meshtastic_NodeInfoLite *node)
+{
+    if (!nodeDB->hasValidPosition(node))
+        return NULL;
+
+    NodeGeoEntry &c = geoCache[node->num];
+    if (c.hasGeo && c.fromLat == fromLat && c.fromLon == fromLon && c.toLat == node->position.latitude_i &&
+        c.toLon == node->position.longitude_i)
+        return &c;
+
+    c.fromLat = fromLat;
+    c.fromLon = fromLon;
+    c.toLat = node->position.latitude_i;
+    c.toLon = node->position.longitude_i;
+    c.hasGeo = true;
+
+    double lat1 = fromLat * 1e-7;
+    double lon1 = fromLon * 1e-7;
+    double lat2 = c.toLat * 1e-7;
+    double lon2 = c.toLon * 1e-7;
+
+    double earthRadiusKm = 6371.0;
+    double dLat = (lat2 - lat1) * DEG_TO_RAD;
+    double dLon = (lon2 - lon1) * DEG_TO_RAD;
+
+    double a = sin(dLat / 2) * sin(dLat / 2) + cos(lat1 * DEG_TO_RAD) * cos(lat2 * DEG_TO_RAD) * sin(dLon / 2) * sin(dLon / 2);
+    c.distanceKm = earthRadiusKm * 2 * atan2(sqrt(a), sqrt(1 - a));
+    c.bearing = calculateBearing(lat1, lon1, lat2, lon2);
+    return &c;
+}
+
 int calculateMaxScroll(int totalEntries, int visibleRows)
 {
     return std::max(0, (totalEntries - 1) / (visibleRows * 2));
 }
 
+// Favorites first, then by last heard (most recent first)
+static bool entryBefore(const NodeEntry &a, const NodeEntry &b)
+{
+    bool aFav = a.node->is_favorite;
+    bool bFav = b.node->is_favorite;
+    if (aFav != bFav)
+        return aFav;
+    if (a.sortValue == 0 || a.sortValue == UINT32_MAX)
+        return false;
+    if (b.sortValue == 0 || b.sortValue == UINT32_MAX)
+        return true;
+    return a.sortValue < b.sortValue;
+}
+
 void retrieveAndSortNodes(std::vector<NodeEntry> &nodeList)
 {
     size_t numNodes = nodeDB->getNumMeshNodes();
+    NodeNum ourNum = nodeDB->getNodeNum();
+    if (geoCache.size() > numNodes)
+        geoCache.clear(); // Nodes were removed, forget about them
+
+    // Start from the order of the last frame, nodes that weren't listed then go at the end
+    listed.assign(numNodes, false);
+    nodeList.reserve(nodeList.size() + numNodes);
+    const meshtastic_NodeInfoLite *first = numNodes ? nodeDB->getMeshNodeByIndex(0) : NULL;
+    for (NodeNum num : lastOrder) {
+        meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(num);
+        if (!node || num == ourNum || listed[node - first])
+            continue;
+        listed[node - first] = true;
+        nodeList.push_back(NodeEntry{node, sinceLastSeen(node)});
+    }
     for (size_t i = 0; i < numNodes; i++) {
         meshtastic_NodeInfoLite *node = nodeDB->getMeshNodeByIndex(i);
-        if (!node || node->num == nodeDB->getNodeNum())
+        if (listed[i] || !node || node->num == ourNum)
             continue;
+        nodeList.push_back(NodeEntry{node, sinceLastSeen(node)});
+    }
 
-        NodeEntry entry;
-        entry.node = node;
-        entry.sortValue = sinceLastSeen(node);
-
-        nodeList.push_back(entry);
+    // All last heard times move on together, so from one frame to the next only a few nodes are out of place and an
+    // insertion sort is close to a single pass
+    for (size_t i = 1; i < nodeList.size(); i++) {
+        NodeEntry entry = nodeList[i];
+        size_t j = i;
+        for (; j > 0 && entryBefore(entry, nodeList[j - 1]); j--)
+            nodeList[j] = nodeList[j - 1];
+        nodeList[j] = entry;
     }
 
-    // Sort nodes: favorites first, then by last heard (most recent first)
-    std::sort(nodeList.begin(), nodeList.end(), [](const NodeEntry &a, const NodeEntry &b) {
-        bool aFav = a.node->is_favorite;
-        bool bFav = b.node->is_favorite;
-        if (aFav != bFav)
-            return aFav;
-        if (a.sortValue == 0 || a.sortValue == UINT32_MAX)
-            return false;
-        if (b.sortValue == 0 || b.sortValue == UINT32_MAX)
-            return true;
-        return a.sortValue < b.sortValue;
-    });
+    lastOrder.clear();
+    for (const NodeEntry &entry : nodeList)
+        lastOrder.push_back(entry.node->num);
 }
 
 void drawColumnSeparator(OLEDDisplay *display, int16_t x, int16_t yStart, int16_t yEnd)
@@ -265,20 +340,11 @@ void drawNodeDistance(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16
     char distStr[10] = "";
 
     meshtastic_NodeInfoLite *ourNode = nodeDB->getMeshNode(nodeDB->getNodeNum());
-    if (nodeDB->hasValidPosition(ourNode) && nodeDB->hasValidPosition(node)) {
-        double lat1 = ourNode->position.latitude_i * 1e-7;
-        double lon1 = ourNode->position.longitude_i * 1e-7;
-        double lat2 = node->position.latitude_i * 1e-7;
-        double lon2 = node->position.longitude_i * 1e-7;
-
-        double earthRadiusKm = 6371.0;
-        double dLat = (lat2 - lat1) * DEG_TO_RAD;
-        double dLon = (lon2 - lon1) * DEG_TO_RAD;
-
-        double a =
-            sin(dLat / 2) * sin(dLat / 2) + cos(lat1 * DEG_TO_RAD) * cos(lat2 * DEG_TO_RAD) * sin(dLon / 2) * sin(dLon / 2);
-        double c = 2 * atan2(sqrt(a), sqrt(1 - a));
-        double distanceKm = earthRadiusKm * c;
+    const NodeGeoEntry *geo = NULL;
+    if (nodeDB->hasValidPosition(ourNode))
+        geo = getNodeGeo(ourNode->position.latitude_i, ourNode->position.longitude_i, node);
+    if (geo) {
+        double distanceKm = geo->distanceKm;
 
         if (config.display.units == meshtastic_Config_DisplayConfig_DisplayUnits_IMPERIAL) {
             double miles = distanceKm * 0.621371;
@@ -373,7 +439,8 @@ void drawEntryCompass(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16
 void drawCompassArrow(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth, float myHeading,
                       double userLat, double userLon)
 {
-    if (!nodeDB->hasValidPosition(node))
+    const NodeGeoEntry *geo = getNodeGeo((int32_t)lround(userLat * 1e7), (int32_t)lround(userLon * 1e7), node);
+    if (!geo)
         return;
 
     bool isLeftCol = (x < SCREEN_WIDTH / 2);
@@ -382,10 +449,7 @@ void drawCompassArrow(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16
     int centerX = x + columnWidth - arrowXOffset;
     int centerY = y + FONT_HEIGHT_SMALL / 2;
 
-    double nodeLat = node->position.latitude_i * 1e-7;
-    double nodeLon = node->position.longitude_i * 1e-7;
-    float bearingToNode = calculateBearing(userLat, userLon, nodeLat, nodeLon);
-    float relativeBearing = fmod((bearingToNode - myHeading + 360), 360);
+    float relativeBearing = fmod((geo->bearing - myHeading + 360), 360);
     float angle = relativeBearing * DEG_TO_RAD;
 
     // Shrink size by 2px
@@ -436,8 +500,9 @@ void drawNodeListScreen(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t
     // Space below header
     y += COMMON_HEADER_HEIGHT;
 
-    // Fetch and display sorted node list
-    std::vector<NodeEntry> nodeList;
+    // Fetch and display sorted node list, reusing the memory of the last frame
+    static std::vector<NodeEntry> nodeList;
+    nodeList.clear();
     retrieveAndSortNodes(nodeList);
 
     int totalEntries = nodeList.size();
@@ -1498,7 +1498,7 @@ void loop()
 
     service->loop();
 
-    long delayMsec = mainController.runOrDelay();
+    long delayMsec = mainScheduler.runOrDelay();
 
     // We want to sleep as long as possible here - because it saves power
     if (!runASAP && loopCanSleep()) {
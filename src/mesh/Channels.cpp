@@ -71,11 +71,20 @@ meshtastic_Channel &Channels::fixupChannel(ChannelIndex chIndex)
             *meshtastic_channelSettings.name = '\0';
     }
 
-    hashes[chIndex] = generateHash(chIndex);
+    setHash(chIndex, generateHash(chIndex));
 
     return ch;
 }
 
+void Channels::setHash(ChannelIndex chIndex, int16_t hash)
+{
+    if (hashes[chIndex] >= 0)
+        channelsByHash[hashes[chIndex]] &= ~(1 << chIndex);
+    hashes[chIndex] = hash;
+    if (hash >= 0)
+        channelsByHash[hash] |= (1 << chIndex);
+}
+
 void Channels::initDefaultLoraConfig()
 {
     meshtastic_Config_LoRaConfig &loraConfig = config.lora;
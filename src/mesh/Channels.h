@@ -28,6 +28,10 @@ class Channels
     /// the precomputed hashes for each of our channels, or -1 for invalid
     int16_t hashes[MAX_NUM_CHANNELS] = {};
 
+    /// for every possible channel hash, a bitmask of the channel indexes that currently have it
+    uint8_t channelsByHash[256] = {};
+    static_assert(MAX_NUM_CHANNELS <= 8, "channelsByHash needs one bit per channel");
+
   public:
     Channels() {}
 
@@ -75,6 +79,12 @@ class Channels
      */
     bool decryptForHash(ChannelIndex chIndex, ChannelHash channelHash);
 
+    /** Return a bitmask of the channel indexes whose hash matches channelHash (bit n set for channel n)
+     *
+     * Kept up to date whenever a channel hash is generated, so receivers can skip channels that can't decode a packet
+     */
+    uint8_t getCandidatesForHash(ChannelHash channelHash) { return channelsByHash[channelHash]; }
+
     /** Given a channel index setup crypto for encoding that channel (or the primary channel if that channel is unsecured)
      *
      * This method is called before encoding outbound packets
@@ -113,6 +123,9 @@ class Channels
 
     int16_t getHash(ChannelIndex i) { return hashes[i]; }
 
+    /// Store the hash for a channel and keep channelsByHash in sync
+    void setHash(ChannelIndex chIndex, int16_t hash);
+
     /**
      * Validate a channel, fixing any errors as needed
      */
@@ -0,0 +1,88 @@
+#include "ContentionEstimator.h"
+#include "configuration.h"
+#include <stdio.h>
+
+ContentionEstimator::ContentionEstimator(uint8_t _cwMin, uint8_t _cwMax)
+    : cwMinLow(_cwMin - 1), cwMinHigh(_cwMin + 2), cwMaxLow(_cwMax - 2), cwMaxHigh(_cwMax + 2)
+{
+    adjust();
+}
+
+void ContentionEstimator::average(uint32_t &rate, bool hit)
+{
+    // rate += (sample - rate) / 2^AVERAGE_SHIFT, in fixed point
+    rate -= rate >> AVERAGE_SHIFT;
+    if (hit)
+        rate += 65536 >> AVERAGE_SHIFT;
+}
+
+void ContentionEstimator::txAttempt(bool channelBusy)
+{
+    numTxAttempts++;
+    average(busyRate, channelBusy);
+    sampled();
+}
+
+void ContentionEstimator::rxFrame(bool decoded)
+{
+    numRxFrames++;
+    average(errorRate, !decoded);
+    sampled();
+}
+
+void ContentionEstimator::adjust()
+{
+    cwMin = cwMinLow + (level * (cwMinHigh - cwMinLow) + MAX_LEVEL / 2) / MAX_LEVEL;
+    cwMax = cwMaxLow + (level * (cwMaxHigh - cwMaxLow) + MAX_LEVEL / 2) / MAX_LEVEL;
+}
+
+void ContentionEstimator::sampled()
+{
+    if (++sinceAdjust < ADJUST_EVERY)
+        return;
+    sinceAdjust = 0;
+
+    const int32_t minGain = 65536 * MIN_GAIN_PERCENT / 100;
+    int32_t gain = (int32_t)(lastErrorRate - errorRate);
+    int8_t step;
+    if (lastStep > 0)
+        step = gain > minGain ? 1 : -1; // Keep widening only while it pays off
+    else if (lastStep < 0)
+        step = -gain > minGain ? 1 : -1; // Narrowing made it worse, go back
+    else
+        step = level == MAX_LEVEL ? -1 : 1; // Resting at a bound, probe the other way
+    if ((step > 0 && level == MAX_LEVEL) || (step < 0 && level == 0))
+        step = 0;
+
+    level += step;
+    lastStep = step;
+    lastErrorRate = errorRate;
+    adjust();
+    if (step > 0)
+        numWiden++;
+    else if (step < 0)
+        numNarrow++;
+
+    bool sameSlot = errorRate > 65536 * ERROR_HIGH_PERCENT / 100 && busyRate < 65536 * BUSY_LOW_PERCENT / 100;
+    if (sameSlot && slotPercent < SLOT_PERCENT_MAX)
+        slotPercent += SLOT_PERCENT_STEP;
+    else if (!sameSlot && slotPercent > 100)
+        slotPercent -= SLOT_PERCENT_STEP;
+}
+
+void ContentionEstimator::toJson(std::string &out) const
+{
+    char buf[200];
+    snprintf(buf, sizeof(buf),
+             "{\"busy_percent\":%.1f,\"error_percent\":%.1f,\"cw_min\":%u,\"cw_max\":%u,\"slot_percent\":%u,\"tx_attempts\":%lu,"
+             "\"rx_frames\":%lu,\"widened\":%lu,\"narrowed\":%lu}",
+             getBusyPercent(), getErrorPercent(), cwMin, cwMax, slotPercent, (unsigned long)numTxAttempts,
+             (unsigned long)numRxFrames, (unsigned long)numWiden, (unsigned long)numNarrow);
+    out += buf;
+}
+
+void ContentionEstimator::logSummary() const
+{
+    LOG_INFO("Contention: busy=%.1f%%, rx errors=%.1f%%, CW %u-%u, slot %u%%, widened %u, narrowed %u", getBusyPercent(),
+             getErrorPercent(), cwMin, cwMax, slotPercent, numWiden, numNarrow);
+}
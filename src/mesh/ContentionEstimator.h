@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Short term estimate of how contended the channel is, used to size the contention window (CW) online instead of only from
+ * the fixed CWmin/CWmax.
+ *
+ * Two rates are kept as moving averages over roughly the last 32 events each: how often a transmit attempt found the channel
+ * busy (CAD or a reception in progress), and how often a frame we started receiving could not be decoded, which on a LoRa
+ * mesh is nearly always a collision.
+ *
+ * The window bounds move together along a few levels, from 2^2..2^6 up to 2^5..2^10 slots, by hill climbing on the collision
+ * rate: a step wider is kept only while it measurably lowers collisions, otherwise the window drifts back down. Most
+ * collisions on a mesh are between nodes that can't hear each other, and a wide window does little against those while
+ * delaying every relay, so without evidence that widening helps the short windows win. Collisions while CAD hardly ever
+ * reports a busy channel mean nodes start within the same slot, so those also stretch the slot time.
+ *
+ * The estimator only does arithmetic on its own state, so MeshSim runs the very same code as the radio.
+ */
+class ContentionEstimator
+{
+  public:
+    /// Starts at the level matching the given fixed window
+    ContentionEstimator(uint8_t cwMin, uint8_t cwMax);
+
+    /// A transmit attempt, channelBusy if it had to back off
+    void txAttempt(bool channelBusy);
+
+    /// A frame was received, decoded is false if it failed the CRC or header checks
+    void rxFrame(bool decoded);
+
+    uint8_t getCWmin() const { return cwMin; }
+    uint8_t getCWmax() const { return cwMax; }
+    uint32_t getSlotTimeMsec(uint32_t baseSlotTimeMsec) const { return baseSlotTimeMsec * slotPercent / 100; }
+
+    /// Share of transmit attempts that found the channel busy, 0-100
+    float getBusyPercent() const { return busyRate / 655.36f; }
+    /// Share of received frames that could not be decoded, 0-100
+    float getErrorPercent() const { return errorRate / 655.36f; }
+
+    /// Append the estimator state to out, as a JSON object
+    void toJson(std::string &out) const;
+
+    void logSummary() const;
+
+  private:
+    static const uint8_t AVERAGE_SHIFT = 5; // Moving averages over about 2^5 events
+    static const uint8_t ADJUST_EVERY = 16; // Samples between steps
+    static const uint8_t MAX_LEVEL = 5;
+    static const uint8_t DEFAULT_LEVEL = 2;   // CW 3..8 with the default bounds, same as the fixed window
+    static const uint8_t MIN_GAIN_PERCENT = 5; // Collision rate drop that makes a step wider worth it
+    static const uint8_t BUSY_LOW_PERCENT = 10;
+    static const uint8_t ERROR_HIGH_PERCENT = 50;
+    static const uint8_t SLOT_PERCENT_MAX = 150;
+    static const uint8_t SLOT_PERCENT_STEP = 10;
+
+    // Window bounds at level 0 and MAX_LEVEL
+    uint8_t cwMinLow, cwMinHigh, cwMaxLow, cwMaxHigh;
+    uint8_t cwMin, cwMax;
+    uint8_t level = DEFAULT_LEVEL;
+    int8_t lastStep = 1;
+    uint8_t slotPercent = 100;
+    uint8_t sinceAdjust = 0;
+
+    // Rates in 1/65536ths
+    uint32_t busyRate = 0;
+    uint32_t errorRate = 0;
+    uint32_t lastErrorRate = 0;
+
+    uint32_t numTxAttempts = 0, numRxFrames = 0, numWiden = 0, numNarrow = 0;
+
+    static void average(uint32_t &rate, bool hit);
+    void sampled();
+    void adjust();
+};
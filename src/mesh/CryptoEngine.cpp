@@ -33,6 +33,7 @@ void CryptoEngine::generateKeyPair(uint8_t *pubKey, uint8_t *privKey)
 
     LOG_DEBUG("Generate Curve25519 keypair");
     Curve25519::dh1(public_key, private_key);
+    clearSharedKeyCache();
     memcpy(pubKey, public_key, sizeof(public_key));
     memcpy(privKey, private_key, sizeof(private_key));
 }
@@ -54,6 +55,7 @@ bool CryptoEngine::regeneratePublicKey(uint8_t *pubKey, uint8_t *privKey)
         }
         memcpy(private_key, privKey, sizeof(private_key));
         memcpy(public_key, pubKey, sizeof(public_key));
+        clearSharedKeyCache();
     } else {
         LOG_WARN("X25519 key generation failed due to blank private key");
         return false;
@@ -65,6 +67,40 @@ void CryptoEngine::clearKeys()
 {
     memset(public_key, 0, sizeof(public_key));
     memset(private_key, 0, sizeof(private_key));
+    clearSharedKeyCache();
+}
+
+void CryptoEngine::clearSharedKeyCache()
+{
+    memset(sharedKeyCache, 0, sizeof(sharedKeyCache));
+    sharedKeyClock = 0;
+    clearKeySchedules(); // Expanded copies of the same keys
+}
+
+bool CryptoEngine::setSharedKey(uint8_t *pubKey)
+{
+    SharedKeyCacheEntry *victim = &sharedKeyCache[0];
+    for (auto &e : sharedKeyCache) {
+        if (e.lastUsed && memcmp(e.publicKey, pubKey, 32) == 0) {
+            e.lastUsed = ++sharedKeyClock;
+            memcpy(shared_key, e.sharedKey, 32);
+            sharedKeyHits++;
+            return true;
+        }
+        if (e.lastUsed < victim->lastUsed)
+            victim = &e;
+    }
+
+    sharedKeyMisses++;
+    if (!crypto->setDHPublicKey(pubKey)) {
+        return false;
+    }
+    crypto->hash(shared_key, 32);
+
+    memcpy(victim->publicKey, pubKey, 32);
+    memcpy(victim->sharedKey, shared_key, 32);
+    victim->lastUsed = ++sharedKeyClock;
+    return true;
 }
 
 /**
@@ -92,10 +128,9 @@ bool CryptoEngine::encryptCurve25519(uint32_t toNode, uint32_t fromNode, meshtas
         LOG_DEBUG("Node %d or their public_key not found", toNode);
         return false;
     }
-    if (!crypto->setDHPublicKey(remotePublic.bytes)) {
+    if (!setSharedKey(remotePublic.bytes)) {
         return false;
     }
-    crypto->hash(shared_key, 32);
     initNonce(fromNode, packetNum, extraNonceTmp);
 
     // Calculate the shared secret with the destination node and encrypt
@@ -134,10 +169,9 @@ bool CryptoEngine::decryptCurve25519(uint32_t fromNode, meshtastic_UserLite_publ
     }
 
     // Calculate the shared secret with the sending node and decrypt
-    if (!crypto->setDHPublicKey(remotePublic.bytes)) {
+    if (!setSharedKey(remotePublic.bytes)) {
         return false;
     }
-    crypto->hash(shared_key, 32);
 
     initNonce(fromNode, packetNum, extraNonce);
     printBytes("Attempt decrypt with nonce: ", nonce, 13);
@@ -147,6 +181,8 @@ bool CryptoEngine::decryptCurve25519(uint32_t fromNode, meshtastic_UserLite_publ
 
 void CryptoEngine::setDHPrivateKey(uint8_t *_private_key)
 {
+    if (memcmp(private_key, _private_key, 32) != 0)
+        clearSharedKeyCache();
     memcpy(private_key, _private_key, 32);
 }
 
@@ -174,12 +210,7 @@ void CryptoEngine::hash(uint8_t *bytes, size_t numBytes)
 
 void CryptoEngine::aesSetKey(const uint8_t *key_bytes, size_t key_len)
 {
-    delete aes;
-    aes = nullptr;
-    if (key_len != 0) {
-        aes = new AESSmall256();
-        aes->setKey(key_bytes, key_len);
-    }
+    aes = key_len ? getKeySchedule(key_bytes, key_len) : nullptr;
 }
 
 void CryptoEngine::aesEncrypt(uint8_t *in, uint8_t *out)
@@ -236,21 +267,94 @@ void CryptoEngine::decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes
 // Generic implementation of AES-CTR encryption.
 void CryptoEngine::encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, uint8_t *bytes)
 {
-    delete ctr;
-    ctr = nullptr;
-    if (_key.length == 16)
-        ctr = new CTR<AES128>();
-    else
-        ctr = new CTR<AES256>();
-    ctr->setKey(_key.bytes, _key.length);
-    static uint8_t scratch[MAX_BLOCKSIZE];
-    memcpy(scratch, bytes, numBytes);
-    memset(scratch + numBytes, 0,
-           sizeof(scratch) - numBytes); // Fill rest of buffer with zero (in case cypher looks at it)
-
-    ctr->setIV(_nonce, 16);
-    ctr->setCounterSize(4);
-    ctr->encrypt(bytes, scratch, numBytes);
+    uint8_t counter[16];
+    memcpy(counter, _nonce, sizeof(counter));
+    getKeySchedule(_key.bytes, _key.length)->ctr(counter, 4, numBytes, bytes);
+}
+
+/// Count one block on, in the last counterSize bytes of counter (big endian)
+static void incrementCounter(uint8_t *counter, size_t counterSize)
+{
+    for (int i = 15; i >= 16 - (int)counterSize; i--)
+        if (++counter[i] != 0)
+            break;
+}
+
+void AESKeySchedule::ctr(uint8_t *counter, size_t counterSize, size_t numBytes, uint8_t *bytes)
+{
+    uint32_t stream[4], block[4];
+    while (numBytes >= 16) {
+        encryptBlock((uint8_t *)stream, counter);
+        incrementCounter(counter, counterSize);
+        memcpy(block, bytes, 16);
+        for (uint8_t i = 0; i < 4; i++)
+            block[i] ^= stream[i];
+        memcpy(bytes, block, 16);
+        bytes += 16;
+        numBytes -= 16;
+    }
+    if (numBytes) {
+        encryptBlock((uint8_t *)stream, counter);
+        incrementCounter(counter, counterSize);
+        for (size_t i = 0; i < numBytes; i++)
+            bytes[i] ^= ((uint8_t *)stream)[i];
+    }
+}
+
+/// Key schedule of the portable AES in the Crypto library
+template <class Cipher> class SoftwareAESKeySchedule : public AESKeySchedule
+{
+    Cipher cipher;
+
+  public:
+    virtual void setKey(const uint8_t *key, size_t keyLen) override { cipher.setKey(key, keyLen); }
+    virtual void encryptBlock(uint8_t *out, const uint8_t *in) override { cipher.encryptBlock(out, in); }
+};
+
+AESKeySchedule *CryptoEngine::newKeySchedule(size_t keyLen)
+{
+    if (keyLen == 16)
+        return new SoftwareAESKeySchedule<AES128>();
+    return new SoftwareAESKeySchedule<AES256>();
+}
+
+AESKeySchedule *CryptoEngine::getKeySchedule(const uint8_t *keyBytes, size_t keyLen)
+{
+    KeyScheduleSlot *victim = &keySchedules[0];
+    for (auto &slot : keySchedules) {
+        if (slot.lastUsed && slot.keyLen == keyLen && memcmp(slot.key, keyBytes, keyLen) == 0) {
+            slot.lastUsed = ++keyScheduleClock;
+            keyScheduleHits++;
+            return slot.schedule;
+        }
+        if (slot.lastUsed < victim->lastUsed)
+            victim = &slot;
+    }
+
+    keyScheduleMisses++;
+    if (victim->schedule && victim->keyLen != keyLen) {
+        delete victim->schedule;
+        victim->schedule = nullptr;
+    }
+    if (!victim->schedule)
+        victim->schedule = newKeySchedule(keyLen);
+    victim->schedule->setKey(keyBytes, keyLen);
+    memcpy(victim->key, keyBytes, keyLen);
+    victim->keyLen = keyLen;
+    victim->lastUsed = ++keyScheduleClock;
+    return victim->schedule;
+}
+
+void CryptoEngine::clearKeySchedules()
+{
+    for (auto &slot : keySchedules) {
+        delete slot.schedule; // Their destructors wipe the expanded keys
+        memset(&slot, 0, sizeof(slot));
+    }
+    keyScheduleClock = 0;
+#if !(MESHTASTIC_EXCLUDE_PKI)
+    aes = nullptr;
+#endif
 }
 
 /**
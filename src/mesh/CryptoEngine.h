@@ -1,6 +1,5 @@
 #pragma once
 #include "AES.h"
-#include "CTR.h"
 #include "concurrency/LockGuard.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
@@ -23,6 +22,39 @@ struct CryptoKey {
 #define MAX_BLOCKSIZE 256
 #define TEST_CURVE25519_FIELD_OPS // Exposes Curve25519::isWeakPoint() for testing keys
 
+#ifndef PKI_SHARED_KEY_CACHE_SIZE
+#define PKI_SHARED_KEY_CACHE_SIZE 8 // Peers whose derived PKI keys we keep, 64 bytes of RAM each
+#endif
+
+#ifndef AES_KEY_SCHEDULE_CACHE_SIZE
+#if !(MESHTASTIC_EXCLUDE_PKI)
+#define AES_KEY_SCHEDULE_CACHE_SIZE (MAX_NUM_CHANNELS + PKI_SHARED_KEY_CACHE_SIZE)
+#else
+#define AES_KEY_SCHEDULE_CACHE_SIZE MAX_NUM_CHANNELS
+#endif
+#endif
+
+/**
+ * An AES key expanded by one particular AES implementation, ready to encrypt any number of blocks without setting the key
+ * up again. CryptoEngine keeps these for the keys it uses over and over: channel PSKs, tried on every packet we hear, and
+ * the shared keys of the PKI peers we talk to.
+ */
+class AESKeySchedule
+{
+  public:
+    virtual ~AESKeySchedule() {}
+
+    virtual void setKey(const uint8_t *key, size_t keyLen) = 0;
+    virtual void encryptBlock(uint8_t *out, const uint8_t *in) = 0;
+
+    /**
+     * CTR mode over a whole packet: XOR bytes in place with the key stream, a 16 byte block at a time.
+     *
+     * The last counterSize bytes of counter count blocks, big endian. counter is left at the block after the last one used.
+     */
+    virtual void ctr(uint8_t *counter, size_t counterSize, size_t numBytes, uint8_t *bytes);
+};
+
 class CryptoEngine
 {
   public:
@@ -30,7 +62,7 @@ class CryptoEngine
     uint8_t public_key[32] = {0};
 #endif
 
-    virtual ~CryptoEngine() {}
+    virtual ~CryptoEngine() { clearKeySchedules(); }
 #if !(MESHTASTIC_EXCLUDE_PKI)
 #if !(MESHTASTIC_EXCLUDE_PKI_KEYGEN)
     virtual void generateKeyPair(uint8_t *pubKey, uint8_t *privKey);
@@ -46,10 +78,16 @@ class CryptoEngine
     virtual bool setDHPublicKey(uint8_t *publicKey);
     virtual void hash(uint8_t *bytes, size_t numBytes);
 
+    /// Forget every cached shared key, done whenever our own private key changes
+    void clearSharedKeyCache();
+    uint32_t getSharedKeyHits() const { return sharedKeyHits; }
+    uint32_t getSharedKeyMisses() const { return sharedKeyMisses; }
+
+    /// Use key for aesEncrypt(), until the next call
     virtual void aesSetKey(const uint8_t *key, size_t key_len);
 
     virtual void aesEncrypt(uint8_t *in, uint8_t *out);
-    AESSmall256 *aes = NULL;
+    AESKeySchedule *aes = NULL;
 
 #endif
 
@@ -72,16 +110,56 @@ class CryptoEngine
     virtual void encryptPacket(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes);
     virtual void decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes);
     virtual void encryptAESCtr(CryptoKey key, uint8_t *nonce, size_t numBytes, uint8_t *bytes);
+
+    /**
+     * The schedule for key, expanded again only if key has not been used lately. It stays valid while the same key is in
+     * use, so get it once per packet rather than keeping it.
+     */
+    AESKeySchedule *getKeySchedule(const uint8_t *key, size_t keyLen);
+    /// Forget every expanded key
+    void clearKeySchedules();
+    uint32_t getKeyScheduleHits() const { return keyScheduleHits; }
+    uint32_t getKeyScheduleMisses() const { return keyScheduleMisses; }
 #ifndef PIO_UNIT_TESTING
   protected:
 #endif
     /** Our per packet nonce */
     uint8_t nonce[16] = {0};
     CryptoKey key = {};
-    CTRCommon *ctr = NULL;
+
+    /// A new, empty, schedule for keys of keyLen bytes. Subclasses return one for their own AES implementation
+    virtual AESKeySchedule *newKeySchedule(size_t keyLen);
+
+    // Least recently used keys get their slot, and their schedule object if the key length matches, taken over
+    struct KeyScheduleSlot {
+        uint8_t key[32];
+        uint8_t keyLen;
+        uint32_t lastUsed; // 0 for an empty slot
+        AESKeySchedule *schedule;
+    };
+    KeyScheduleSlot keySchedules[AES_KEY_SCHEDULE_CACHE_SIZE] = {};
+    uint32_t keyScheduleClock = 0;
+    uint32_t keyScheduleHits = 0, keyScheduleMisses = 0;
 #if !(MESHTASTIC_EXCLUDE_PKI)
     uint8_t shared_key[32] = {0};
     uint8_t private_key[32] = {0};
+
+    /**
+     * The X25519 exchange behind every PKI packet takes milliseconds on nRF52 and RP2040, and DMs and admin sessions
+     * tend to go back and forth with the same few peers. So the SHA256 of each shared secret is kept, by peer public key,
+     * and the least recently used one is replaced. A peer rotating its key just shows up as a new public key.
+     */
+    struct SharedKeyCacheEntry {
+        uint8_t publicKey[32];
+        uint8_t sharedKey[32];
+        uint32_t lastUsed; // 0 for an empty slot
+    };
+    SharedKeyCacheEntry sharedKeyCache[PKI_SHARED_KEY_CACHE_SIZE] = {};
+    uint32_t sharedKeyClock = 0;
+    uint32_t sharedKeyHits = 0, sharedKeyMisses = 0;
+
+    /// Set shared_key to the hashed secret shared with the owner of pubKey, @return false for an unusable key
+    bool setSharedKey(uint8_t *pubKey);
 #endif
     /**
      * Init our 128 bit nonce for a new packet
@@ -0,0 +1,155 @@
+#include "LatencyStats.h"
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+#include "DebugConfiguration.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+LatencyStats latencyStats;
+
+void LatencyHistogram::record(uint32_t us)
+{
+    uint8_t i = 0;
+    while (i < NUM_BUCKETS - 1 && us >= bucketLimitUs(i))
+        i++;
+    buckets[i]++;
+    count++;
+    totalUs += us;
+    if (us > maxUs)
+        maxUs = us;
+}
+
+uint32_t LatencyHistogram::bucketLimitUs(uint8_t i)
+{
+    return i < NUM_BUCKETS - 1 ? 1UL << (i + 3) : UINT32_MAX;
+}
+
+uint32_t LatencyHistogram::percentileUs(uint8_t percent) const
+{
+    if (!count)
+        return 0;
+
+    uint64_t wanted = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (uint8_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= wanted)
+            return std::min(bucketLimitUs(i), maxUs);
+    }
+    return maxUs;
+}
+
+void LatencyStats::recordModule(int8_t &slot, const char *name, uint32_t us)
+{
+    if (slot < 0) {
+        if (numModules >= MAX_MODULES)
+            return;
+        slot = numModules++;
+        modules[slot].name = name;
+    }
+
+    ModuleStats &m = modules[slot];
+    m.count++;
+    m.totalUs += us;
+    if (us > m.maxUs)
+        m.maxUs = us;
+}
+
+const char *LatencyStats::probeName(LatencyProbe probe)
+{
+    switch (probe) {
+    case LATENCY_RADIO_ISR:
+        return "radio_isr";
+    case LATENCY_RX_ENQUEUE:
+        return "rx_enqueue";
+    case LATENCY_DECODE:
+        return "decode";
+    case LATENCY_HISTORY_LOOKUP:
+        return "history_lookup";
+    case LATENCY_CALL_MODULES:
+        return "call_modules";
+    case LATENCY_TX_QUEUE_WAIT:
+        return "tx_queue_wait";
+    case LATENCY_CONFIG_COMPLETE:
+        return "config_complete";
+    case LATENCY_DISPLAY_FRAME:
+        return "display_frame";
+    default:
+        return "unknown";
+    }
+}
+
+void LatencyStats::reset()
+{
+    for (auto &p : probes)
+        p = LatencyHistogram();
+    // Keep the module slots, modules have them cached
+    for (uint8_t i = 0; i < numModules; i++) {
+        modules[i].count = 0;
+        modules[i].maxUs = 0;
+        modules[i].totalUs = 0;
+    }
+}
+
+void LatencyStats::toJson(std::string &out) const
+{
+    char buf[96];
+
+    out += "{\"bucket_limits_us\":[";
+    for (uint8_t i = 0; i < LatencyHistogram::NUM_BUCKETS - 1; i++) {
+        snprintf(buf, sizeof(buf), "%s%lu", i ? "," : "", (unsigned long)LatencyHistogram::bucketLimitUs(i));
+        out += buf;
+    }
+    out += "],\"probes\":{";
+
+    for (uint8_t p = 0; p < LATENCY_NUM_PROBES; p++) {
+        const LatencyHistogram &h = probes[p];
+        snprintf(buf, sizeof(buf), "%s\"%s\":{\"count\":%lu,\"total_us\":%llu,\"max_us\":%lu,\"buckets\":[", p ? "," : "",
+                 probeName((LatencyProbe)p), (unsigned long)h.count, (unsigned long long)h.totalUs, (unsigned long)h.maxUs);
+        out += buf;
+        for (uint8_t i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+            snprintf(buf, sizeof(buf), "%s%lu", i ? "," : "", (unsigned long)h.buckets[i]);
+            out += buf;
+        }
+        out += "]}";
+    }
+    out += "},\"modules\":{";
+
+    for (uint8_t i = 0; i < numModules; i++) {
+        const ModuleStats &m = modules[i];
+        snprintf(buf, sizeof(buf), "%s\"%s\":{\"count\":%lu,\"total_us\":%llu,\"max_us\":%lu}", i ? "," : "", m.name,
+                 (unsigned long)m.count, (unsigned long long)m.totalUs, (unsigned long)m.maxUs);
+        out += buf;
+    }
+    out += "}}";
+}
+
+void LatencyStats::logSummary() const
+{
+    for (uint8_t p = 0; p < LATENCY_NUM_PROBES; p++) {
+        const LatencyHistogram &h = probes[p];
+        if (h.count)
+            LOG_INFO("Latency %s: n=%u, mean=%uus, p95<=%uus, max=%uus", probeName((LatencyProbe)p), h.count,
+                     (uint32_t)(h.totalUs / h.count), h.percentileUs(95), h.maxUs);
+    }
+
+    // Only the worst few modules, by mean time per packet
+    const uint8_t numToLog = 3;
+    bool logged[MAX_MODULES] = {};
+    for (uint8_t n = 0; n < numToLog; n++) {
+        int8_t worst = -1;
+        for (uint8_t i = 0; i < numModules; i++) {
+            if (logged[i] || !modules[i].count)
+                continue;
+            if (worst < 0 ||
+                modules[i].totalUs * modules[worst].count > modules[worst].totalUs * modules[i].count) // compare means
+                worst = i;
+        }
+        if (worst < 0)
+            break;
+        logged[worst] = true;
+        const ModuleStats &m = modules[worst];
+        LOG_INFO("Latency module %s: n=%u, mean=%uus, max=%uus", m.name, m.count, (uint32_t)(m.totalUs / m.count), m.maxUs);
+    }
+}
+#endif
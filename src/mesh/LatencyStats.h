@@ -0,0 +1,107 @@
+#pragma once
+
+#include "configuration.h"
+#include <Arduino.h>
+#include <string>
+
+/**
+ * Timing probes along the packet path, from the radio IRQ to module delivery and through the TX queue, plus the client API
+ * config handshake and TFT frame pushes.
+ *
+ * Each probe feeds a fixed bucket histogram (log2 of the duration in microseconds), and every module handling a packet feeds
+ * a count/total/max summary. Recording is a micros() call and a few increments and never allocates. The probes compile away
+ * with MESHTASTIC_EXCLUDE_LATENCY_PROBES.
+ *
+ * Results are served as JSON at /json/latency by the web servers and logged with every LocalStats telemetry.
+ */
+
+enum LatencyProbe {
+    LATENCY_RADIO_ISR,       // Radio IRQ until the radio thread handles it
+    LATENCY_RX_ENQUEUE,      // Router::enqueueReceivedMessage
+    LATENCY_DECODE,          // perhapsDecode, including the trial decryptions
+    LATENCY_HISTORY_LOOKUP,  // PacketHistory::wasSeenRecently
+    LATENCY_CALL_MODULES,    // MeshModule::callModules, all modules together
+    LATENCY_TX_QUEUE_WAIT,   // Time a packet spends in the TX queue
+    LATENCY_CONFIG_COMPLETE, // PhoneAPI want_config_id until config_complete_id, the whole client handshake
+    LATENCY_DISPLAY_FRAME,   // TFTDisplay::display, diffing and pushing one frame to the panel
+    LATENCY_NUM_PROBES
+};
+
+class LatencyHistogram
+{
+  public:
+    /// Bucket i counts durations below 2^(i + 3) us, the last one everything from ~2 s up
+    static const uint8_t NUM_BUCKETS = 20;
+
+    uint32_t count = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+    uint32_t buckets[NUM_BUCKETS] = {};
+
+    void record(uint32_t us);
+
+    /// @return the upper bound of bucket i in us, UINT32_MAX for the last bucket
+    static uint32_t bucketLimitUs(uint8_t i);
+
+    /// @return an estimate of the given percentile (0-100), the upper bound of the bucket it falls in
+    uint32_t percentileUs(uint8_t percent) const;
+};
+
+class LatencyStats
+{
+  public:
+    static const uint8_t MAX_MODULES = 48;
+
+    struct ModuleStats {
+        const char *name;
+        uint32_t count;
+        uint32_t maxUs;
+        uint64_t totalUs;
+    };
+
+    void record(LatencyProbe probe, uint32_t us) { probes[probe].record(us); }
+
+    /** Record time spent by one module
+     * @param slot cached by the caller, -1 the first time. Stays -1 if the module table is full. */
+    void recordModule(int8_t &slot, const char *name, uint32_t us);
+
+    const LatencyHistogram &get(LatencyProbe probe) const { return probes[probe]; }
+    static const char *probeName(LatencyProbe probe);
+
+    void reset();
+
+    /// Append all histograms and module summaries to out, as a JSON object
+    void toJson(std::string &out) const;
+
+    /// Log count/mean/p95/max of every probe and the slowest modules
+    void logSummary() const;
+
+  private:
+    LatencyHistogram probes[LATENCY_NUM_PROBES];
+    ModuleStats modules[MAX_MODULES] = {};
+    uint8_t numModules = 0;
+};
+
+extern LatencyStats latencyStats;
+
+/// Records the lifetime of the enclosing scope to a probe
+class LatencyScope
+{
+  public:
+    explicit LatencyScope(LatencyProbe probe) : probe(probe), start(micros()) {}
+    ~LatencyScope() { latencyStats.record(probe, micros() - start); }
+
+  private:
+    LatencyProbe probe;
+    uint32_t start;
+};
+
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+#define LATENCY_CONCAT2(a, b) a##b
+#define LATENCY_CONCAT(a, b) LATENCY_CONCAT2(a, b)
+#define LATENCY_SCOPE(probe) LatencyScope LATENCY_CONCAT(latencyScope, __LINE__)(probe)
+#define LATENCY_RECORD(probe, us) latencyStats.record(probe, us)
+#else
+#define LATENCY_SCOPE(probe)
+#define LATENCY_RECORD(probe, us)
+#endif
@@ -2,11 +2,28 @@
 
 #include <Arduino.h>
 #include <assert.h>
+#include <atomic>
 #include <functional>
 #include <memory>
 
 #include "PointerQueue.h"
 
+// MemoryPool's free stack needs a lock-free 32 bit compare and swap to be ISR safe. Cortex-M0+ (RP2040) has no exclusive
+// load/store so its atomics are library calls, targets like that keep heap backed pools.
+#if ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_SHORT_LOCK_FREE == 2
+#define HAS_LOCK_FREE_POOL 1
+#else
+#define HAS_LOCK_FREE_POOL 0
+#endif
+
+/// Usage counters kept by every allocator, so pools can be sized per board
+struct AllocatorStats {
+    uint32_t capacity;  // Number of preallocated objects, 0 for heap backed allocators
+    uint32_t inUse;     // Objects currently handed out
+    uint32_t highWater; // Highest inUse seen since boot
+    uint32_t failed;    // Allocations the preallocated objects could not satisfy
+};
+
 template <class T> class Allocator
 {
 
@@ -15,7 +32,7 @@ template <class T> class Allocator
     virtual ~Allocator() {}
 
     /// Return a queable object which has been prefilled with zeros.  Panic if no buffer is available
-    /// Note: this method is safe to call from regular OR ISR code
+    /// Note: this may fall back to the heap, ISR code must use allocZeroedFromISR()
     T *allocZeroed()
     {
         T *p = allocZeroed(0);
@@ -35,6 +52,17 @@ template <class T> class Allocator
         return p;
     }
 
+    /// Return a queable object which has been prefilled with zeros, or NULL if none is free. Never touches the heap, so
+    /// this is safe to call from ISR code
+    T *allocZeroedFromISR()
+    {
+        T *p = allocFromISR();
+
+        if (p)
+            memset(p, 0, sizeof(T));
+        return p;
+    }
+
     /// Return a queable object which is a copy of some other object
     T *allocCopy(const T &src, TickType_t maxWait = portMAX_DELAY)
     {
@@ -65,13 +93,40 @@ template <class T> class Allocator
     /// Return a buffer for use by others
     virtual void release(T *p) = 0;
 
+    /// Current usage counters. Note: this method is safe to call from regular OR ISR code
+    virtual AllocatorStats getStats()
+    {
+        return AllocatorStats{0, inUse.load(std::memory_order_relaxed), highWater.load(std::memory_order_relaxed),
+                              failed.load(std::memory_order_relaxed)};
+    }
+
   protected:
     // Alloc some storage
     virtual T *alloc(TickType_t maxWait) = 0;
 
+    // Alloc some storage without using the heap, heap backed allocators have nothing to offer an ISR
+    virtual T *allocFromISR()
+    {
+        countFailed();
+        return NULL;
+    }
+
+    // Book keeping for getStats(), lock-free so subclasses can call them from ISRs
+    void countAlloc()
+    {
+        uint32_t now = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        uint32_t high = highWater.load(std::memory_order_relaxed);
+        while (now > high && !highWater.compare_exchange_weak(high, now, std::memory_order_relaxed))
+            ;
+    }
+    void countRelease() { inUse.fetch_sub(1, std::memory_order_relaxed); }
+    void countFailed() { failed.fetch_add(1, std::memory_order_relaxed); }
+
   private:
     // std::unique_ptr Deleter function; calls release().
     const std::function<void(T *)> deleter;
+
+    std::atomic<uint32_t> inUse{0}, highWater{0}, failed{0};
 };
 
 /**
@@ -85,6 +140,7 @@ template <class T> class MemoryDynamic : public Allocator<T>
     {
         assert(p);
         free(p);
+        this->countRelease();
     }
 
   protected:
@@ -93,6 +149,117 @@ template <class T> class MemoryDynamic : public Allocator<T>
     {
         T *p = (T *)malloc(sizeof(T));
         assert(p);
+        if (p)
+            this->countAlloc();
+        else
+            this->countFailed();
         return p;
     }
 };
+
+/**
+ * A fixed capacity slab allocator
+ *
+ * All objects come from one array allocated in the constructor, so a long running node never fragments its heap with
+ * packet sized holes. Free slots are kept on a lock-free stack whose head packs the slot index with a change counter
+ * (so a pop racing with a pop+push from an ISR can't corrupt it), which makes alloc and release safe from ISRs.
+ *
+ * If every slot is in use we fall back to malloc and count a failed allocation instead of panicking, so an undersized
+ * pool shows up in getStats() rather than as a crash in the field. allocZeroedFromISR() never falls back, it returns NULL.
+ */
+template <class T> class MemoryPool : public Allocator<T>
+{
+    static constexpr uint16_t NO_SLOT = UINT16_MAX;
+
+    size_t capacity;
+    T *slab;
+    std::atomic<uint16_t> *nextFree; // Free stack links, one per slot
+    std::atomic<uint32_t> head;      // (change counter << 16) | top slot of the free stack
+
+  public:
+    explicit MemoryPool(size_t _capacity) : capacity(_capacity < NO_SLOT ? _capacity : NO_SLOT - 1), head(NO_SLOT)
+    {
+        slab = capacity ? (T *)malloc(sizeof(T) * capacity) : NULL;
+        nextFree = slab ? new std::atomic<uint16_t>[capacity] : NULL;
+        if (!slab || !nextFree) {
+            capacity = 0; // Every allocation will use the heap fallback
+            return;
+        }
+
+        for (size_t i = 0; i < capacity; i++)
+            nextFree[i].store(i + 1 < capacity ? i + 1 : NO_SLOT, std::memory_order_relaxed);
+        head.store(0, std::memory_order_release);
+    }
+
+    ~MemoryPool()
+    {
+        free(slab);
+        delete[] nextFree;
+    }
+
+    /// Return a buffer for use by others
+    virtual void release(T *p) override
+    {
+        assert(p);
+        if (p < slab || p >= slab + capacity) {
+            free(p); // Came from the heap fallback
+            this->countRelease();
+            return;
+        }
+
+        uint16_t slot = p - slab;
+        uint32_t old = head.load(std::memory_order_relaxed);
+        do {
+            nextFree[slot].store(old & 0xffff, std::memory_order_relaxed);
+        } while (!head.compare_exchange_weak(old, ((old + 0x10000) & 0xffff0000) | slot, std::memory_order_release,
+                                             std::memory_order_relaxed));
+        this->countRelease();
+    }
+
+    virtual AllocatorStats getStats() override
+    {
+        AllocatorStats stats = Allocator<T>::getStats();
+        stats.capacity = capacity;
+        return stats;
+    }
+
+  protected:
+    // Alloc some storage, never blocks so maxWait is ignored
+    virtual T *alloc(TickType_t maxWait) override
+    {
+        T *p = popSlot();
+        if (p)
+            return p;
+
+        this->countFailed();
+        p = (T *)malloc(sizeof(T));
+        assert(p);
+        if (p)
+            this->countAlloc();
+        return p;
+    }
+
+    virtual T *allocFromISR() override
+    {
+        T *p = popSlot();
+        if (!p)
+            this->countFailed();
+        return p;
+    }
+
+  private:
+    /// Take a slot off the free stack, @return NULL if the slab is exhausted
+    T *popSlot()
+    {
+        uint32_t old = head.load(std::memory_order_acquire);
+        while ((old & 0xffff) != NO_SLOT) {
+            uint16_t slot = old & 0xffff;
+            uint32_t next = ((old + 0x10000) & 0xffff0000) | nextFree[slot].load(std::memory_order_relaxed);
+            if (head.compare_exchange_weak(old, next, std::memory_order_acquire, std::memory_order_acquire)) {
+                this->countAlloc();
+                return &slab[slot];
+            }
+        }
+        return NULL;
+    }
+};
@@ -1,5 +1,6 @@
 #include "MeshModule.h"
 #include "Channels.h"
+#include "LatencyStats.h"
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "configuration.h"
@@ -9,6 +10,11 @@
 
 std::vector<MeshModule *> *MeshModule::modules;
 
+std::map<meshtastic_PortNum, std::vector<MeshModule *>> MeshModule::portModules;
+std::vector<MeshModule *> MeshModule::anyPortModules;
+std::vector<MeshModule *> MeshModule::encryptedModules;
+bool MeshModule::dispatchDirty = true;
+
 const meshtastic_MeshPacket *MeshModule::currentRequest;
 uint8_t MeshModule::numPeriodicModules = 0;
 
@@ -25,6 +31,7 @@ MeshModule::MeshModule(const char *_name) : name(_name)
         modules = new std::vector<MeshModule *>();
 
     modules->push_back(this);
+    dispatchDirty = true;
 }
 
 void MeshModule::setup() {}
@@ -34,6 +41,52 @@ MeshModule::~MeshModule()
     auto it = std::find(modules->begin(), modules->end(), this);
     assert(it != modules->end());
     modules->erase(it);
+    dispatchDirty = true;
+}
+
+void MeshModule::buildDispatch()
+{
+    portModules.clear();
+    anyPortModules.clear();
+    encryptedModules.clear();
+
+    std::vector<std::vector<meshtastic_PortNum>> wanted(modules->size());
+    std::vector<bool> anyPort(modules->size());
+    for (size_t i = 0; i < modules->size(); i++) {
+        MeshModule *m = (*modules)[i];
+        anyPort[i] = !m->getWantedPortNums(wanted[i]);
+        if (anyPort[i])
+            anyPortModules.push_back(m);
+        if (m->encryptedOk)
+            encryptedModules.push_back(m);
+        for (auto port : wanted[i])
+            portModules[port]; // Create the list, filled below
+    }
+
+    // Second pass so each port list is in registration order, with the any port modules merged in
+    for (auto &it : portModules) {
+        for (size_t i = 0; i < modules->size(); i++) {
+            if (anyPort[i] || std::find(wanted[i].begin(), wanted[i].end(), it.first) != wanted[i].end())
+                it.second.push_back((*modules)[i]);
+        }
+    }
+
+    dispatchDirty = false;
+    LOG_DEBUG("Module dispatch: %u modules, %u portnums, %u for any portnum, %u take encrypted packets",
+              (uint32_t)modules->size(), (uint32_t)portModules.size(), (uint32_t)anyPortModules.size(),
+              (uint32_t)encryptedModules.size());
+}
+
+const std::vector<MeshModule *> &MeshModule::modulesFor(const meshtastic_MeshPacket &mp)
+{
+    if (dispatchDirty)
+        buildDispatch();
+
+    if (mp.which_payload_variant != meshtastic_MeshPacket_decoded_tag)
+        return encryptedModules;
+
+    auto it = portModules.find(mp.decoded.portnum);
+    return it != portModules.end() ? it->second : anyPortModules;
 }
 
 // ⚠️ **Only call once** to set the initial delay before a module starts broadcasting periodically
@@ -87,6 +140,7 @@ meshtastic_MeshPacket *MeshModule::allocErrorResponse(meshtastic_Routing_Error e
 
 void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
 {
+    LATENCY_SCOPE(LATENCY_CALL_MODULES);
     // LOG_DEBUG("In call modules");
     bool moduleFound = false;
 
@@ -101,7 +155,8 @@ void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
     auto ourNodeNum = nodeDB->getNodeNum();
     bool toUs = isBroadcast(mp.to) || isToUs(&mp);
 
-    for (auto i = modules->begin(); i != modules->end(); ++i) {
+    const std::vector<MeshModule *> &candidates = modulesFor(mp);
+    for (auto i = candidates.begin(); i != candidates.end(); ++i) {
         auto &pi = **i;
 
         pi.currentRequest = &mp;
@@ -142,6 +197,9 @@ void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
                 } else
                     printPacket("packet on wrong channel, but can't respond", &mp);
             } else {
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+                uint32_t moduleStart = micros();
+#endif
                 ProcessMessage handled = pi.handleReceived(mp);
 
                 pi.alterReceived(mp);
@@ -168,6 +226,9 @@ void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
                     packetPool.release(pi.myReply);
                     pi.myReply = NULL;
                 }
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+                latencyStats.recordModule(pi.latencySlot, pi.name, micros() - moduleStart);
+#endif
 
                 if (handled == ProcessMessage::STOP) {
                     LOG_DEBUG("Module '%s' handled and skipped other processing", pi.name);
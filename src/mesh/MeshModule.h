@@ -2,6 +2,7 @@
 
 #include "mesh/Channels.h"
 #include "mesh/MeshTypes.h"
+#include <map>
 #include <vector>
 
 #if HAS_SCREEN
@@ -63,6 +64,19 @@ class MeshModule
 {
     static std::vector<MeshModule *> *modules;
 
+    /** Dispatch index for callModules, so a packet only reaches modules that can want its portnum.
+     * Every list keeps registration order, and the port lists already include the anyPortModules. */
+    static std::map<meshtastic_PortNum, std::vector<MeshModule *>> portModules;
+    static std::vector<MeshModule *> anyPortModules;   // Modules that may want any portnum
+    static std::vector<MeshModule *> encryptedModules; // Modules with encryptedOk, the only ones that see undecoded packets
+    static bool dispatchDirty;                         // Modules were added or removed since the index was built
+
+    /// Rebuild the dispatch index. Done lazily, derived constructors set ourPortNum and flags after we are registered.
+    static void buildDispatch();
+
+    /// @return the modules callModules must consider for this packet
+    static const std::vector<MeshModule *> &modulesFor(const meshtastic_MeshPacket &mp);
+
   public:
     /** Constructor
      * name is for debugging output
@@ -88,6 +102,9 @@ class MeshModule
   protected:
     const char *name;
 
+    /// Our entry in the latency stats module table, -1 until we first handle a packet
+    int8_t latencySlot = -1;
+
     /** Most modules only care about packets that are destined for their node (i.e. broadcasts or has their node as the specific
     recipient) But some plugs might want to 'sniff' packets that are merely being routed (passing through the current node). Those
     modules can set this to true and their handleReceived() will be called for every packet.
@@ -144,6 +161,11 @@ class MeshModule
      */
     virtual bool wantPacket(const meshtastic_MeshPacket *p) = 0;
 
+    /** Used to build the callModules dispatch index: add every portnum wantPacket() could return true for.
+     * @return false if wantPacket() might accept any portnum, then it is called for every decoded packet.
+     * The answer must not change after construction. Override this together with wantPacket(). */
+    virtual bool getWantedPortNums(std::vector<meshtastic_PortNum> &portNums) { return false; }
+
     /** Called to handle a particular incoming message
 
     @return ProcessMessage::STOP if you've guaranteed you've handled this message and no other handlers should be considered for
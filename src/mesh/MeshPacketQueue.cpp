@@ -1,4 +1,5 @@
 #include "MeshPacketQueue.h"
+#include "LatencyStats.h"
 #include "NodeDB.h"
 #include "configuration.h"
 #include <assert.h>
@@ -28,11 +29,31 @@ bool CompareMeshPacketFunc(const meshtastic_MeshPacket *p1, const meshtastic_Mes
     return (p1p != p2p) ? (p1p > p2p) : (!isFromUs(p1) && isFromUs(p2));
 }
 
-MeshPacketQueue::MeshPacketQueue(size_t _maxLen) : maxLen(_maxLen) {}
+MeshPacketQueue::MeshPacketQueue(size_t _maxLen) : maxLen(_maxLen)
+{
+    if (maxLen >= NO_SLOT) {
+        LOG_WARN("TX queue length %d too large, clamped to %d", maxLen, NO_SLOT - 1);
+        maxLen = NO_SLOT - 1;
+    }
+
+    entries.resize(maxLen);
+    heap.reserve(maxLen);
+    for (size_t i = 0; i < maxLen; i++) {
+        entries[i].packet = NULL;
+        entries[i].next = (i + 1 < maxLen) ? i + 1 : NO_SLOT;
+    }
+    freeSlots = maxLen ? 0 : NO_SLOT;
+
+    // At least as many buckets as packets, so chains stay around one entry long
+    size_t numBuckets = 4;
+    while (numBuckets < maxLen)
+        numBuckets <<= 1;
+    buckets.assign(numBuckets, NO_SLOT);
+}
 
 bool MeshPacketQueue::empty()
 {
-    return queue.empty();
+    return heap.empty();
 }
 
 /**
@@ -68,7 +89,7 @@ void fixPriority(meshtastic_MeshPacket *p)
 bool MeshPacketQueue::enqueue(meshtastic_MeshPacket *p)
 {
     // no space - try to replace a lower priority packet in the queue
-    if (queue.size() >= maxLen) {
+    if (heap.size() >= maxLen) {
         bool replaced = replaceLowerPriorityPacket(p);
         if (!replaced) {
             LOG_WARN("TX queue is full, and there is no lower-priority packet available to evict in favour of 0x%08x", p->id);
@@ -76,9 +97,23 @@ bool MeshPacketQueue::enqueue(meshtastic_MeshPacket *p)
         return replaced;
     }
 
-    // Find the correct position using upper_bound to maintain a stable order
-    auto it = std::upper_bound(queue.begin(), queue.end(), p, CompareMeshPacketFunc);
-    queue.insert(it, p); // Insert packet at the found position
+    uint16_t slot = freeSlots;
+    Entry &e = entries[slot];
+    freeSlots = e.next;
+
+    e.packet = p;
+    e.from = getFrom(p);
+    e.seq = nextSeq++;
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+    e.enqueuedAt = micros();
+#endif
+    uint16_t &bucket = bucketFor(e.from, p->id);
+    e.next = bucket;
+    bucket = slot;
+
+    e.heapPos = heap.size();
+    heap.push_back(slot);
+    siftUp(e.heapPos);
     return true;
 }
 
@@ -88,9 +123,8 @@ meshtastic_MeshPacket *MeshPacketQueue::dequeue()
         return NULL;
     }
 
-    auto *p = queue.front();
-    queue.erase(queue.begin()); // Remove the highest-priority packet
-    return p;
+    LATENCY_RECORD(LATENCY_TX_QUEUE_WAIT, micros() - entries[heap.front()].enqueuedAt);
+    return removeAt(0); // Remove the highest-priority packet
 }
 
 meshtastic_MeshPacket *MeshPacketQueue::getFront()
@@ -99,35 +133,24 @@ meshtastic_MeshPacket *MeshPacketQueue::getFront()
         return NULL;
     }
 
-    auto *p = queue.front();
+    auto *p = entries[heap.front()].packet;
     return p;
 }
 
 /** Attempt to find and remove a packet from this queue.  Returns a pointer to the removed packet, or NULL if not found */
 meshtastic_MeshPacket *MeshPacketQueue::remove(NodeNum from, PacketId id, bool tx_normal, bool tx_late)
 {
-    for (auto it = queue.begin(); it != queue.end(); it++) {
-        auto p = (*it);
-        if (getFrom(p) == from && p->id == id && ((tx_normal && !p->tx_after) || (tx_late && p->tx_after))) {
-            queue.erase(it);
-            return p;
-        }
-    }
+    uint16_t slot = findSlot(from, id, tx_normal, tx_late);
+    if (slot == NO_SLOT)
+        return NULL;
 
-    return NULL;
+    return removeAt(entries[slot].heapPos);
 }
 
 /* Attempt to find a packet from this queue. Return true if it was found. */
 bool MeshPacketQueue::find(const NodeNum from, const PacketId id)
 {
-    for (auto it = queue.begin(); it != queue.end(); it++) {
-        const auto p = (*it);
-        if (getFrom(p) == from && p->id == id) {
-            return true;
-        }
-    }
-
-    return false;
+    return findSlot(from, id, true, true) != NO_SLOT;
 }
 
 /**
@@ -137,17 +160,18 @@ bool MeshPacketQueue::find(const NodeNum from, const PacketId id)
 bool MeshPacketQueue::replaceLowerPriorityPacket(meshtastic_MeshPacket *p)
 {
 
-    if (queue.empty()) {
+    if (empty()) {
         return false; // No packets to replace
     }
 
-    // Check if the packet at the back has a lower priority than the new packet
-    auto *backPacket = queue.back();
+    // Check if the packet at the back has a lower priority than the new packet.
+    // The heap only knows its front, but this only runs when the queue is full.
+    size_t backPos = findLast(false);
+    auto *backPacket = entries[heap[backPos]].packet;
     if (!backPacket->tx_after && backPacket->priority < p->priority) {
         LOG_WARN("Dropping packet 0x%08x to make room in the TX queue for higher-priority packet 0x%08x", backPacket->id, p->id);
         // Remove the back packet
-        queue.pop_back();
-        packetPool.release(backPacket);
+        packetPool.release(removeAt(backPos));
         // Insert the new packet in the correct order
         enqueue(p);
         return true;
@@ -155,15 +179,15 @@ bool MeshPacketQueue::replaceLowerPriorityPacket(meshtastic_MeshPacket *p)
 
     if (backPacket->tx_after) {
         // Check if there's a non-late packet with lower priority
-        auto it = queue.end();
-        auto refPacket = *--it;
-        for (; refPacket->tx_after && it != queue.begin(); refPacket = *--it)
-            ;
-        if (!refPacket->tx_after && refPacket->priority < p->priority) {
+        size_t refPos = findLast(true);
+        if (refPos == heap.size())
+            return false; // Only late packets in the queue
+
+        auto refPacket = entries[heap[refPos]].packet;
+        if (refPacket->priority < p->priority) {
             LOG_WARN("Dropping non-late packet 0x%08x to make room in the TX queue for higher-priority packet 0x%08x",
                      refPacket->id, p->id);
-            queue.erase(it);
-            packetPool.release(refPacket);
+            packetPool.release(removeAt(refPos));
             // Insert the new packet in the correct order
             enqueue(p);
             return true;
@@ -172,4 +196,121 @@ bool MeshPacketQueue::replaceLowerPriorityPacket(meshtastic_MeshPacket *p)
 
     // If the back packet's priority is not lower, no replacement occurs
     return false;
-}
\ No newline at end of file
+}
+
+/// @return true if the packet in slot a must be sent before the one in slot b
+bool MeshPacketQueue::before(uint16_t a, uint16_t b) const
+{
+    const Entry &ea = entries[a], &eb = entries[b];
+    if (CompareMeshPacketFunc(ea.packet, eb.packet))
+        return true;
+    if (CompareMeshPacketFunc(eb.packet, ea.packet))
+        return false;
+    return (int32_t)(ea.seq - eb.seq) < 0; // Equal order, first come first served (wrap friendly)
+}
+
+/// @return the index bucket for a (from, id) key
+uint16_t &MeshPacketQueue::bucketFor(NodeNum from, PacketId id)
+{
+    uint32_t h = (from * 0x9E3779B1u) ^ id;
+    h *= 0x85EBCA6Bu;
+    return buckets[(h ^ (h >> 16)) & (buckets.size() - 1)];
+}
+
+void MeshPacketQueue::siftUp(size_t pos)
+{
+    uint16_t slot = heap[pos];
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (!before(slot, heap[parent]))
+            break;
+        heap[pos] = heap[parent];
+        entries[heap[pos]].heapPos = pos;
+        pos = parent;
+    }
+    heap[pos] = slot;
+    entries[slot].heapPos = pos;
+}
+
+void MeshPacketQueue::siftDown(size_t pos)
+{
+    uint16_t slot = heap[pos];
+    size_t n = heap.size();
+    while (true) {
+        size_t child = 2 * pos + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && before(heap[child + 1], heap[child]))
+            child++;
+        if (!before(heap[child], slot))
+            break;
+        heap[pos] = heap[child];
+        entries[heap[pos]].heapPos = pos;
+        pos = child;
+    }
+    heap[pos] = slot;
+    entries[slot].heapPos = pos;
+}
+
+/// Remove the entry at heap position pos from the heap and the index, @return the packet it held
+meshtastic_MeshPacket *MeshPacketQueue::removeAt(size_t pos)
+{
+    uint16_t slot = heap[pos];
+    Entry &e = entries[slot];
+    meshtastic_MeshPacket *p = e.packet;
+
+    // Unlink from the index
+    for (uint16_t *link = &bucketFor(e.from, p->id); *link != NO_SLOT; link = &entries[*link].next) {
+        if (*link == slot) {
+            *link = e.next;
+            break;
+        }
+    }
+
+    // Fill the hole with the last heap element and restore the heap property
+    uint16_t last = heap.back();
+    heap.pop_back();
+    if (pos < heap.size()) {
+        heap[pos] = last;
+        entries[last].heapPos = pos;
+        siftDown(pos);
+        siftUp(entries[last].heapPos);
+    }
+
+    e.packet = NULL;
+    e.next = freeSlots;
+    freeSlots = slot;
+    return p;
+}
+
+/// @return the slot holding the matching packet, or NO_SLOT
+uint16_t MeshPacketQueue::findSlot(NodeNum from, PacketId id, bool tx_normal, bool tx_late)
+{
+    if (buckets.empty())
+        return NO_SLOT;
+
+    // Packets with the same key can be queued more than once, return the first one in queue order like a scan would
+    uint16_t found = NO_SLOT;
+    for (uint16_t slot = bucketFor(from, id); slot != NO_SLOT; slot = entries[slot].next) {
+        auto p = entries[slot].packet;
+        if (entries[slot].from == from && p->id == id && ((tx_normal && !p->tx_after) || (tx_late && p->tx_after))) {
+            if (found == NO_SLOT || before(slot, found))
+                found = slot;
+        }
+    }
+
+    return found;
+}
+
+/// @return the heap position of the packet that would be sent last, optionally only looking at non-late packets
+size_t MeshPacketQueue::findLast(bool nonLateOnly)
+{
+    size_t last = heap.size();
+    for (size_t pos = 0; pos < heap.size(); pos++) {
+        if (nonLateOnly && entries[heap[pos]].packet->tx_after)
+            continue;
+        if (last == heap.size() || before(heap[last], heap[pos]))
+            last = pos;
+    }
+    return last;
+}
@@ -1,21 +1,61 @@
 #pragma once
 
 #include "MeshTypes.h"
+#include "configuration.h"
 
-#include <queue>
+#include <vector>
 
 /**
  * A priority queue of packets
+ *
+ * Packets are kept in a binary heap ordered by CompareMeshPacketFunc, ties are broken by enqueue order so packets of equal
+ * priority still leave in FIFO order. All storage is allocated once in the constructor, and packets are also indexed by
+ * (from, id) so remove() and find() don't have to scan the queue.
  */
 class MeshPacketQueue
 {
+    static constexpr uint16_t NO_SLOT = UINT16_MAX;
+
+    struct Entry {
+        meshtastic_MeshPacket *packet; // NULL if this slot is free
+        NodeNum from;                  // getFrom(packet) at enqueue time, part of the index key
+        uint32_t seq;                  // Enqueue order, used to keep the ordering stable
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+        uint32_t enqueuedAt; // micros() at enqueue, for the TX queue wait latency probe
+#endif
+        uint16_t heapPos;              // Where this slot currently is in heap
+        uint16_t next;                 // Next slot in the same index bucket, or in the free list
+    };
+
     size_t maxLen;
-    std::vector<meshtastic_MeshPacket *> queue;
+    std::vector<Entry> entries;    // Fixed pool of maxLen slots
+    std::vector<uint16_t> heap;    // Slot numbers, heap[0] is the packet that goes out next
+    std::vector<uint16_t> buckets; // (from, id) hash -> first slot in the bucket chain
+    uint16_t freeSlots = NO_SLOT;  // Head of the free slot list
+    uint32_t nextSeq = 0;
 
     /** Replace a lower priority package in the queue with 'mp' (provided there are lower pri packages). Return true if replaced.
      */
     bool replaceLowerPriorityPacket(meshtastic_MeshPacket *mp);
 
+    /// @return true if the packet in slot a must be sent before the one in slot b
+    bool before(uint16_t a, uint16_t b) const;
+
+    /// @return the index bucket for a (from, id) key
+    uint16_t &bucketFor(NodeNum from, PacketId id);
+
+    void siftUp(size_t pos);
+    void siftDown(size_t pos);
+
+    /// Remove the entry at heap position pos from the heap and the index, @return the packet it held
+    meshtastic_MeshPacket *removeAt(size_t pos);
+
+    /// @return the slot holding the matching packet, or NO_SLOT
+    uint16_t findSlot(NodeNum from, PacketId id, bool tx_normal, bool tx_late);
+
+    /// @return the heap position of the packet that would be sent last, optionally only looking at non-late packets
+    size_t findLast(bool nonLateOnly);
+
   public:
     explicit MeshPacketQueue(size_t _maxLen);
 
@@ -26,7 +66,7 @@ class MeshPacketQueue
     bool empty();
 
     /** return amount of free packets in Queue */
-    size_t getFree() { return maxLen - queue.size(); }
+    size_t getFree() { return maxLen - heap.size(); }
 
     /** return total size of the Queue */
     size_t getMaxLen() { return maxLen; }
@@ -40,4 +80,4 @@ class MeshPacketQueue
 
     /* Attempt to find a packet from this queue. Return true if it was found. */
     bool find(const NodeNum from, const PacketId id);
-};
\ No newline at end of file
+};
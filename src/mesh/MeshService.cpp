@@ -11,12 +11,14 @@
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "TypeConversions.h"
+#include "concurrency/LockGuard.h"
 #include "main.h"
 #include "mesh-pb-constants.h"
 #include "meshUtils.h"
 #include "modules/NodeInfoModule.h"
 #include "modules/PositionModule.h"
 #include "power.h"
+#include <algorithm>
 #include <assert.h>
 #include <string>
 
@@ -45,11 +47,21 @@ the new node can build its node db)
 
 MeshService *service;
 
+#if defined(ARCH_STM32WL) || !HAS_LOCK_FREE_POOL // Not enough RAM, or no lock-free atomics, to reserve these up front
 static MemoryDynamic<meshtastic_MqttClientProxyMessage> staticMqttClientProxyMessagePool;
 
 static MemoryDynamic<meshtastic_QueueStatus> staticQueueStatusPool;
 
 static MemoryDynamic<meshtastic_ClientNotification> staticClientNotificationPool;
+#else
+// MQTT proxy messages and notifications are large and rare, keep a few slots and let bursts use the heap fallback
+static MemoryPool<meshtastic_MqttClientProxyMessage> staticMqttClientProxyMessagePool(4);
+
+// Fixed size, MAX_RX_TOPHONE is only known once the config is loaded on portduino
+static MemoryPool<meshtastic_QueueStatus> staticQueueStatusPool(16);
+
+static MemoryPool<meshtastic_ClientNotification> staticClientNotificationPool(2);
+#endif
 
 Allocator<meshtastic_MqttClientProxyMessage> &mqttClientProxyMessagePool = staticMqttClientProxyMessagePool;
 
@@ -60,7 +72,7 @@ Allocator<meshtastic_QueueStatus> &queueStatusPool = staticQueueStatusPool;
 #include "Router.h"
 
 MeshService::MeshService()
-    : toPhoneQueue(MAX_RX_TOPHONE), toPhoneQueueStatusQueue(MAX_RX_TOPHONE), toPhoneMqttProxyQueue(MAX_RX_TOPHONE),
+    : toPhonePackets(MAX_RX_TOPHONE, nullptr), toPhoneQueueStatusQueue(MAX_RX_TOPHONE), toPhoneMqttProxyQueue(MAX_RX_TOPHONE),
       toPhoneClientNotificationQueue(MAX_RX_TOPHONE / 2)
 {
     lastQueueStatus = {0, 0, 16, 0};
@@ -152,19 +164,83 @@ void MeshService::reloadOwner(bool shouldSave)
 // search the queue for a request id and return the matching nodenum
 NodeNum MeshService::getNodenumFromRequestId(uint32_t request_id)
 {
+    concurrency::LockGuard g(&toPhoneLock);
     NodeNum nodenum = 0;
-    for (int i = 0; i < toPhoneQueue.numUsed(); i++) {
-        meshtastic_MeshPacket *p = toPhoneQueue.dequeuePtr(0);
-        if (p->id == request_id) {
-            nodenum = p->to;
-            // make sure to continue this to make one full loop
-        }
-        // put it right back on the queue
-        toPhoneQueue.enqueue(p, 0);
+    for (uint32_t seq = toPhoneTail; seq != toPhoneHead; seq++) {
+        meshtastic_MeshPacket *p = toPhonePackets[seq % toPhonePackets.size()];
+        if (p && p->id == request_id)
+            nodenum = p->to; // keep going, like the old queue walk the newest match wins
     }
     return nodenum;
 }
 
+void MeshService::addPhoneCursor(uint32_t *cursor)
+{
+    concurrency::LockGuard g(&toPhoneLock);
+    if (std::find(toPhoneCursors.begin(), toPhoneCursors.end(), cursor) == toPhoneCursors.end())
+        toPhoneCursors.push_back(cursor);
+    *cursor = toPhoneTail;
+}
+
+void MeshService::removePhoneCursor(uint32_t *cursor)
+{
+    concurrency::LockGuard g(&toPhoneLock);
+    auto it = std::find(toPhoneCursors.begin(), toPhoneCursors.end(), cursor);
+    if (it != toPhoneCursors.end()) {
+        toPhoneCursors.erase(it);
+        trimToPhonePackets();
+    }
+}
+
+meshtastic_MeshPacket *MeshService::getForPhone(uint32_t *cursor)
+{
+    concurrency::LockGuard g(&toPhoneLock);
+    // Packets dropped while the queue was full are skipped
+    if ((int32_t)(*cursor - toPhoneTail) < 0)
+        *cursor = toPhoneTail;
+    if (*cursor == toPhoneHead)
+        return NULL;
+
+    uint32_t seq = *cursor;
+    meshtastic_MeshPacket *&slot = toPhonePackets[seq % toPhonePackets.size()];
+
+    // Hand the packet over if no other client still has to read it, otherwise this client gets its own copy
+    bool neededByOthers = false;
+    for (uint32_t *c : toPhoneCursors)
+        if (c != cursor && (int32_t)(*c - seq) <= 0)
+            neededByOthers = true;
+
+    meshtastic_MeshPacket *p = slot;
+    if (neededByOthers) {
+        p = packetPool.allocCopy(*slot);
+        if (!p)
+            return NULL; // Try again later, once the pool has room
+    } else {
+        slot = NULL;
+    }
+    (*cursor)++;
+    trimToPhonePackets();
+    return p;
+}
+
+void MeshService::trimToPhonePackets()
+{
+    if (toPhoneCursors.empty())
+        return; // Keep everything for the next client
+
+    uint32_t oldest = toPhoneHead;
+    for (uint32_t *c : toPhoneCursors)
+        if ((int32_t)(*c - oldest) < 0 && (int32_t)(*c - toPhoneTail) >= 0)
+            oldest = *c;
+    for (; toPhoneTail != oldest; toPhoneTail++) {
+        meshtastic_MeshPacket *&slot = toPhonePackets[toPhoneTail % toPhonePackets.size()];
+        if (slot) {
+            releaseToPool(slot);
+            slot = NULL;
+        }
+    }
+}
+
 /**
  *  Given a ToRadio buffer parse it and properly handle it (setup radio, owner or send packet into the mesh)
  * Called by PhoneAPI.handleToRadio.  Note: p is a scratch buffer, this function is allowed to write to it but it can not keep a
@@ -294,13 +370,16 @@ void MeshService::sendToPhone(meshtastic_MeshPacket *p)
 #endif
 #endif
 
-    if (toPhoneQueue.numFree() == 0) {
+    concurrency::LockGuard g(&toPhoneLock);
+    if (toPhoneHead - toPhoneTail == toPhonePackets.size()) {
         if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP ||
             p->decoded.portnum == meshtastic_PortNum_RANGE_TEST_APP) {
             LOG_WARN("ToPhone queue is full, discard oldest");
-            meshtastic_MeshPacket *d = toPhoneQueue.dequeuePtr(0);
+            meshtastic_MeshPacket *&d = toPhonePackets[toPhoneTail % toPhonePackets.size()];
             if (d)
                 releaseToPool(d);
+            d = NULL;
+            toPhoneTail++;
         } else {
             LOG_WARN("ToPhone queue is full, drop packet");
             releaseToPool(p);
@@ -309,10 +388,8 @@ void MeshService::sendToPhone(meshtastic_MeshPacket *p)
         }
     }
 
-    if (toPhoneQueue.enqueue(p, 0) == false) {
-        LOG_CRIT("Failed to queue a packet into toPhoneQueue!");
-        abort();
-    }
+    toPhonePackets[toPhoneHead % toPhonePackets.size()] = p;
+    toPhoneHead++;
     fromNum++;
 }
 
@@ -413,7 +490,9 @@ int MeshService::onGPSChanged(const meshtastic::GPSStatus *newStatus)
 #endif
 bool MeshService::isToPhoneQueueEmpty()
 {
-    return toPhoneQueue.isEmpty();
+    // Packets are only kept while some phone hasn't read them yet
+    concurrency::LockGuard g(&toPhoneLock);
+    return toPhoneHead == toPhoneTail;
 }
 
 uint32_t MeshService::GetTimeSinceMeshPacket(const meshtastic_MeshPacket *mp)
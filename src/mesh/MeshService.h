@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include <assert.h>
 #include <string>
+#include <vector>
 
 #include "GPSStatus.h"
 #include "MemoryPool.h"
@@ -10,6 +11,8 @@
 #include "MeshTypes.h"
 #include "Observer.h"
 #include "PointerQueue.h"
+#include "concurrency/Lock.h"
+#include <vector>
 #if defined(ARCH_PORTDUINO)
 #include "../platform/portduino/SimRadio.h"
 #endif
@@ -33,11 +36,19 @@ class MeshService
     CallbackObserver<MeshService, const meshtastic::GPSStatus *> gpsObserver =
         CallbackObserver<MeshService, const meshtastic::GPSStatus *>(this, &MeshService::onGPSChanged);
 #endif
-    /// received packets waiting for the phone to process them
-    /// FIXME, change to a DropOldestQueue and keep a count of the number of dropped packets to ensure
-    /// we never hang because android hasn't been there in a while
+    /// received packets waiting for the phone to process them, a ring indexed by sequence number
+    /// Every connected client reads it through its own cursor, a packet is released once all of them are past it (or when it
+    /// is pushed out by newer ones). With no client connected packets are kept for the next one.
     /// FIXME - save this to flash on deep sleep
-    PointerQueue<meshtastic_MeshPacket> toPhoneQueue;
+    /// Sized once in the constructor, MAX_RX_TOPHONE is only known after the config is loaded on portduino
+    std::vector<meshtastic_MeshPacket *> toPhonePackets;
+    uint32_t toPhoneHead = 0;               // Sequence number the next packet gets
+    uint32_t toPhoneTail = 0;               // Sequence number of the oldest packet still stored
+    std::vector<uint32_t *> toPhoneCursors; // Next sequence number each connected client will read
+    concurrency::Lock toPhoneLock;          // Clients can read from other threads (BLE)
+
+    /// Release the packets every cursor is past, call with toPhoneLock held
+    void trimToPhonePackets();
 
     // keep list of QueueStatus packets to be send to the phone
     PointerQueue<meshtastic_QueueStatus> toPhoneQueueStatusQueue;
@@ -67,6 +78,14 @@ class MeshService
                p->decoded.portnum == meshtastic_PortNum_DETECTION_SENSOR_APP ||
                p->decoded.portnum == meshtastic_PortNum_ALERT_APP;
     }
+
+    /// Every portnum isTextPayload() can accept, whatever the config, for MeshModule::getWantedPortNums()
+    static bool getTextPayloadPortNums(std::vector<meshtastic_PortNum> &portNums)
+    {
+        portNums.insert(portNums.end(), {meshtastic_PortNum_TEXT_MESSAGE_APP, meshtastic_PortNum_DETECTION_SENSOR_APP,
+                                         meshtastic_PortNum_ALERT_APP, meshtastic_PortNum_RANGE_TEST_APP});
+        return true;
+    }
     /// Called when some new packets have arrived from one of the radios
     Observable<uint32_t> fromNumChanged;
 
@@ -80,9 +99,15 @@ class MeshService
     /// Do idle processing (mostly processing messages which have been queued from the radio)
     void loop();
 
-    /// Return the next packet destined to the phone.  FIXME, somehow use fromNum to allow the phone to retry the
-    /// last few packets if needs to.
-    meshtastic_MeshPacket *getForPhone() { return toPhoneQueue.dequeuePtr(0); }
+    /// Start reading packets destined to the phone with cursor, from the oldest one still stored
+    void addPhoneCursor(uint32_t *cursor);
+
+    /// Stop reading with cursor, releasing what only it still needed
+    void removePhoneCursor(uint32_t *cursor);
+
+    /// Return the next packet destined to the phone for the client reading with cursor, NULL if it has seen them all.
+    /// The caller owns the result and must releaseToPool() it.
+    meshtastic_MeshPacket *getForPhone(uint32_t *cursor);
 
     /// Allows the bluetooth handler to free packets after they have been sent
     void releaseToPool(meshtastic_MeshPacket *p) { packetPool.release(p); }
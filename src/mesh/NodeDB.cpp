@@ -483,6 +483,8 @@ void NodeDB::installDefaultNodeDatabase()
     nodeDatabase.nodes = std::vector<meshtastic_NodeInfoLite>(MAX_NUM_NODES);
     numMeshNodes = 0;
     meshNodes = &nodeDatabase.nodes;
+    nodeIndex.rebuild(meshNodes, numMeshNodes);
+    nodeJournal.discard();
 }
 
 void NodeDB::installDefaultConfig(bool preserveKey = false)
@@ -932,6 +934,7 @@ void NodeDB::resetNodes()
         clearLocalPosition();
     numMeshNodes = 1;
     std::fill(nodeDatabase.nodes.begin() + 1, nodeDatabase.nodes.end(), meshtastic_NodeInfoLite());
+    nodeIndex.rebuild(meshNodes, numMeshNodes);
     devicestate.has_rx_text_message = false;
     devicestate.has_rx_waypoint = false;
     saveNodeDatabaseToDisk();
@@ -952,6 +955,7 @@ void NodeDB::removeNodeByNum(NodeNum nodeNum)
     numMeshNodes -= removed;
     std::fill(nodeDatabase.nodes.begin() + numMeshNodes, nodeDatabase.nodes.begin() + numMeshNodes + 1,
               meshtastic_NodeInfoLite());
+    nodeIndex.rebuild(meshNodes, numMeshNodes);
     LOG_DEBUG("NodeDB::removeNodeByNum purged %d entries. Save changes", removed);
     saveNodeDatabaseToDisk();
 }
@@ -984,6 +988,7 @@ void NodeDB::cleanupMeshDB()
     numMeshNodes -= removed;
     std::fill(nodeDatabase.nodes.begin() + numMeshNodes, nodeDatabase.nodes.begin() + numMeshNodes + removed,
               meshtastic_NodeInfoLite());
+    nodeIndex.rebuild(meshNodes, numMeshNodes);
     LOG_DEBUG("cleanupMeshDB purged %d entries", removed);
 }
 
@@ -1119,12 +1124,14 @@ void NodeDB::loadFromDisk()
 #endif
     auto state = loadProto(nodeDatabaseFileName, getMaxNodesAllocatedSize(), sizeof(meshtastic_NodeDatabase),
                            &meshtastic_NodeDatabase_msg, &nodeDatabase);
+    bool replayJournal = false;
     if (nodeDatabase.version < DEVICESTATE_MIN_VER) {
         LOG_WARN("NodeDatabase %d is old, discard", nodeDatabase.version);
         installDefaultNodeDatabase();
     } else {
         meshNodes = &nodeDatabase.nodes;
         numMeshNodes = nodeDatabase.nodes.size();
+        replayJournal = state == LoadFileResult::LOAD_SUCCESS;
         LOG_INFO("Loaded saved nodedatabase version %d, with nodes count: %d", nodeDatabase.version, nodeDatabase.nodes.size());
     }
 
@@ -1133,6 +1140,18 @@ void NodeDB::loadFromDisk()
         numMeshNodes = MAX_NUM_NODES;
     }
     meshNodes->resize(MAX_NUM_NODES);
+#ifdef FSCom
+    if (replayJournal) {
+        spiLock->lock();
+        auto f = FSCom.open(nodeDatabaseFileName, FILE_O_READ);
+        size_t snapshotSize = f ? f.size() : 0;
+        if (f)
+            f.close();
+        spiLock->unlock();
+        numMeshNodes = nodeJournal.replay(*meshNodes, numMeshNodes, snapshotSize);
+    }
+#endif
+    nodeIndex.rebuild(meshNodes, numMeshNodes);
 
     // static DeviceState scratch; We no longer read into a tempbuf because this structure is 15KB of valuable RAM
     state = loadProto(deviceStateFileName, meshtastic_DeviceState_size, sizeof(meshtastic_DeviceState),
@@ -1332,9 +1351,19 @@ bool NodeDB::saveNodeDatabaseToDisk()
     FSCom.mkdir("/prefs");
     spiLock->unlock();
 #endif
+    // Usually only a few nodes changed, just append those to the journal
+    if (nodeJournal.append(*meshNodes, numMeshNodes))
+        return true;
+
+    // No usable journal or it got too big: write a new snapshot and start over. The old journal goes first, so a reboot
+    // half way can never replay it over a newer snapshot.
+    nodeJournal.discard();
     size_t nodeDatabaseSize;
     pb_get_encoded_size(&nodeDatabaseSize, meshtastic_NodeDatabase_fields, &nodeDatabase);
-    return saveProto(nodeDatabaseFileName, nodeDatabaseSize, &meshtastic_NodeDatabase_msg, &nodeDatabase, false);
+    bool okay = saveProto(nodeDatabaseFileName, nodeDatabaseSize, &meshtastic_NodeDatabase_msg, &nodeDatabase, false);
+    if (okay)
+        nodeJournal.start(nodeDatabaseSize, *meshNodes, numMeshNodes);
+    return okay;
 }
 
 bool NodeDB::saveToDiskNoRetry(int saveWhat)
@@ -1677,9 +1706,9 @@ uint8_t NodeDB::getMeshNodeChannel(NodeNum n)
 /// NOTE: This function might be called from an ISR
 meshtastic_NodeInfoLite *NodeDB::getMeshNode(NodeNum n)
 {
-    for (int i = 0; i < numMeshNodes; i++)
-        if (meshNodes->at(i).num == n)
-            return &meshNodes->at(i);
+    int i = nodeIndex.find(n);
+    if (i >= 0 && i < numMeshNodes)
+        return &meshNodes->at(i);
 
     return NULL;
 }
@@ -1730,6 +1759,7 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
                     meshNodes->at(i) = meshNodes->at(i + 1);
                 }
                 (numMeshNodes)--;
+                nodeIndex.rebuild(meshNodes, numMeshNodes);
             }
         }
         // add the node at the end
@@ -1738,6 +1768,7 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
         // everything is missing except the nodenum
         memset(lite, 0, sizeof(*lite));
         lite->num = n;
+        nodeIndex.insert(numMeshNodes - 1);
         LOG_INFO("Adding node to database with %i nodes and %u bytes free!", numMeshNodes, memGet.getFreeHeap());
     }
 
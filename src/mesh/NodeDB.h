@@ -8,6 +8,8 @@
 #include <vector>
 
 #include "MeshTypes.h"
+#include "NodeIndex.h"
+#include "NodeJournal.h"
 #include "NodeStatus.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
@@ -139,9 +141,7 @@ class NodeDB
 {
     // NodeNum provisionalNodeNum; // if we are trying to find a node num this is our current attempt
 
-    // A NodeInfo for every node we've seen
-    // Eventually use a smarter datastructure
-    // HashMap<NodeNum, NodeInfo> nodes;
+    // A NodeInfo for every node we've seen, looked up through nodeIndex
     // Note: these two references just point into our static array we serialize to/from disk
 
   public:
@@ -282,6 +282,8 @@ class NodeDB
     bool duplicateWarned = false;
     uint32_t lastNodeDbSave = 0;    // when we last saved our db to flash
     uint32_t lastBackupAttempt = 0; // when we last tried a backup automatically or manually
+    NodeIndex nodeIndex;            // NodeNum -> position in meshNodes, must be rebuilt whenever nodes move
+    NodeJournal nodeJournal;        // Node changes saved since nodeDatabaseFileName was last written
     /// Find a node in our DB, create an empty NodeInfoLite if missing
     meshtastic_NodeInfoLite *getOrCreateMeshNode(NodeNum n);
 
@@ -0,0 +1,63 @@
+#include "NodeIndex.h"
+#include "configuration.h"
+
+void NodeIndex::rebuild(const std::vector<meshtastic_NodeInfoLite> *nodes, size_t count)
+{
+    this->nodes = nodes;
+
+    // Keep the load factor at or below 50% for the whole array capacity, so appends never need a resize
+    size_t wanted = 4;
+    uint8_t bits = 2;
+    while (wanted < nodes->size() * 2) {
+        wanted <<= 1;
+        bits++;
+    }
+    if (nodes->size() >= EMPTY_SLOT) {
+        LOG_ERROR("NodeIndex - %u nodes exceed index capacity, truncating", (uint32_t)nodes->size());
+        count = std::min(count, (size_t)EMPTY_SLOT - 1);
+    }
+
+    if (slots.size() != wanted) {
+        slots.assign(wanted, EMPTY_SLOT);
+        mask = wanted - 1;
+        shift = 32 - bits;
+    } else {
+        clear();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        // Duplicates can exist in a DB loaded from disk, keep the first one like the old linear scan did
+        if (find(nodes->at(i).num) < 0)
+            insert(i);
+    }
+}
+
+void NodeIndex::insert(size_t pos)
+{
+    if (slots.empty() || pos >= EMPTY_SLOT)
+        return;
+
+    uint32_t i = slotFor(nodes->at(pos).num);
+    while (slots[i] != EMPTY_SLOT)
+        i = (i + 1) & mask;
+    slots[i] = (uint16_t)pos;
+}
+
+int NodeIndex::find(NodeNum n) const
+{
+    if (slots.empty())
+        return -1;
+
+    for (uint32_t i = slotFor(n);; i = (i + 1) & mask) {
+        uint16_t pos = slots[i];
+        if (pos == EMPTY_SLOT)
+            return -1;
+        if ((*nodes)[pos].num == n)
+            return pos;
+    }
+}
+
+void NodeIndex::clear()
+{
+    std::fill(slots.begin(), slots.end(), EMPTY_SLOT);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include <vector>
+
+/**
+ * An open-addressed NodeNum -> array position index over the NodeDB node array.
+ *
+ * The table only stores positions (uint16_t), the key is read back from the node array itself, so the index costs
+ * 2 bytes per slot. The table is kept at most half full, so a probe sequence always ends on an empty slot.
+ *
+ * Appending a node is O(1) via insert(). Anything that moves nodes around in the array (removal, compaction, eviction,
+ * sorting) must call rebuild() afterwards; those operations are already O(n) so this does not change their cost.
+ */
+class NodeIndex
+{
+  public:
+    /// Rebuild the whole index for the first count entries of nodes, resizing the table if the array capacity changed
+    void rebuild(const std::vector<meshtastic_NodeInfoLite> *nodes, size_t count);
+
+    /// Add the node stored at pos. The caller guarantees its num is not already indexed.
+    void insert(size_t pos);
+
+    /** Find a node in the index
+     * @return position in the node array or -1 if not indexed
+     * NOTE: This function might be called from an ISR, it never allocates */
+    int find(NodeNum n) const;
+
+    /// Drop all entries, keeping the table allocated
+    void clear();
+
+  private:
+    static constexpr uint16_t EMPTY_SLOT = UINT16_MAX;
+
+    const std::vector<meshtastic_NodeInfoLite> *nodes = NULL;
+    std::vector<uint16_t> slots;
+    uint32_t mask = 0;
+    uint8_t shift = 32;
+
+    /// Fibonacci hashing, node numbers are often sequential or share their low bytes
+    uint32_t slotFor(NodeNum n) const { return (uint32_t)(n * 2654435769u) >> shift; }
+};
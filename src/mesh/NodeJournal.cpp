@@ -0,0 +1,240 @@
+#include "NodeJournal.h"
+#include "FSCommon.h"
+#include "SPILock.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+#include <ErriezCRC32.h>
+#include <algorithm>
+#include <pb_decode.h>
+#include <pb_encode.h>
+
+static void putU32(uint8_t *p, uint32_t v)
+{
+    for (uint8_t i = 0; i < 4; i++)
+        p[i] = v >> (8 * i);
+}
+
+static uint32_t getU32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t NodeJournal::encode(const meshtastic_NodeInfoLite &node, uint8_t *buf)
+{
+    pb_ostream_t stream = pb_ostream_from_buffer(buf, meshtastic_NodeInfoLite_size);
+    return pb_encode(&stream, meshtastic_NodeInfoLite_fields, &node) ? stream.bytes_written : 0;
+}
+
+uint32_t NodeJournal::hash(const uint8_t *buf, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ buf[i]) * 16777619u;
+    return h;
+}
+
+void NodeJournal::markPersisted(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count)
+{
+    uint8_t buf[meshtastic_NodeInfoLite_size];
+
+    persisted.clear();
+    persisted.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        if (!nodes[i].num) // Unused entry in a DB loaded from disk
+            continue;
+        size_t len = encode(nodes[i], buf);
+        persisted.push_back({nodes[i].num, hash(buf, len)});
+    }
+    std::sort(persisted.begin(), persisted.end());
+}
+
+size_t NodeJournal::replay(std::vector<meshtastic_NodeInfoLite> &nodes, size_t count, size_t snapshotSize)
+{
+    usable = false;
+#ifdef FSCom
+    concurrency::LockGuard g(spiLock);
+
+    auto f = FSCom.open(fileName, FILE_O_READ);
+    if (!f)
+        return count;
+
+    uint8_t header[HEADER_SIZE];
+    if (f.read(header, HEADER_SIZE) != HEADER_SIZE || getU32(header) != MAGIC || getU32(header + 4) != snapshotSize) {
+        LOG_WARN("Ignore %s, it does not belong to the node database", fileName);
+        f.close();
+        return count;
+    }
+
+    uint8_t record[3 + meshtastic_NodeInfoLite_size + 4];
+    uint32_t numRecords = 0;
+    journalBytes = HEADER_SIZE;
+    while (f.read(record, 3) == 3) {
+        uint16_t len = record[1] | (record[2] << 8);
+        if (len > meshtastic_NodeInfoLite_size || f.read(record + 3, len + 4) != (size_t)len + 4 ||
+            getU32(record + 3 + len) != crc32Buffer(record, 3 + len)) {
+            LOG_WARN("Truncated or corrupt record in %s, drop the rest", fileName);
+            break;
+        }
+
+        if (record[0] == UPSERT) {
+            meshtastic_NodeInfoLite node = meshtastic_NodeInfoLite_init_default;
+            pb_istream_t stream = pb_istream_from_buffer(record + 3, len);
+            if (!pb_decode(&stream, meshtastic_NodeInfoLite_fields, &node) || !node.num)
+                break;
+
+            size_t i = 0;
+            while (i < count && nodes[i].num != node.num)
+                i++;
+            if (i == count && count < nodes.size())
+                count++;
+            else if (i == count) // Full of unused entries from the snapshot, reuse one of those
+                for (i = 0; i < count && nodes[i].num; i++)
+                    ;
+
+            if (i < count)
+                nodes[i] = node;
+            else
+                LOG_WARN("No room to replay node 0x%x", node.num);
+        } else if (record[0] == REMOVE && len == 4) {
+            NodeNum num = getU32(record + 3);
+            auto last = std::remove_if(nodes.begin(), nodes.begin() + count,
+                                       [num](const meshtastic_NodeInfoLite &n) { return n.num == num; });
+            size_t newCount = last - nodes.begin();
+            std::fill(nodes.begin() + newCount, nodes.begin() + count, meshtastic_NodeInfoLite());
+            count = newCount;
+        } else {
+            LOG_WARN("Unknown record in %s, drop the rest", fileName);
+            break;
+        }
+        journalBytes += RECORD_OVERHEAD + len;
+        numRecords++;
+    }
+    // A corrupt tail is left behind, start a new journal on the next save rather than appending after it
+    usable = journalBytes == f.size();
+    f.close();
+
+    LOG_INFO("Replayed %u node changes from %s", numRecords, fileName);
+    maxBytes = snapshotSize / 2 > MIN_MAX_BYTES ? snapshotSize / 2 : MIN_MAX_BYTES;
+    markPersisted(nodes, count);
+#endif
+    return count;
+}
+
+bool NodeJournal::append(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count)
+{
+    if (!usable)
+        return false;
+
+    // First pass: find what changed and how much we'd write, without holding anything but the new hashes
+    uint8_t record[3 + meshtastic_NodeInfoLite_size + 4];
+    std::vector<Persisted> current;
+    std::vector<uint16_t> changed;
+    size_t bytes = 0;
+    current.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        if (!nodes[i].num)
+            continue;
+        size_t len = encode(nodes[i], record + 3);
+        if (!len)
+            return false;
+        Persisted p = {nodes[i].num, hash(record + 3, len)};
+        auto it = std::lower_bound(persisted.begin(), persisted.end(), p);
+        if (it == persisted.end() || it->num != p.num || it->hash != p.hash) {
+            changed.push_back(i);
+            bytes += RECORD_OVERHEAD + len;
+        }
+        current.push_back(p);
+    }
+    std::sort(current.begin(), current.end());
+
+    std::vector<NodeNum> removed;
+    for (auto &p : persisted) {
+        if (!std::binary_search(current.begin(), current.end(), p)) {
+            removed.push_back(p.num);
+            bytes += RECORD_OVERHEAD + 4;
+        }
+    }
+
+    if (!bytes)
+        return true;
+    if (journalBytes + bytes > maxBytes)
+        return false;
+
+#ifdef FSCom
+    concurrency::LockGuard g(spiLock);
+
+    // Appending to a deleted journal (e.g. after a factory reset) would create one without a header
+    if (!FSCom.exists(fileName)) {
+        usable = false;
+        return false;
+    }
+    auto f = FSCom.open(fileName, FILE_O_APPEND);
+    if (!f) {
+        usable = false;
+        return false;
+    }
+
+    size_t written = 0;
+    auto writeRecord = [&](RecordType type, size_t len) {
+        record[0] = type;
+        record[1] = len & 0xff;
+        record[2] = len >> 8;
+        putU32(record + 3 + len, crc32Buffer(record, 3 + len));
+        written += f.write((uint8_t const *)record, RECORD_OVERHEAD + len);
+    };
+    // Removals first: when the database is full, a new node took the slot of an evicted one, and replaying its UPSERT
+    // before the REMOVE would find no room for it
+    for (NodeNum num : removed) {
+        putU32(record + 3, num);
+        writeRecord(REMOVE, 4);
+    }
+    for (uint16_t i : changed)
+        writeRecord(UPSERT, encode(nodes[i], record + 3));
+    f.close();
+
+    journalBytes += written;
+    if (written != bytes) {
+        LOG_ERROR("Can't append to %s", fileName);
+        usable = false;
+        return false;
+    }
+    LOG_DEBUG("Journaled %u changed and %u removed nodes, %u bytes", (uint32_t)changed.size(), (uint32_t)removed.size(),
+              (uint32_t)journalBytes);
+    persisted.swap(current);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void NodeJournal::discard()
+{
+    usable = false;
+    persisted.clear();
+#ifdef FSCom
+    concurrency::LockGuard g(spiLock);
+    FSCom.remove(fileName);
+#endif
+}
+
+void NodeJournal::start(size_t snapshotSize, const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count)
+{
+#ifdef FSCom
+    {
+        concurrency::LockGuard g(spiLock);
+        FSCom.remove(fileName);
+        auto f = FSCom.open(fileName, FILE_O_WRITE);
+        if (!f)
+            return;
+
+        uint8_t header[HEADER_SIZE];
+        putU32(header, MAGIC);
+        putU32(header + 4, snapshotSize);
+        usable = f.write((uint8_t const *)header, HEADER_SIZE) == HEADER_SIZE;
+        f.close();
+    }
+    journalBytes = HEADER_SIZE;
+    maxBytes = snapshotSize / 2 > MIN_MAX_BYTES ? snapshotSize / 2 : MIN_MAX_BYTES;
+    markPersisted(nodes, count);
+#endif
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include <vector>
+
+/**
+ * An append-only log of node changes, kept next to the node database snapshot (/prefs/nodes.proto).
+ *
+ * Rewriting the whole snapshot every time a node changes costs up to MAX_NUM_NODES * meshtastic_NodeInfoLite_size bytes
+ * of flash writes, even if a single node was heard. Instead, append() compares every node against what was last persisted
+ * and only writes records for the nodes that changed or went away. Once the journal grows past half the snapshot size
+ * append() refuses, and the caller folds everything into a new snapshot and calls start() again.
+ *
+ * File layout: an 8 byte header (magic, size of the snapshot it belongs to) followed by records of
+ * [type:1][length:2][payload][crc32 of type, length and payload:4]. An UPSERT payload is an encoded meshtastic_NodeInfoLite,
+ * a REMOVE payload the 4 byte NodeNum. Each save writes its REMOVE records before its UPSERTs. Replay stops at the first
+ * truncated or corrupt record, so a power loss while appending only loses the changes of that save.
+ */
+class NodeJournal
+{
+  public:
+    static constexpr const char *fileName = "/prefs/nodes.journal";
+
+    /**
+     * Apply the journal to a freshly loaded snapshot, if the journal belongs to it
+     * @param nodes the node array, new nodes are stored after the first count entries while it has room
+     * @param snapshotSize size on disk of the snapshot that was loaded
+     * @return the new number of nodes in use
+     */
+    size_t replay(std::vector<meshtastic_NodeInfoLite> &nodes, size_t count, size_t snapshotSize);
+
+    /**
+     * Append the nodes that changed since the last persist
+     * @return false if nothing was written because there is no usable journal or it would get too big, the caller must
+     * write a full snapshot instead
+     */
+    bool append(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count);
+
+    /// Delete the journal, must be done before the snapshot gets rewritten
+    void discard();
+
+    /// Start an empty journal for a snapshot of snapshotSize bytes that holds the first count entries of nodes
+    void start(size_t snapshotSize, const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count);
+
+  private:
+    enum RecordType : uint8_t { UPSERT = 1, REMOVE = 2 };
+
+    static constexpr uint32_t MAGIC = 0x314a444e; // "NDJ1"
+    static constexpr size_t HEADER_SIZE = 8;
+    static constexpr size_t RECORD_OVERHEAD = 7; // type, length and crc
+    static constexpr size_t MIN_MAX_BYTES = 4096;
+
+    /// What a node looked like when it was last persisted
+    struct Persisted {
+        NodeNum num;
+        uint32_t hash; // FNV-1a of the encoded node
+        bool operator<(const Persisted &o) const { return num < o.num; }
+    };
+
+    std::vector<Persisted> persisted; // Sorted by num
+    size_t journalBytes = 0;
+    size_t maxBytes = 0;
+    bool usable = false; // The journal on disk matches the snapshot and persisted
+
+    /// Remember the first count entries of nodes as persisted
+    void markPersisted(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count);
+
+    /// @return the encoded length of node in buf (meshtastic_NodeInfoLite_size bytes), 0 on failure
+    static size_t encode(const meshtastic_NodeInfoLite &node, uint8_t *buf);
+
+    static uint32_t hash(const uint8_t *buf, size_t len);
+};
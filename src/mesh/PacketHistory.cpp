@@ -1,4 +1,5 @@
 #include "PacketHistory.h"
+#include "LatencyStats.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
 
@@ -11,6 +12,8 @@
     max((u_int32_t)(MAX_NUM_NODES * 2.0),                                                                                        \
         (u_int32_t)100) // x2..3  Should suffice. Empirical setup. 16B per record malloc'ed, but no less than 100
 
+#define PACKETHISTORY_INDEX_EMPTY UINT16_MAX // Marks an unused recentIndex entry, so capacity must stay below it
+
 #define RECENT_WARN_AGE (10 * 60 * 1000L) // Warn if the packet that gets removed was more recent than 10 min
 
 #define VERBOSE_PACKET_HISTORY 0     // Set to 1 for verbose logging, 2 for heavy debugging
@@ -18,7 +21,7 @@
 
 PacketHistory::PacketHistory(uint32_t size) : recentPacketsCapacity(0), recentPackets(NULL) // Initialize members
 {
-    if (size < 4 || size > PACKETHISTORY_MAX) { // Copilot suggested - makes sense
+    if (size < 4 || size > PACKETHISTORY_MAX || size >= PACKETHISTORY_INDEX_EMPTY) { // Copilot suggested - makes sense
         LOG_WARN("Packet History - Invalid size %d, using default %d", size, PACKETHISTORY_MAX);
         size = PACKETHISTORY_MAX; // Use default size if invalid
     }
@@ -35,6 +38,26 @@ PacketHistory::PacketHistory(uint32_t size) : recentPacketsCapacity(0), recentPa
 
     // Initialize the recent packets array to zero
     memset(recentPackets, 0, sizeof(PacketRecord) * recentPacketsCapacity);
+
+    // Index twice as large as the history (rounded up to a power of 2) so probe chains stay short
+    uint32_t indexSize = 8;
+    while (indexSize < recentPacketsCapacity * 2)
+        indexSize <<= 1;
+    recentIndex = new uint16_t[indexSize];
+    if (!recentIndex) {
+        LOG_ERROR("Packet History - Memory allocation failed for index size=%d entries / %d Bytes", indexSize,
+                  sizeof(uint16_t) * indexSize);
+        delete[] recentPackets;
+        recentPackets = NULL;
+        recentPacketsCapacity = 0; // mark allocation fail
+        return;
+    }
+    recentIndexMask = indexSize - 1;
+    recentIndexShift = 32;
+    for (uint32_t size = indexSize; size > 1; size >>= 1)
+        recentIndexShift--;
+    for (uint32_t i = 0; i < indexSize; i++)
+        recentIndex[i] = PACKETHISTORY_INDEX_EMPTY;
 }
 
 PacketHistory::~PacketHistory()
@@ -42,11 +65,15 @@ PacketHistory::~PacketHistory()
     recentPacketsCapacity = 0;
     delete[] recentPackets;
     recentPackets = NULL;
+    delete[] recentIndex;
+    recentIndex = NULL;
 }
 
 /** Update recentPackets and return true if we have already seen this packet */
 bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpdate, bool *wasFallback, bool *weWereNextHop)
 {
+    LATENCY_SCOPE(LATENCY_HISTORY_LOOKUP);
+
     if (!initOk()) {
         LOG_ERROR("Packet History - Was Seen Recently: NOT INITIALIZED!");
         return false;
@@ -161,15 +188,17 @@ PacketHistory::PacketRecord *PacketHistory::find(NodeNum sender, PacketId id)
         return NULL;
     }
 
-    PacketRecord *it = NULL;
-    for (it = recentPackets; it < (recentPackets + recentPacketsCapacity); ++it) {
+    // The index is never more than half full, so this always ends on an empty entry
+    for (uint32_t i = indexHome(sender, id);; i = (i + 1) & recentIndexMask) {
+        if (recentIndex[i] == PACKETHISTORY_INDEX_EMPTY)
+            break;
+        PacketRecord *it = &recentPackets[recentIndex[i]];
         if (it->id == id && it->sender == sender) {
 #if VERBOSE_PACKET_HISTORY
             LOG_DEBUG("Packet History - find: s=%08x id=%08x FOUND nh=%02x rby=%02x %02x %02x age=%d slot=%d/%d", it->sender,
                       it->id, it->next_hop, it->relayed_by[0], it->relayed_by[1], it->relayed_by[2], millis() - (it->rxTimeMsec),
                       it - recentPackets, recentPacketsCapacity);
 #endif
-            // only the first match is returned, so be careful not to create duplicate entries
             return it; // Return pointer to the found record
         }
     }
@@ -180,54 +209,38 @@ PacketHistory::PacketRecord *PacketHistory::find(NodeNum sender, PacketId id)
     return NULL; // Not found
 }
 
-/** Insert/Replace oldest PacketRecord in recentPackets. */
+/** Update the matching PacketRecord in place, or replace the oldest one in the ring. */
 void PacketHistory::insert(PacketRecord &r)
 {
     uint32_t now_millis = millis(); // Should not jump with time changes
     uint32_t OldtrxTimeMsec = 0;
-    PacketRecord *tu = NULL; // Will insert here.
-    PacketRecord *it = NULL;
+    PacketRecord *tu = find(r.sender, r.id); // Will insert here. A matching record is updated in place
 
-    // Find a free, matching or oldest used slot in the recentPackets array
-    for (it = recentPackets; it < (recentPackets + recentPacketsCapacity); ++it) {
-        if (it->id == 0 && it->sender == 0 /*&& rxTimeMsec == 0*/) { // Record is empty
-            tu = it;                                                 // Remember the free slot
-#if VERBOSE_PACKET_HISTORY >= 2
-            LOG_DEBUG("Packet History - insert: Free slot@ %d/%d", tu - recentPackets, recentPacketsCapacity);
-#endif
-            // We have that, Exit the loop
-            it = (recentPackets + recentPacketsCapacity);
-        } else if (it->id == r.id && it->sender == r.sender) { // Record matches the packet we want to insert
-            tu = it;                                           // Remember the matching slot
-            OldtrxTimeMsec = now_millis - it->rxTimeMsec;      // ..and save current entry's age
+    if (tu != NULL) {
+        OldtrxTimeMsec = now_millis - tu->rxTimeMsec; // ..and save current entry's age
 #if VERBOSE_PACKET_HISTORY >= 2
-            LOG_DEBUG("Packet History - insert: Matched slot@ %d/%d age=%d", tu - recentPackets, recentPacketsCapacity,
-                      OldtrxTimeMsec);
+        LOG_DEBUG("Packet History - insert: Matched slot@ %d/%d age=%d", tu - recentPackets, recentPacketsCapacity,
+                  OldtrxTimeMsec);
 #endif
-            // We have that, Exit the loop
-            it = (recentPackets + recentPacketsCapacity);
-        } else {
-            if (it->rxTimeMsec == 0) {
-                LOG_WARN(
-                    "Packet History - insert: Found packet s=%08x id=%08x with rxTimeMsec = 0, slot %d/%d. Should never happen!",
-                    it->sender, it->id, it - recentPackets, recentPacketsCapacity);
+    } else {
+        // Records are written in arrival order, so the ring cursor is either free or the oldest record
+        tu = &recentPackets[nextSlot];
+        if (!(tu->id == 0 && tu->sender == 0)) {
+            if (tu->rxTimeMsec == 0) {
+                LOG_WARN("Packet History - insert: Found packet s=%08x id=%08x with rxTimeMsec = 0, slot %d/%d. Should never "
+                         "happen!",
+                         tu->sender, tu->id, nextSlot, recentPacketsCapacity);
             }
-            if ((now_millis - it->rxTimeMsec) > OldtrxTimeMsec) { // 49.7 days rollover friendly
-                OldtrxTimeMsec = now_millis - it->rxTimeMsec;
-                tu = it; // remember the oldest packet
+            OldtrxTimeMsec = now_millis - tu->rxTimeMsec; // 49.7 days rollover friendly
 #if VERBOSE_PACKET_HISTORY >= 2
-                LOG_DEBUG("Packet History - insert: Older slot@ %d/%d age=%d", tu - recentPackets, recentPacketsCapacity,
-                          OldtrxTimeMsec);
+            LOG_DEBUG("Packet History - insert: Older slot@ %d/%d age=%d", nextSlot, recentPacketsCapacity, OldtrxTimeMsec);
 #endif
-            }
-            // keep looking for oldest till entire array is checked
         }
-    }
-
-    if (tu == NULL) {
-        LOG_ERROR("Packet History - insert: No free slot, no matched packet, no oldest to reuse. Something leaked."); // mx
-        // assert(false); // This should never happen, we should always have at least one packet to clear
-        return; // Return early if we can't update the history
+#if VERBOSE_PACKET_HISTORY >= 2
+        else {
+            LOG_DEBUG("Packet History - insert: Free slot@ %d/%d", nextSlot, recentPacketsCapacity);
+        }
+#endif
     }
 
 #if VERBOSE_PACKET_HISTORY
@@ -279,7 +292,15 @@ void PacketHistory::insert(PacketRecord &r)
         return; // Return early if we can't update the history
     }
 
-    *tu = r; // store the packet
+    if (tu->id == r.id && tu->sender == r.sender) {
+        *tu = r; // update the packet, key and index entry are unchanged
+    } else {
+        if (!(tu->id == 0 && tu->sender == 0))
+            indexRemove(nextSlot); // evict the oldest packet
+        *tu = r;                   // store the packet
+        indexAdd(nextSlot);
+        nextSlot = (nextSlot + 1) % recentPacketsCapacity;
+    }
 
 #if VERBOSE_PACKET_HISTORY
     LOG_DEBUG("Packet History - insert: Store slot@ %d/%d s=%08x id=%08x nh=%02x rby=%02x %02x %02x rxT=%d AFTER",
@@ -382,3 +403,46 @@ void PacketHistory::removeRelayer(const uint8_t relayer, const uint32_t id, cons
               found->id, found->relayed_by[0], found->relayed_by[1], found->relayed_by[2], relayer, i != j);
 #endif
 }
+
+/** @return the home position in recentIndex for a (sender,id) key */
+uint32_t PacketHistory::indexHome(NodeNum sender, PacketId id) const
+{
+    // Packet ids are mostly sequential per sender, mix both and keep the well distributed high bits (Fibonacci hashing)
+    uint32_t h = ((sender * 0x9E3779B1u) ^ id) * 0x9E3779B9u;
+    return h >> recentIndexShift;
+}
+
+/** Add the record stored in recentPackets[slot] to recentIndex */
+void PacketHistory::indexAdd(uint32_t slot)
+{
+    uint32_t i = indexHome(recentPackets[slot].sender, recentPackets[slot].id);
+    while (recentIndex[i] != PACKETHISTORY_INDEX_EMPTY)
+        i = (i + 1) & recentIndexMask;
+    recentIndex[i] = (uint16_t)slot;
+}
+
+/** Remove the record stored in recentPackets[slot] from recentIndex.
+ * Uses backward shift deletion, so linear probing never needs tombstones. */
+void PacketHistory::indexRemove(uint32_t slot)
+{
+    uint32_t i = indexHome(recentPackets[slot].sender, recentPackets[slot].id);
+    while (recentIndex[i] != slot) {
+        if (recentIndex[i] == PACKETHISTORY_INDEX_EMPTY) {
+            LOG_ERROR("Packet History - index: slot %d missing from index", slot);
+            return;
+        }
+        i = (i + 1) & recentIndexMask;
+    }
+
+    // Pull later entries of the probe chain back into the hole, unless that would move them before their home position
+    for (uint32_t j = (i + 1) & recentIndexMask; recentIndex[j] != PACKETHISTORY_INDEX_EMPTY; j = (j + 1) & recentIndexMask) {
+        PacketRecord &moved = recentPackets[recentIndex[j]];
+        uint32_t home = indexHome(moved.sender, moved.id);
+        bool homeInHole = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+        if (homeInHole) {
+            recentIndex[i] = recentIndex[j];
+            i = j;
+        }
+    }
+    recentIndex[i] = PACKETHISTORY_INDEX_EMPTY;
+}
@@ -19,9 +19,24 @@ class PacketHistory
         uint8_t relayed_by[NUM_RELAYERS]; // Array of nodes that relayed this packet
     };                                    // 4B + 4B + 4B + 1B + 3B = 16B
 
+    static_assert(sizeof(PacketRecord) == 16, "PacketRecord must stay 16 bytes");
+
     uint32_t recentPacketsCapacity =
         0; // Can be set in constructor, no need to recompile. Used to allocate memory for mx_recentPackets.
-    PacketRecord *recentPackets = NULL; // Simple and fixed in size. Debloat.
+    PacketRecord *recentPackets = NULL; // Simple and fixed in size. Debloat. Used as a ring buffer.
+    uint32_t nextSlot = 0;              // Ring cursor: next slot to (re)use, which holds the oldest record once full
+
+    // Open addressing index (sender,id) -> slot in recentPackets, kept at most half full, 2B per entry
+    uint16_t *recentIndex = NULL;
+    uint32_t recentIndexMask = 0;
+    uint8_t recentIndexShift = 32; // 32 - log2 of the index size, the hash keeps the bits above it
+
+    /** @return the home position in recentIndex for a (sender,id) key */
+    uint32_t indexHome(NodeNum sender, PacketId id) const;
+
+    /** Add / remove the record stored in recentPackets[slot] to / from recentIndex */
+    void indexAdd(uint32_t slot);
+    void indexRemove(uint32_t slot);
 
     /** Find a packet record in history.
      * @param sender NodeNum
@@ -29,7 +44,7 @@ class PacketHistory
      * @return pointer to PacketRecord if found, NULL if not found */
     PacketRecord *find(NodeNum sender, PacketId id);
 
-    /** Insert/Replace oldest PacketRecord in mx_recentPackets.
+    /** Update the matching PacketRecord in place, or replace the oldest one in the ring.
      * @param r PacketRecord to insert or replace */
     void insert(PacketRecord &r); // Insert or replace a packet record in the history
 
@@ -61,5 +76,5 @@ class PacketHistory
     void removeRelayer(const uint8_t relayer, const uint32_t id, const NodeNum sender);
 
     // To check if the PacketHistory was initialized correctly by constructor
-    bool initOk(void) { return recentPackets != NULL && recentPacketsCapacity != 0; }
+    bool initOk(void) { return recentPackets != NULL && recentIndex != NULL && recentPacketsCapacity != 0; }
 };
@@ -6,6 +6,7 @@
 #include "Channels.h"
 #include "Default.h"
 #include "FSCommon.h"
+#include "LatencyStats.h"
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "PacketHistory.h"
@@ -17,6 +18,7 @@
 #include "TypeConversions.h"
 #include "main.h"
 #include "xmodem.h"
+#include <pb_encode.h>
 
 #if FromRadio_size > MAX_TO_FROM_RADIO_SIZE
 #error FromRadio is too big
@@ -48,6 +50,7 @@ void PhoneAPI::handleStartConfig()
     if (!isConnected()) {
         onConnectionChanged(true);
         observe(&service->fromNumChanged);
+        service->addPhoneCursor(&phoneCursor);
 #ifdef FSCom
         observe(&xModem.packetReady);
 #endif
@@ -68,7 +71,7 @@ void PhoneAPI::handleStartConfig()
     LOG_DEBUG("Got %d files in manifest", filesManifest.size());
 
     LOG_INFO("Start API client config");
-    nodeInfoForPhone.num = 0; // Don't keep returning old nodeinfos
+    configStartMsec = millis();
     resetReadIndex();
 }
 
@@ -80,6 +83,7 @@ void PhoneAPI::close()
         state = STATE_SEND_NOTHING;
         resetReadIndex();
         unobserve(&service->fromNumChanged);
+        service->removePhoneCursor(&phoneCursor);
 #ifdef FSCom
         unobserve(&xModem.packetReady);
 #endif
@@ -90,7 +94,6 @@ void PhoneAPI::close()
         onConnectionChanged(false);
         fromRadioScratch = {};
         toRadioScratch = {};
-        nodeInfoForPhone = {};
         packetForPhone = NULL;
         filesManifest.clear();
         fromRadioNum = 0;
@@ -221,21 +224,18 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
     case STATE_SEND_OWN_NODEINFO: {
         LOG_DEBUG("Send My NodeInfo");
         auto us = nodeDB->readNextMeshNode(readIndex);
-        if (us) {
-            nodeInfoForPhone = TypeConversions::ConvertToNodeInfo(us);
-            nodeInfoForPhone.has_hops_away = false;
-            nodeInfoForPhone.is_favorite = true;
-            fromRadioScratch.which_payload_variant = meshtastic_FromRadio_node_info_tag;
-            fromRadioScratch.node_info = nodeInfoForPhone;
-            // Should allow us to resume sending NodeInfo in STATE_SEND_OTHER_NODEINFOS
-            nodeInfoForPhone.num = 0;
-        }
         if (config_nonce == SPECIAL_NONCE_ONLY_NODES) {
             // If client only wants node info, jump directly to sending nodes
             state = STATE_SEND_OTHER_NODEINFOS;
         } else {
             state = STATE_SEND_METADATA;
         }
+        if (us) {
+            meshtastic_NodeInfo info = TypeConversions::ConvertToNodeInfo(us);
+            info.has_hops_away = false;
+            info.is_favorite = true;
+            return encodeNodeInfo(buf, info);
+        }
         break;
     }
 
@@ -412,21 +412,26 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
         break;
 
     case STATE_SEND_OTHER_NODEINFOS: {
-        LOG_DEBUG("Send known nodes");
-        if (nodeInfoForPhone.num != 0) {
-            LOG_INFO("nodeinfo: num=0x%x, lastseen=%u, id=%s, name=%s", nodeInfoForPhone.num, nodeInfoForPhone.last_heard,
-                     nodeInfoForPhone.user.id, nodeInfoForPhone.user.long_name);
-            fromRadioScratch.which_payload_variant = meshtastic_FromRadio_node_info_tag;
-            fromRadioScratch.node_info = nodeInfoForPhone;
+        auto node = nodeDB->readNextMeshNode(readIndex);
+        if (node) {
             // Stay in current state until done sending nodeinfos
-            nodeInfoForPhone.num = 0; // We just consumed a nodeinfo, will need a new one next time
-        } else {
-            LOG_DEBUG("Done sending nodeinfo");
-            state = STATE_SEND_FILEMANIFEST;
-            // Go ahead and send that ID right now
-            return getFromRadio(buf);
+            meshtastic_NodeInfo info = TypeConversions::ConvertToNodeInfo(node);
+            bool isUs = info.num == nodeDB->getNodeNum();
+            if (isUs) {
+                info.hops_away = 0;
+                info.last_heard = getValidTime(RTCQualityFromNet);
+                info.snr = 0;
+                info.via_mqtt = false;
+                info.is_favorite = true; // Our node is always a favorite
+            }
+            LOG_DEBUG("nodeinfo: num=0x%x, lastseen=%u, id=%s, name=%s", info.num, info.last_heard, info.user.id,
+                      info.user.long_name);
+            return encodeNodeInfo(buf, info);
         }
-        break;
+        LOG_DEBUG("Done sending nodeinfo");
+        state = STATE_SEND_FILEMANIFEST;
+        // Go ahead and send that ID right now
+        return getFromRadio(buf);
     }
 
     case STATE_SEND_FILEMANIFEST: {
@@ -499,9 +504,23 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
     return 0;
 }
 
+size_t PhoneAPI::encodeNodeInfo(uint8_t *buf, const meshtastic_NodeInfo &info)
+{
+    // Same bytes as encoding a FromRadio with only node_info set, minus the copies into and out of fromRadioScratch
+    pb_ostream_t stream = pb_ostream_from_buffer(buf, meshtastic_FromRadio_size);
+    if (!pb_encode_tag(&stream, PB_WT_STRING, meshtastic_FromRadio_node_info_tag) ||
+        !pb_encode_submessage(&stream, meshtastic_NodeInfo_fields, &info)) {
+        LOG_ERROR("Can't encode nodeinfo 0x%x: %s", info.num, PB_GET_ERROR(&stream));
+        return 0;
+    }
+    return stream.bytes_written;
+}
+
 void PhoneAPI::sendConfigComplete()
 {
-    LOG_INFO("Config Send Complete");
+    uint32_t configMsec = millis() - configStartMsec;
+    LOG_INFO("Config Send Complete in %u ms, %u nodes", configMsec, (uint32_t)nodeDB->getNumMeshNodes());
+    LATENCY_RECORD(LATENCY_CONFIG_COMPLETE, configMsec * 1000);
     fromRadioScratch.which_payload_variant = meshtastic_FromRadio_config_complete_id_tag;
     fromRadioScratch.config_complete_id = config_nonce;
     config_nonce = 0;
@@ -561,18 +580,6 @@ bool PhoneAPI::available()
         return true;
 
     case STATE_SEND_OTHER_NODEINFOS:
-        if (nodeInfoForPhone.num == 0) {
-            auto nextNode = nodeDB->readNextMeshNode(readIndex);
-            if (nextNode) {
-                nodeInfoForPhone = TypeConversions::ConvertToNodeInfo(nextNode);
-                bool isUs = nodeInfoForPhone.num == nodeDB->getNodeNum();
-                nodeInfoForPhone.hops_away = isUs ? 0 : nodeInfoForPhone.hops_away;
-                nodeInfoForPhone.last_heard = isUs ? getValidTime(RTCQualityFromNet) : nodeInfoForPhone.last_heard;
-                nodeInfoForPhone.snr = isUs ? 0 : nodeInfoForPhone.snr;
-                nodeInfoForPhone.via_mqtt = isUs ? false : nodeInfoForPhone.via_mqtt;
-                nodeInfoForPhone.is_favorite = nodeInfoForPhone.is_favorite || isUs; // Our node is always a favorite
-            }
-        }
         return true; // Always say we have something, because we might need to advance our state machine
     case STATE_SEND_PACKETS: {
         if (!queueStatusPacketForPhone)
@@ -603,7 +610,7 @@ bool PhoneAPI::available()
 #endif
 
         if (!packetForPhone)
-            packetForPhone = service->getForPhone();
+            packetForPhone = service->getForPhone(&phoneCursor);
         hasPacket = !!packetForPhone;
         return hasPacket;
     }
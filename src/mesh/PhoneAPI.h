@@ -65,6 +65,9 @@ class PhoneAPI
     /// downloads it
     meshtastic_MeshPacket *packetForPhone = NULL;
 
+    /// Our position in the packets MeshService keeps for the phone, registered while we are connected
+    uint32_t phoneCursor = 0;
+
     // file transfer packets destined for phone. Push it to the queue then free it.
     meshtastic_XModem xmodemPacketForPhone = meshtastic_XModem_init_zero;
 
@@ -77,15 +80,13 @@ class PhoneAPI
     // Keep ClientNotification packet just as packetForPhone
     meshtastic_ClientNotification *clientNotification = NULL;
 
-    /// We temporarily keep the nodeInfo here between the call to available and getFromRadio
-    meshtastic_NodeInfo nodeInfoForPhone = meshtastic_NodeInfo_init_default;
-
     meshtastic_ToRadio toRadioScratch = {
         0}; // this is a static scratch object, any data must be copied elsewhere before returning
 
     /// Use to ensure that clients don't get confused about old messages from the radio
     uint32_t config_nonce = 0;
     uint32_t readIndex = 0;
+    uint32_t configStartMsec = 0; // When the client asked for its config, to time the handshake
 
     std::vector<meshtastic_FileInfo> filesManifest = {};
 
@@ -154,6 +155,9 @@ class PhoneAPI
     void handleStartConfig();
 
   private:
+    /// Encode a FromRadio holding only info into buf, without going through fromRadioScratch
+    size_t encodeNodeInfo(uint8_t *buf, const meshtastic_NodeInfo &info);
+
     void releasePhonePacket();
 
     void releaseQueueStatusPhonePacket();
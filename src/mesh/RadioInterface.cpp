@@ -206,6 +206,12 @@ separated by 2.16 MHz with respect to the adjacent channels. Channel zero starts
  * @return num msecs for the packet
  */
 uint32_t RadioInterface::getPacketTime(uint32_t pl)
+{
+    return getPacketTime(pl, bw, sf, cr, preambleLength);
+}
+
+/// Same as getPacketTime(pl) but for explicit modem settings, so it can be used without a radio (e.g. by the mesh simulator)
+uint32_t RadioInterface::getPacketTime(uint32_t pl, float bw, uint8_t sf, uint8_t cr, uint16_t preambleLength)
 {
     float bandwidthHz = bw * 1000.0f;
     bool headDisable = false; // we currently always use the header
@@ -244,10 +250,8 @@ uint32_t RadioInterface::getRetransmissionMsec(const meshtastic_MeshPacket *p)
     // Make sure enough time has elapsed for this packet to be sent and an ACK is received.
     // LOG_DEBUG("Waiting for flooding message with airtime %d and slotTime is %d", packetAirtime, slotTimeMsec);
     float channelUtil = airTime->channelUtilizationPercent();
-    uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
-    // Assuming we pick max. of CWsize and there will be a client with SNR at half the range
-    return 2 * packetAirtime + (pow(2, CWsize) + 2 * CWmax + pow(2, int((CWmax + CWmin) / 2))) * slotTimeMsec +
-           PROCESSING_TIME_MSEC;
+    uint8_t CWsize = computeCWsizeForUtil(channelUtil, getCWmin(), getCWmax());
+    return computeRetransmissionMsec(packetAirtime, CWsize, getSlotTimeMsec(), slotTimeMsec);
 }
 
 /** The delay to use when we want to send something */
@@ -257,21 +261,28 @@ uint32_t RadioInterface::getTxDelayMsec()
     The pool to take a random multiple from is the contention window (CW), which size depends on the
     current channel utilization. */
     float channelUtil = airTime->channelUtilizationPercent();
-    uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
+    uint8_t CWsize = computeCWsizeForUtil(channelUtil, getCWmin(), getCWmax());
     // LOG_DEBUG("Current channel utilization is %f so setting CWsize to %d", channelUtil, CWsize);
-    return random(0, pow(2, CWsize)) * slotTimeMsec;
+    return computeTxDelayMsec(CWsize, getSlotTimeMsec(), [](uint32_t n) { return (uint32_t)random(0, n); });
 }
 
-/** The CW size to use when calculating SNR_based delays */
-uint8_t RadioInterface::getCWsize(float snr)
+/** The CW size for SNR based delays, high SNR gives a large window. SNR outside the LoRa range is clamped to it */
+uint8_t RadioInterface::computeCWsizeForSnr(float snr, uint8_t cwMin, uint8_t cwMax)
 {
     // The minimum value for a LoRa SNR
-    const uint32_t SNR_MIN = -20;
+    const int32_t SNR_MIN = -20;
 
     // The maximum value for a LoRa SNR
-    const uint32_t SNR_MAX = 10;
+    const int32_t SNR_MAX = 10;
 
-    return map(snr, SNR_MIN, SNR_MAX, CWmin, CWmax);
+    int32_t s = std::max(SNR_MIN, std::min(SNR_MAX, (int32_t)snr));
+    return map(s, SNR_MIN, SNR_MAX, cwMin, cwMax);
+}
+
+/** The CW size to use when calculating SNR_based delays */
+uint8_t RadioInterface::getCWsize(float snr)
+{
+    return computeCWsizeForSnr(snr, getCWmin(), getCWmax());
 }
 
 /** The worst-case SNR_based packet delay */
@@ -279,7 +290,7 @@ uint32_t RadioInterface::getTxDelayMsecWeightedWorst(float snr)
 {
     uint8_t CWsize = getCWsize(snr);
     // offset the maximum delay for routers: (2 * CWmax * slotTimeMsec)
-    return (2 * CWmax * slotTimeMsec) + pow(2, CWsize) * slotTimeMsec;
+    return (2 * CWmax * slotTimeMsec) + pow(2, CWsize) * getSlotTimeMsec();
 }
 
 /** The delay to use when we want to flood a message */
@@ -287,18 +298,16 @@ uint32_t RadioInterface::getTxDelayMsecWeighted(float snr)
 {
     //  high SNR = large CW size (Long Delay)
     //  low SNR = small CW size (Short Delay)
-    uint32_t delay = 0;
     uint8_t CWsize = getCWsize(snr);
     // LOG_DEBUG("rx_snr of %f so setting CWsize to:%d", snr, CWsize);
-    if (config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER ||
-        config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER) {
-        delay = random(0, 2 * CWsize) * slotTimeMsec;
+    bool isRouter = config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER ||
+                    config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER;
+    uint32_t delay = computeTxDelayMsecWeighted(isRouter, CWsize, getSlotTimeMsec(), slotTimeMsec,
+                                                [](uint32_t n) { return (uint32_t)random(0, n); });
+    if (isRouter)
         LOG_DEBUG("rx_snr found in packet. Router: setting tx delay:%d", delay);
-    } else {
-        // offset the maximum delay for routers: (2 * CWmax * slotTimeMsec)
-        delay = (2 * CWmax * slotTimeMsec) + random(0, pow(2, CWsize)) * slotTimeMsec;
+    else
         LOG_DEBUG("rx_snr found in packet. Setting tx delay:%d", delay);
-    }
 
     return delay;
 }
@@ -594,11 +603,17 @@ void RadioInterface::applyModemConfig()
   - Tx/Rx turnaround time (maximum of SX126x and SX127x);
   - MAC processing time (measured on T-beam) */
 uint32_t RadioInterface::computeSlotTimeMsec()
+{
+    return computeSlotTimeMsec(bw, sf, myRegion->wideLora);
+}
+
+/// Same as computeSlotTimeMsec() but for explicit modem settings
+uint32_t RadioInterface::computeSlotTimeMsec(float bw, uint8_t sf, bool wideLora)
 {
     float sumPropagationTurnaroundMACTime = 0.2 + 0.4 + 7; // in milliseconds
     float symbolTime = pow(2, sf) / bw;                    // in milliseconds
 
-    if (myRegion->wideLora) {
+    if (wideLora) {
         // CAD duration derived from AN1200.22 of SX1280
         return (NUM_SYM_CAD_24GHZ + (2 * sf + 3) / 32) * symbolTime + sumPropagationTurnaroundMACTime;
     } else {
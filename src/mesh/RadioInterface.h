@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ContentionEstimator.h"
 #include "MemoryPool.h"
 #include "MeshTypes.h"
 #include "Observer.h"
@@ -77,6 +78,53 @@ class RadioInterface
     CallbackObserver<RadioInterface, void *> notifyDeepSleepObserver =
         CallbackObserver<RadioInterface, void *>(this, &RadioInterface::notifyDeepSleepCb);
 
+  public:
+    static constexpr uint32_t PROCESSING_TIME_MSEC =
+        4500;                           // time to construct, process and construct a packet again (empirically determined)
+    static constexpr uint8_t CWmin = 3; // minimum CWsize
+    static constexpr uint8_t CWmax = 8; // maximum CWsize
+
+    /*
+     * Contention window math, static so the mesh simulator (MeshSim) runs exactly the same formulas. rand(n) must return a
+     * uniform value in [0, n), slotMsec is the slot time in use and fixedSlotMsec the one the fixed CW bounds are timed with
+     * (they differ in adaptive mode).
+     */
+
+    /** The CW size for the current channel utilization (percent) */
+    static uint8_t computeCWsizeForUtil(float channelUtil, uint8_t cwMin, uint8_t cwMax)
+    {
+        return map(channelUtil, 0, 100, cwMin, cwMax);
+    }
+
+    /** The CW size for SNR based delays, high SNR gives a large window. SNR outside the LoRa range is clamped to it */
+    static uint8_t computeCWsizeForSnr(float snr, uint8_t cwMin, uint8_t cwMax);
+
+    /** The delay to use for retransmitting dropped packets */
+    static uint32_t computeRetransmissionMsec(uint32_t packetAirtime, uint8_t CWsize, uint32_t slotMsec, uint32_t fixedSlotMsec)
+    {
+        // Assuming we pick max. of CWsize and there will be a client with SNR at half the range
+        return 2 * packetAirtime + (1UL << CWsize) * slotMsec + (2 * CWmax + (1UL << ((CWmax + CWmin) / 2))) * fixedSlotMsec +
+               PROCESSING_TIME_MSEC;
+    }
+
+    /** The delay to use when we want to send something, a random number of slots in the CW */
+    template <typename Rand> static uint32_t computeTxDelayMsec(uint8_t CWsize, uint32_t slotMsec, Rand rand)
+    {
+        return rand(1UL << CWsize) * slotMsec;
+    }
+
+    /** The delay to use when we want to flood a message. Routers and repeaters pick from a small window, everyone else
+     * waits for the largest router window first (from the fixed bounds, so routers keep their head start over adaptive
+     * clients) */
+    template <typename Rand>
+    static uint32_t computeTxDelayMsecWeighted(bool isRouter, uint8_t CWsize, uint32_t slotMsec, uint32_t fixedSlotMsec,
+                                               Rand rand)
+    {
+        if (isRouter)
+            return rand(2 * CWsize) * slotMsec;
+        return (2 * CWmax * fixedSlotMsec) + rand(1UL << CWsize) * slotMsec;
+    }
+
   protected:
     bool disabled = false;
 
@@ -84,16 +132,22 @@ class RadioInterface
     uint8_t sf = 9;
     uint8_t cr = 5;
 
-    const uint8_t NUM_SYM_CAD = 2;       // Number of symbols used for CAD, 2 is the default since RadioLib 6.3.0 as per AN1200.48
-    const uint8_t NUM_SYM_CAD_24GHZ = 4; // Number of symbols used for CAD in 2.4 GHz, 4 is recommended in AN1200.22 of SX1280
+    // Number of symbols used for CAD, 2 is the default since RadioLib 6.3.0 as per AN1200.48
+    static const uint8_t NUM_SYM_CAD = 2;
+    // Number of symbols used for CAD in 2.4 GHz, 4 is recommended in AN1200.22 of SX1280
+    static const uint8_t NUM_SYM_CAD_24GHZ = 4;
     uint32_t slotTimeMsec = computeSlotTimeMsec();
     uint16_t preambleLength = 16;      // 8 is default, but we use longer to increase the amount of sleep time when receiving
     uint32_t preambleTimeMsec = 165;   // calculated on startup, this is the default for LongFast
     uint32_t maxPacketTimeMsec = 3246; // calculated on startup, this is the default for LongFast
-    const uint32_t PROCESSING_TIME_MSEC =
-        4500;                // time to construct, process and construct a packet again (empirically determined)
-    const uint8_t CWmin = 3; // minimum CWsize
-    const uint8_t CWmax = 8; // maximum CWsize
+    /// Fed by the subclasses with every transmit attempt and received frame, whether or not adaptiveContention is set
+    ContentionEstimator contention = ContentionEstimator(CWmin, CWmax);
+    // Size the contention window from the estimator instead of the fixed bounds, build with -DADAPTIVE_CONTENTION_WINDOW
+#ifdef ADAPTIVE_CONTENTION_WINDOW
+    bool adaptiveContention = true;
+#else
+    bool adaptiveContention = false;
+#endif
 
     meshtastic_MeshPacket *sendingPacket = NULL; // The packet we are currently sending
     uint32_t lastTxStart = 0L;
@@ -177,6 +231,13 @@ class RadioInterface
     /** The CW to use when calculating SNR_based delays */
     uint8_t getCWsize(float snr);
 
+    /** The CW bounds and slot time in use, adjusted by the contention estimator in adaptive mode */
+    uint8_t getCWmin() const { return adaptiveContention ? contention.getCWmin() : CWmin; }
+    uint8_t getCWmax() const { return adaptiveContention ? contention.getCWmax() : CWmax; }
+    uint32_t getSlotTimeMsec() const { return adaptiveContention ? contention.getSlotTimeMsec(slotTimeMsec) : slotTimeMsec; }
+
+    const ContentionEstimator &getContention() const { return contention; }
+
     /** The worst-case SNR_based packet delay */
     uint32_t getTxDelayMsecWeightedWorst(float snr);
 
@@ -196,6 +257,10 @@ class RadioInterface
     uint32_t getPacketTime(const meshtastic_MeshPacket *p);
     uint32_t getPacketTime(uint32_t totalPacketLen);
 
+    /// Airtime and slot time for explicit modem settings, usable without a radio instance
+    static uint32_t getPacketTime(uint32_t totalPacketLen, float bw, uint8_t sf, uint8_t cr, uint16_t preambleLength);
+    static uint32_t computeSlotTimeMsec(float bw, uint8_t sf, bool wideLora);
+
     /**
      * Get the channel we saved.
      */
@@ -1,4 +1,5 @@
 #include "RadioLibInterface.h"
+#include "LatencyStats.h"
 #include "MeshTypes.h"
 #include "NodeDB.h"
 #include "PowerMon.h"
@@ -53,8 +54,13 @@ RadioLibInterface::RadioLibInterface(LockingArduinoHal *hal, RADIOLIB_PIN_TYPE c
 #define YIELD_FROM_ISR(x) portYIELD_FROM_ISR(x)
 #endif
 
+volatile uint32_t RadioLibInterface::isrMicros;
+
 void INTERRUPT_ATTR RadioLibInterface::isrLevel0Common(PendingISR cause)
 {
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+    isrMicros = micros();
+#endif
     instance->disableInterrupt();
 
     BaseType_t xHigherPriorityTaskWoken;
@@ -247,11 +253,13 @@ void RadioLibInterface::onNotify(uint32_t notification)
 {
     switch (notification) {
     case ISR_TX:
+        LATENCY_RECORD(LATENCY_RADIO_ISR, micros() - isrMicros);
         handleTransmitInterrupt();
         startReceive();
         setTransmitDelay();
         break;
     case ISR_RX:
+        LATENCY_RECORD(LATENCY_RADIO_ISR, micros() - isrMicros);
         handleReceiveInterrupt();
         startReceive();
         setTransmitDelay();
@@ -262,6 +270,7 @@ void RadioLibInterface::onNotify(uint32_t notification)
         // has placed the unit into standby)  FIXME, how will this work if the chipset is in sleep mode?
         if (!txQueue.empty()) {
             if (!canSendImmediately()) {
+                contention.txAttempt(true);
                 setTransmitDelay(); // currently Rx/Tx-ing: reset random delay
             } else {
                 meshtastic_MeshPacket *txp = txQueue.getFront();
@@ -272,9 +281,11 @@ void RadioLibInterface::onNotify(uint32_t notification)
                     notifyLater(delay_remaining, TRANSMIT_DELAY_COMPLETED, false);
                 } else {
                     if (isChannelActive()) { // check if there is currently a LoRa packet on the channel
-                        startReceive();      // try receiving this packet, afterwards we'll be trying to transmit again
+                        contention.txAttempt(true);
+                        startReceive(); // try receiving this packet, afterwards we'll be trying to transmit again
                         setTransmitDelay();
                     } else {
+                        contention.txAttempt(false);
                         // Send any outgoing packets we have ready as fast as possible to keep the time between channel scan and
                         // actual transmission as short as possible
                         txp = txQueue.dequeue();
@@ -424,6 +435,7 @@ void RadioLibInterface::handleReceiveInterrupt()
     if (state != RADIOLIB_ERR_NONE) {
         LOG_ERROR("Ignore received packet due to error=%d", state);
         rxBad++;
+        contention.rxFrame(false);
 
         airTime->logAirtime(RX_ALL_LOG, xmitMsec);
 
@@ -435,9 +447,11 @@ void RadioLibInterface::handleReceiveInterrupt()
         if (payloadLen < 0) {
             LOG_WARN("Ignore received packet too short");
             rxBad++;
+            contention.rxFrame(false);
             airTime->logAirtime(RX_ALL_LOG, xmitMsec);
         } else {
             rxGood++;
+            contention.rxFrame(true);
             // altered packet with "from == 0" can do Remote Node Administration without permission
             if (radioBuffer.header.from == 0) {
                 LOG_WARN("Ignore received packet without sender");
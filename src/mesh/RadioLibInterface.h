@@ -58,6 +58,9 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
      */
     static void isrTxLevel0(), isrLevel0Common(PendingISR code);
 
+    /// micros() of the last radio interrupt, for the radio ISR latency probe
+    static volatile uint32_t isrMicros;
+
     MeshPacketQueue txQueue = MeshPacketQueue(MAX_TX_QUEUE);
 
   protected:
@@ -1,6 +1,7 @@
 #include "Router.h"
 #include "Channels.h"
 #include "CryptoEngine.h"
+#include "LatencyStats.h"
 #include "MeshRadio.h"
 #include "MeshService.h"
 #include "NodeDB.h"
@@ -31,8 +32,23 @@
     (MAX_RX_TOPHONE + MAX_RX_FROMRADIO + 2 * MAX_TX_QUEUE +                                                                      \
      2) // max number of packets which can be in flight (either queued from reception or queued for sending)
 
-// static MemoryPool<MeshPacket> staticPool(MAX_PACKETS);
+// Number of packets preallocated in the packet slab, can be overridden per variant but must be a compile time constant, the
+// pool is built during static init. Packets beyond this come from the heap and are counted as failed allocations in
+// packetPool.getStats(). The default covers the radio side of MAX_PACKETS, the phone queue only backs up while no client
+// is connected and uses the heap like before (a full MAX_PACKETS slab is ~24KB held from boot on ESP32).
+#ifndef PACKET_POOL_SIZE
+#if defined(ARCH_NRF52)
+#define PACKET_POOL_SIZE MAX_TX_QUEUE
+#else
+#define PACKET_POOL_SIZE (MAX_RX_FROMRADIO + 2 * MAX_TX_QUEUE + 2)
+#endif
+#endif
+
+#if defined(ARCH_STM32WL) || !HAS_LOCK_FREE_POOL // Not enough RAM, or no lock-free atomics, to reserve packets up front
 static MemoryDynamic<meshtastic_MeshPacket> staticPool;
+#else
+static MemoryPool<meshtastic_MeshPacket> staticPool(PACKET_POOL_SIZE);
+#endif
 
 Allocator<meshtastic_MeshPacket> &packetPool = staticPool;
 
@@ -80,6 +96,8 @@ int32_t Router::runOnce()
  */
 void Router::enqueueReceivedMessage(meshtastic_MeshPacket *p)
 {
+    LATENCY_SCOPE(LATENCY_RX_ENQUEUE);
+
     // Try enqueue until successful
     while (!fromRadioQueue.enqueue(p, 0)) {
         meshtastic_MeshPacket *old_p;
@@ -330,6 +348,7 @@ void Router::sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Rout
 
 DecodeState perhapsDecode(meshtastic_MeshPacket *p)
 {
+    LATENCY_SCOPE(LATENCY_DECODE);
     concurrency::LockGuard g(cryptLock);
 
     if (config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER &&
@@ -387,10 +406,17 @@ DecodeState perhapsDecode(meshtastic_MeshPacket *p)
 
     // assert(p->which_payloadVariant == MeshPacket_encrypted_tag);
     if (!decrypted) {
+        // Only channels whose hash matches can possibly decode this packet, skip the rest without touching crypto
+        uint8_t candidates = channels.getCandidatesForHash(p->channel);
+        uint8_t attempts = 0;
         // Try to find a channel that works with this hash
-        for (chIndex = 0; chIndex < channels.getNumChannels(); chIndex++) {
+        for (chIndex = 0; candidates && chIndex < channels.getNumChannels(); chIndex++) {
+            if (!(candidates & (1 << chIndex)))
+                continue;
+            candidates &= ~(1 << chIndex);
             // Try to use this hash/channel pair
             if (channels.decryptForHash(chIndex, p->channel)) {
+                attempts++;
                 // we have to copy into a scratch buffer, because these bytes are a union with the decoded protobuf. Create a
                 // fresh copy for each decrypt attempt.
                 memcpy(bytes, p->encrypted.bytes, rawSize);
@@ -414,6 +440,10 @@ DecodeState perhapsDecode(meshtastic_MeshPacket *p)
                 }
             }
         }
+        if (router)
+            router->trialDecrypts[attempts]++;
+        if (attempts > 1)
+            LOG_DEBUG("Packet id=0x%08x needed %d trial decrypts", p->id, attempts);
     }
     if (decrypted) {
         // parsing was successful
@@ -91,6 +91,10 @@ class Router : protected concurrency::OSThread, protected PacketHistory
         before us */
     uint32_t rxDupe = 0, txRelayCanceled = 0;
 
+    /* How many channel trial decrypts received packets needed, indexed by the number of attempts. Index 0 counts packets
+        where no channel hash matched, so no crypto was done at all */
+    uint32_t trialDecrypts[MAX_NUM_CHANNELS + 1] = {};
+
   protected:
     friend class RoutingModule;
 
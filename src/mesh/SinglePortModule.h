@@ -23,6 +23,12 @@ class SinglePortModule : public MeshModule
      */
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override { return p->decoded.portnum == ourPortNum; }
 
+    virtual bool getWantedPortNums(std::vector<meshtastic_PortNum> &portNums) override
+    {
+        portNums.push_back(ourPortNum);
+        return true;
+    }
+
     /**
      * Return a mesh packet which has been preinited as a data packet with a particular port number.
      * You can then send this packet (after customizing any of the payload fields you might need) with
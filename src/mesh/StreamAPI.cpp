@@ -21,86 +21,146 @@ int32_t StreamAPI::runOncePart()
  */
 int32_t StreamAPI::readStream()
 {
-    if (!stream->available()) {
+    int avail = stream->available();
+    if (avail <= 0) {
         // Nothing available this time, if the computer has talked to us recently, poll often, otherwise let CPU sleep a long time
         bool recentRx = Throttle::isWithinTimespanMs(lastRxMsec, 2000);
         return recentRx ? 5 : 250;
     } else {
-        while (stream->available()) { // Currently we never want to block
-            int cInt = stream->read();
-            if (cInt < 0)
-                break; // We ran out of characters (even though available said otherwise) - this can happen on rf52 adafruit
-                       // arduino
+        uint8_t chunk[STREAM_RX_CHUNK_SIZE];
+        while (avail > 0) { // Currently we never want to block
+            size_t n = readAvailable(chunk, avail < (int)sizeof(chunk) ? avail : sizeof(chunk));
+            if (n == 0)
+                break;
+            handleRxBytes(chunk, n);
+            avail = stream->available();
+        }
 
-            uint8_t c = (uint8_t)cInt;
+        // we had bytes available this time, so assume we might have them next time also
+        lastRxMsec = millis();
+        return 0;
+    }
+}
 
-            // Use the read pointer for a little state machine, first look for framing, then length bytes, then payload
-            size_t ptr = rxPtr;
+size_t StreamAPI::readAvailable(uint8_t *buf, size_t len)
+{
+#ifdef ARCH_NRF52
+    // The adafruit arduino USB CDC can say characters are available and then have none, readBytes() would wait out its
+    // timeout for them
+    size_t n = 0;
+    int c;
+    while (n < len && (c = stream->read()) >= 0)
+        buf[n++] = c;
+    return n;
+#else
+    return stream->readBytes(buf, len);
+#endif
+}
 
-            rxPtr++;        // assume we will probably advance the rxPtr
-            rxBuf[ptr] = c; // store all bytes (including framing)
+void StreamAPI::handleRxBytes(const uint8_t *buf, size_t len)
+{
+    const uint8_t *end = buf + len;
+    while (buf < end) {
+        if (rxPtr == 0) {
+            // Skip to the next START1 in one go, whatever else is on the link (debug output, noise) can't start a packet
+            buf = (const uint8_t *)memchr(buf, START1, end - buf);
+            if (!buf)
+                return;
+        }
 
-            // console->printf("rxPtr %d ptr=%d c=0x%x\n", rxPtr, ptr, c);
+        if (rxPtr < HEADER_LEN) {
+            // The framing and length bytes, one at a time
+            uint8_t c = *buf++;
+            size_t ptr = rxPtr++;
+            rxBuf[ptr] = c; // store all bytes (including framing)
 
             if (ptr == 0) { // looking for START1
                 if (c != START1)
                     rxPtr = 0;     // failed to find framing
             } else if (ptr == 1) { // looking for START2
                 if (c != START2)
-                    rxPtr = 0;                             // failed to find framing
-            } else if (ptr >= HEADER_LEN - 1) {            // we have at least read our 4 byte framing
-                uint32_t len = (rxBuf[2] << 8) + rxBuf[3]; // big endian 16 bit length follows framing
-
-                // console->printf("len %d\n", len);
-
-                if (ptr == HEADER_LEN - 1) {
-                    // we _just_ finished our 4 byte header, validate length now (note: a length of zero is a valid
-                    // protobuf also)
-                    if (len > MAX_TO_FROM_RADIO_SIZE)
-                        rxPtr = 0; // length is bogus, restart search for framing
+                    rxPtr = 0; // failed to find framing
+            } else if (ptr == HEADER_LEN - 1) {
+                // we _just_ finished our 4 byte header, validate length now (note: a length of zero is a valid protobuf also)
+                uint32_t payloadLen = (rxBuf[2] << 8) + rxBuf[3]; // big endian 16 bit length follows framing
+                if (payloadLen > MAX_TO_FROM_RADIO_SIZE) {
+                    rxPtr = 0; // length is bogus, restart search for framing
+                } else if (payloadLen == 0) {
+                    rxPtr = 0;
+                    handleToRadio(rxBuf + HEADER_LEN, 0);
                 }
-
-                if (rxPtr != 0)                        // Is packet still considered 'good'?
-                    if (ptr + 1 >= len + HEADER_LEN) { // have we received all of the payload?
-                        rxPtr = 0;                     // start over again on the next packet
-
-                        // If we didn't just fail the packet and we now have the right # of bytes, parse it
-                        handleToRadio(rxBuf + HEADER_LEN, len);
-                    }
+            }
+        } else {
+            // The payload, copy as much of it as this chunk has
+            uint32_t payloadLen = (rxBuf[2] << 8) + rxBuf[3];
+            size_t want = HEADER_LEN + payloadLen - rxPtr;
+            size_t n = (size_t)(end - buf) < want ? end - buf : want;
+            memcpy(rxBuf + rxPtr, buf, n);
+            rxPtr += n;
+            buf += n;
+
+            if (n == want) { // have we received all of the payload?
+                rxPtr = 0;   // start over again on the next packet
+                handleToRadio(rxBuf + HEADER_LEN, payloadLen);
             }
         }
-
-        // we had bytes available this time, so assume we might have them next time also
-        lastRxMsec = millis();
-        return 0;
     }
 }
 
+static void writeHeader(uint8_t *buf, size_t len)
+{
+    buf[0] = START1;
+    buf[1] = START2;
+    buf[2] = (len >> 8) & 0xff;
+    buf[3] = len & 0xff;
+}
+
 /**
  * call getFromRadio() and deliver encapsulated packets to the Stream
+ *
+ * Packets are encoded back to back into txBatch and written together, so the config handshake (hundreds of small
+ * nodeinfos) costs a handful of writes instead of one write and flush per packet.
  */
 void StreamAPI::writeStream()
 {
     if (canWrite) {
         uint32_t len;
         do {
-            // Send every packet we can
-            len = getFromRadio(txBuf + HEADER_LEN);
-            emitTxBuffer(len);
+            // Send every packet we can, as long as the link keeps taking them
+            uint8_t *frame = txBatch + txBatchUsed;
+            len = canWriteMore() ? getFromRadio(frame + HEADER_LEN) : 0;
+            if (len) {
+                // A log record emitted by getFromRadio() flushed the batch ahead of it, keep this packet right behind
+                if (frame != txBatch + txBatchUsed)
+                    memmove(txBatch + txBatchUsed + HEADER_LEN, frame + HEADER_LEN, len);
+                writeHeader(txBatch + txBatchUsed, len);
+                txBatchUsed += HEADER_LEN + len;
+            }
+            // getFromRadio() needs room for a maximum size packet
+            if (!len || sizeof(txBatch) - txBatchUsed < MAX_STREAM_BUF_SIZE)
+                flushTxBatch();
         } while (len);
     }
 }
 
+void StreamAPI::flushTxBatch()
+{
+    if (txBatchUsed) {
+        stream->write(txBatch, txBatchUsed);
+        stream->flush();
+        txBatchUsed = 0;
+    }
+}
+
 /**
  * Send the current txBuffer over our stream
  */
 void StreamAPI::emitTxBuffer(size_t len)
 {
     if (len != 0) {
-        txBuf[0] = START1;
-        txBuf[1] = START2;
-        txBuf[2] = (len >> 8) & 0xff;
-        txBuf[3] = len & 0xff;
+        // Packets already batched were produced first, they go out first
+        flushTxBatch();
+        writeHeader(txBuf, len);
 
         auto totalLen = len + HEADER_LEN;
         stream->write(txBuf, totalLen);
@@ -8,6 +8,16 @@
 // A To/FromRadio packet + our 32 bit header
 #define MAX_STREAM_BUF_SIZE (MAX_TO_FROM_RADIO_SIZE + sizeof(uint32_t))
 
+// writeStream() packs as many framed packets as fit in this before each write, most FromRadios are far below the max size
+#ifndef STREAM_TX_BATCH_SIZE
+#define STREAM_TX_BATCH_SIZE (2 * MAX_STREAM_BUF_SIZE)
+#endif
+
+// readStream() takes this many bytes from the stream at a time, and scans them for framing as a block
+#ifndef STREAM_RX_CHUNK_SIZE
+#define STREAM_RX_CHUNK_SIZE 64
+#endif
+
 /**
  * A version of our 'phone' API that talks over a Stream.  So therefore well suited to use with serial links
  * or TCP connections.
@@ -42,6 +52,10 @@ class StreamAPI : public PhoneAPI
     /// time of last rx, used, to slow down our polling if we haven't heard from anyone
     uint32_t lastRxMsec = 0;
 
+    /// Framed packets waiting to go out in one write. Separate from txBuf, log records may be emitted while we fill it.
+    uint8_t txBatch[STREAM_TX_BATCH_SIZE] = {0};
+    size_t txBatchUsed = 0;
+
   public:
     StreamAPI(Stream *_stream) : stream(_stream) {}
 
@@ -57,11 +71,20 @@ class StreamAPI : public PhoneAPI
      */
     int32_t readStream();
 
+    /// Up to len bytes that have already arrived, without waiting for more
+    size_t readAvailable(uint8_t *buf, size_t len);
+
+    /// Run received bytes through the framing, calling handleToRadio for every complete packet
+    void handleRxBytes(const uint8_t *buf, size_t len);
+
     /**
      * call getFromRadio() and deliver encapsulated packets to the Stream
      */
     void writeStream();
 
+    /// Write out the packets batched so far
+    void flushTxBatch();
+
   protected:
     /**
      * Send a FromRadio.rebooted = true packet to the phone
@@ -73,6 +96,9 @@ class StreamAPI : public PhoneAPI
     /// Check the current underlying physical link to see if the client is currently connected
     virtual bool checkIsConnected() override = 0;
 
+    /// Whether the link takes more bytes right now. If not, writeStream() leaves the remaining FromRadios queued for later
+    virtual bool canWriteMore() { return true; }
+
     /**
      * Send the current txBuffer over our stream
      */
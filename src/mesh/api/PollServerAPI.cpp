@@ -0,0 +1,355 @@
+#include "PollServerAPI.h"
+
+#ifdef ARCH_PORTDUINO
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+ssize_t SocketStream::sendSome(const uint8_t *buf, size_t len)
+{
+    ssize_t sent = send(fd, buf, len, MSG_NOSIGNAL);
+    if (sent < 0)
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    txBytes += sent;
+    return sent;
+}
+
+size_t SocketStream::write(const uint8_t *buf, size_t len)
+{
+    if (fd < 0)
+        return 0;
+
+    // Keep the order, nothing goes out directly while older bytes are waiting
+    size_t sent = 0;
+    if (txBacklog.empty()) {
+        ssize_t n = sendSome(buf, len);
+        if (n < 0) {
+            shutdown();
+            return 0;
+        }
+        sent = n;
+    }
+
+    if (sent < len) {
+        if (txBacklog.size() + len - sent > MAX_SOCKET_BACKLOG) {
+            LOG_WARN("API client is not reading, drop it");
+            shutdown();
+            return 0;
+        }
+        txBacklog.insert(txBacklog.end(), buf + sent, buf + len);
+    }
+    return len;
+}
+
+bool SocketStream::receive()
+{
+    if (fd < 0)
+        return false;
+    if (rxPos < rxLen) // StreamAPI didn't get to it yet
+        return true;
+
+    ssize_t n = recv(fd, rxBuf, sizeof(rxBuf), 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        return false;
+    rxPos = 0;
+    rxLen = n > 0 ? n : 0;
+    rxBytes += rxLen;
+    return true;
+}
+
+bool SocketStream::sendPending()
+{
+    if (fd < 0)
+        return false;
+    if (txBacklog.empty())
+        return true;
+
+    ssize_t n = sendSome(txBacklog.data(), txBacklog.size());
+    if (n < 0)
+        return false;
+    txBacklog.erase(txBacklog.begin(), txBacklog.begin() + n);
+    return true;
+}
+
+void SocketStream::shutdown()
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    txBacklog.clear();
+    rxLen = rxPos = 0;
+}
+
+PollServerAPI::PollServerAPI(int fd, PollServerPort &_port)
+    : StreamAPI(&socket), socket(fd), lastHeardMsec(millis()), connectedMsec(millis()), port(_port)
+{
+    LOG_INFO("Incoming API connection");
+}
+
+PollServerAPI::~PollServerAPI()
+{
+    LOG_INFO("API client gone after %us, rx %llu bytes, tx %llu bytes", (millis() - connectedMsec) / 1000,
+             (unsigned long long)socket.rxBytes, (unsigned long long)socket.txBytes);
+}
+
+void PollServerAPI::close()
+{
+    socket.shutdown(); // drop tcp connection
+    StreamAPI::close();
+}
+
+void PollServerAPI::onNowHasData(uint32_t fromRadioNum)
+{
+    port.wake();
+}
+
+PollServerPort::PollServerPort(int _port) : concurrency::OSThread("ApiServer"), port(_port) {}
+
+PollServerPort::~PollServerPort()
+{
+    if (watcher.joinable()) {
+        stopping = true;
+        uint8_t b = 0;
+        (void)!write(wakePipe[1], &b, 1);
+        watcher.join();
+    }
+    for (int fd : wakePipe)
+        if (fd >= 0)
+            ::close(fd);
+    for (auto &client : clients) {
+        delete client;
+        client = NULL;
+    }
+    if (listenFd >= 0)
+        ::close(listenFd);
+}
+
+bool PollServerPort::init()
+{
+    int one = 1, zero = 0;
+
+    // Prefer a dual stack socket, so IPv4 clients get in as well, and fall back to IPv4 only
+    listenFd = socket(AF_INET6, SOCK_STREAM, 0);
+    if (listenFd >= 0) {
+        struct sockaddr_in6 addr = {};
+        addr.sin6_family = AF_INET6;
+        addr.sin6_addr = in6addr_any;
+        addr.sin6_port = htons(port);
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(listenFd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+        if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            ::close(listenFd);
+            listenFd = -1;
+        }
+    }
+    if (listenFd < 0) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd >= 0) {
+            struct sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+            addr.sin_port = htons(port);
+            setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+                ::close(listenFd);
+                listenFd = -1;
+            }
+        }
+    }
+
+    if (listenFd < 0 || listen(listenFd, MAX_API_CLIENTS) != 0 || !setNonBlocking(listenFd)) {
+        LOG_ERROR("Can't listen on TCP port %d: %s", port, strerror(errno));
+        if (listenFd >= 0)
+            ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    // Without the watcher runOnce() still polls every 100 msec
+    if (pipe(wakePipe) == 0 && setNonBlocking(wakePipe[0]) && setNonBlocking(wakePipe[1]))
+        watcher = std::thread(&PollServerPort::watch, this);
+    else
+        LOG_WARN("API server can't wait for sockets in the background, fall back to polling: %s", strerror(errno));
+    return true;
+}
+
+void PollServerPort::armWatcher(const struct pollfd *fds, nfds_t numFds)
+{
+    {
+        std::lock_guard<std::mutex> lock(watchLock);
+        watchFds.assign(fds, fds + numFds);
+        for (auto &fd : watchFds)
+            fd.revents = 0;
+    }
+    uint8_t b = 0;
+    (void)!write(wakePipe[1], &b, 1); // Full just means the watcher has a wakeup to read anyway
+}
+
+void PollServerPort::watch()
+{
+    std::vector<struct pollfd> fds;
+    while (!stopping) {
+        {
+            std::lock_guard<std::mutex> lock(watchLock);
+            fds = watchFds;
+        }
+        fds.push_back({wakePipe[0], POLLIN, 0});
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno != EINTR) {
+                watchErrno = errno;
+                stopping = true; // runOnce() goes back to polling
+                wakeFromOtherThread();
+                return;
+            }
+            continue;
+        }
+
+        if (fds.back().revents & POLLIN) {
+            uint8_t buf[16];
+            while (read(wakePipe[0], buf, sizeof(buf)) > 0)
+                ;
+        }
+        fds.pop_back();
+
+        for (auto &fd : fds) {
+            if (fd.revents) {
+                // Stop watching until runOnce() has dealt with it, or poll() would keep returning the same socket
+                {
+                    std::lock_guard<std::mutex> lock(watchLock);
+                    watchFds.clear();
+                }
+                wakeFromOtherThread();
+                break;
+            }
+        }
+    }
+}
+
+void PollServerPort::acceptClients()
+{
+    int fd;
+    while ((fd = accept(listenFd, NULL, NULL)) >= 0) {
+        int one = 1;
+        setNonBlocking(fd);
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // StreamAPI already batches its writes
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+        // Take a free slot, or the one of the client we haven't heard from the longest
+        int slot = 0;
+        for (int i = 0; i < MAX_API_CLIENTS; i++) {
+            if (!clients[i]) {
+                slot = i;
+                break;
+            }
+            if ((int32_t)(clients[i]->lastHeardMsec - clients[slot]->lastHeardMsec) < 0)
+                slot = i;
+        }
+        if (clients[slot]) {
+            LOG_INFO("Too many TCP connections, force close the least recently heard");
+            delete clients[slot];
+        }
+        clients[slot] = new PollServerAPI(fd, *this);
+    }
+}
+
+nfds_t PollServerPort::getPollFds(struct pollfd *fds, PollServerAPI **polled)
+{
+    nfds_t numFds = 0;
+    polled[numFds] = NULL;
+    fds[numFds++] = {listenFd, POLLIN, 0};
+    for (auto client : clients) {
+        if (client) {
+            polled[numFds] = client;
+            fds[numFds++] = {client->socket.getFd(), (short)(POLLIN | (client->socket.hasPending() ? POLLOUT : 0)), 0};
+        }
+    }
+    return numFds;
+}
+
+int32_t PollServerPort::runOnce()
+{
+    if (listenFd < 0)
+        return disable();
+
+    int err = watchErrno.exchange(0);
+    if (err)
+        LOG_ERROR("API server watcher poll failed, fall back to polling: %s", strerror(err));
+
+    struct pollfd fds[MAX_API_CLIENTS + 1];
+    PollServerAPI *polled[MAX_API_CLIENTS + 1];
+    nfds_t numFds = getPollFds(fds, polled);
+
+    if (poll(fds, numFds, 0) < 0) {
+        if (errno != EINTR)
+            LOG_ERROR("API server poll failed: %s", strerror(errno));
+        return 100;
+    }
+
+    // Check this often for new connections and client data, or with the watcher only for connection timeouts
+    bool watching = watcher.joinable() && !stopping;
+    int32_t interval = watching ? 1000 : 100;
+    for (nfds_t i = 1; i < numFds; i++) {
+        PollServerAPI *client = polled[i];
+        if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+            if (client->socket.receive())
+                client->lastHeardMsec = millis();
+            else
+                client->socket.shutdown();
+        }
+
+        // Send the old backlog first, so there is room for the FromRadios runOncePart() writes
+        if (!client->socket.sendPending())
+            client->socket.shutdown();
+
+        // Also runs clients nothing arrived for, they may have FromRadios queued or time out
+        int32_t next = client->runOncePart();
+        if (!client->socket.sendPending())
+            client->socket.shutdown();
+        if (client->socket.hasPending() || client->socket.available())
+            next = 5;
+        else if (watching)
+            next = interval; // The watcher tells us when more arrives
+        if (next < interval)
+            interval = next;
+    }
+
+    for (auto &client : clients) {
+        if (client && !client->socket.isOpen()) {
+            client->close();
+            delete client;
+            client = NULL;
+        }
+    }
+
+    if (fds[0].revents & POLLIN) {
+        acceptClients();
+        interval = 0; // Have the new clients polled right away
+    }
+
+    if (watching) {
+        numFds = getPollFds(fds, polled);
+        armWatcher(fds, numFds);
+    }
+    return interval;
+}
+#endif
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "configuration.h"
+
+#ifdef ARCH_PORTDUINO
+#include "ServerAPI.h"
+#include <atomic>
+#include <mutex>
+#include <poll.h>
+#include <thread>
+#include <vector>
+
+// A client that doesn't read for this long worth of FromRadio bytes gets dropped rather than buffered forever
+#ifndef MAX_SOCKET_BACKLOG
+#define MAX_SOCKET_BACKLOG (64 * 1024)
+#endif
+
+class PollServerPort;
+
+/**
+ * A Stream over a non-blocking TCP socket.
+ *
+ * Reads are served from what the last receive() got from the socket, writes go out right away as far as the socket takes
+ * them and the rest waits in a backlog for sendPending(). Nothing here ever blocks the main loop.
+ */
+class SocketStream : public Stream
+{
+  public:
+    explicit SocketStream(int _fd) : fd(_fd) {}
+    ~SocketStream() { shutdown(); }
+
+    virtual int available() override { return rxLen - rxPos; }
+    virtual int read() override { return rxPos < rxLen ? rxBuf[rxPos++] : -1; }
+    virtual int peek() override { return rxPos < rxLen ? rxBuf[rxPos] : -1; }
+    virtual size_t write(uint8_t c) override { return write(&c, 1); }
+    virtual size_t write(const uint8_t *buf, size_t len) override;
+    virtual void flush() override {}
+
+    /// Read from the socket once everything received before was consumed. @return false if the peer closed the connection
+    bool receive();
+
+    /// Send as much of the backlog as the socket takes. @return false if the socket failed
+    bool sendPending();
+
+    bool hasPending() const { return !txBacklog.empty(); }
+    bool isOpen() const { return fd >= 0; }
+    int getFd() const { return fd; }
+
+    /// Close the socket, everything still in the backlog is lost
+    void shutdown();
+
+    uint64_t rxBytes = 0, txBytes = 0;
+
+  private:
+    int fd;
+    uint8_t rxBuf[MAX_STREAM_BUF_SIZE];
+    size_t rxLen = 0, rxPos = 0;
+    std::vector<uint8_t> txBacklog;
+
+    /// @return how many bytes the socket took, -1 if it failed
+    ssize_t sendSome(const uint8_t *buf, size_t len);
+};
+
+/**
+ * One TCP API client. Unlike ServerAPI it has no thread of its own, PollServerPort runs it when its socket is ready.
+ */
+class PollServerAPI : public StreamAPI
+{
+  public:
+    PollServerAPI(int fd, PollServerPort &_port);
+    virtual ~PollServerAPI();
+
+    /// override close to also shutdown the TCP link
+    virtual void close() override;
+
+    SocketStream socket;
+
+    /// Last time the client sent us anything, the least recently heard client makes room for a new one
+    uint32_t lastHeardMsec;
+    uint32_t connectedMsec;
+
+  protected:
+    /// Like ServerAPI, TCP clients don't change the power state
+    virtual void onConnectionChanged(bool connected) override {}
+
+    virtual bool checkIsConnected() override { return socket.isOpen(); }
+
+    /// New packets for the phone, have the port run us right away instead of at its next poll
+    virtual void onNowHasData(uint32_t fromRadioNum) override;
+
+    /// Leave FromRadios queued while the socket hasn't taken what we wrote before, rather than growing the backlog
+    virtual bool canWriteMore() override { return !socket.hasPending(); }
+
+  private:
+    PollServerPort &port;
+};
+
+/**
+ * Listens for API connections and serves all clients from a single thread.
+ *
+ * Every run polls the listening socket and all client sockets at once, accepts new connections, reads what arrived,
+ * lets each client's StreamAPI handle it and write its FromRadios, and sends what the sockets didn't take last time.
+ *
+ * Between runs a watcher thread waits in poll() on the same sockets and wakes the main loop as soon as one is ready, so
+ * clients are served when their bytes arrive instead of at the next timed poll. The watcher doesn't touch the thread's
+ * timing or log, it goes through wakeFromOtherThread() and leaves errors for runOnce() to report.
+ */
+class PollServerPort : private concurrency::OSThread
+{
+  public:
+    explicit PollServerPort(int _port);
+    virtual ~PollServerPort();
+
+    /// Start listening, @return false if the port can't be opened
+    bool init();
+
+    /// Run again as soon as possible, from the main loop
+    void wake() { setIntervalFromNow(0); }
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    int port;
+    int listenFd = -1;
+    PollServerAPI *clients[MAX_API_CLIENTS] = {};
+
+    std::thread watcher;
+    int wakePipe[2] = {-1, -1}; // Written to hand the watcher a new set of sockets, or to stop it
+    std::mutex watchLock;
+    std::vector<struct pollfd> watchFds; // Empty from a wakeup until the run that handles it
+    std::atomic<bool> stopping{false};
+    std::atomic<int> watchErrno{0}; // Why the watcher gave up, for runOnce() to log
+
+    void acceptClients();
+
+    /// The listening socket first, then every client socket. @return how many entries of fds and polled were filled
+    nfds_t getPollFds(struct pollfd *fds, PollServerAPI **polled);
+
+    /// Have the watcher wait for these sockets from now on
+    void armWatcher(const struct pollfd *fds, nfds_t numFds);
+
+    void watch();
+};
+#endif
@@ -57,8 +57,18 @@ template <class T, class U> int32_t APIServerPort<T, U>::runOnce()
     auto client = U::available();
 #endif
     if (client) {
-        // Close any previous connection (see FIXME in header file)
-        if (openAPI) {
+        // Reap connections the other side dropped. Slots are kept in connection order, openAPIs[0] is the oldest.
+        int numOpen = 0;
+        for (int i = 0; i < MAX_API_CLIENTS; i++) {
+            T *api = openAPIs[i];
+            openAPIs[i] = NULL;
+            if (api && !api->isClientConnected())
+                delete api;
+            else if (api)
+                openAPIs[numOpen++] = api;
+        }
+
+        if (numOpen == MAX_API_CLIENTS) {
 #if RAK_4631
             // RAK13800 Ethernet requests periodically take more time
             // This backoff addresses most cases keeping max wait < 1s
@@ -69,11 +79,14 @@ template <class T, class U> int32_t APIServerPort<T, U>::runOnce()
                 return waitTime;
             }
 #endif
-            LOG_INFO("Force close previous TCP connection");
-            delete openAPI;
+            LOG_INFO("Too many TCP connections, force close the oldest");
+            delete openAPIs[0];
+            for (int i = 1; i < MAX_API_CLIENTS; i++)
+                openAPIs[i - 1] = openAPIs[i];
+            numOpen--;
         }
 
-        openAPI = new T(client);
+        openAPIs[numOpen] = new T(client);
     }
 
 #if RAK_4631
@@ -4,13 +4,24 @@
 #if HAS_WIFI
 #include "WiFiServerAPI.h"
 
+#ifdef ARCH_PORTDUINO
+#include "PollServerAPI.h"
+
+// Native builds serve all clients from one thread that polls their sockets
+static PollServerPort *apiPort;
+#else
 static WiFiServerPort *apiPort;
+#endif
 
 void initApiServer(int port)
 {
     // Start API server on port 4403
     if (!apiPort) {
+#ifdef ARCH_PORTDUINO
+        apiPort = new PollServerPort(port);
+#else
         apiPort = new WiFiServerPort(port);
+#endif
         LOG_INFO("API server listen on TCP port %d", port);
         apiPort->init();
     }
@@ -18,6 +29,7 @@ void initApiServer(int port)
 void deInitApiServer()
 {
     delete apiPort;
+    apiPort = NULL;
 }
 
 WiFiServerAPI::WiFiServerAPI(WiFiClient &_client) : ServerAPI(_client)
@@ -1,7 +1,9 @@
 #if !MESHTASTIC_EXCLUDE_WEBSERVER
+#include "LatencyStats.h"
 #include "NodeDB.h"
 #include "PowerFSM.h"
 #include "RadioLibInterface.h"
+#include "Router.h"
 #include "airtime.h"
 #include "main.h"
 #include "mesh/http/ContentHelper.h"
@@ -95,6 +97,7 @@ void registerHandlers(HTTPServer *insecureServer, HTTPSServer *secureServer)
     ResourceNode *nodeJsonBlinkLED = new ResourceNode("/json/blink", "POST", &handleBlinkLED);
     ResourceNode *nodeJsonReport = new ResourceNode("/json/report", "GET", &handleReport);
     ResourceNode *nodeJsonNodes = new ResourceNode("/json/nodes", "GET", &handleNodes);
+    ResourceNode *nodeJsonLatency = new ResourceNode("/json/latency", "GET", &handleLatency);
     ResourceNode *nodeJsonFsBrowseStatic = new ResourceNode("/json/fs/browse/static", "GET", &handleFsBrowseStatic);
     ResourceNode *nodeJsonDelete = new ResourceNode("/json/fs/delete/static", "DELETE", &handleFsDeleteStatic);
 
@@ -115,6 +118,7 @@ void registerHandlers(HTTPServer *insecureServer, HTTPSServer *secureServer)
     secureServer->registerNode(nodeJsonDelete);
     secureServer->registerNode(nodeJsonReport);
     secureServer->registerNode(nodeJsonNodes);
+    secureServer->registerNode(nodeJsonLatency);
     //    secureServer->registerNode(nodeUpdateFs);
     //    secureServer->registerNode(nodeDeleteFs);
     secureServer->registerNode(nodeAdmin);
@@ -137,6 +141,7 @@ void registerHandlers(HTTPServer *insecureServer, HTTPSServer *secureServer)
     insecureServer->registerNode(nodeJsonFsBrowseStatic);
     insecureServer->registerNode(nodeJsonDelete);
     insecureServer->registerNode(nodeJsonReport);
+    insecureServer->registerNode(nodeJsonLatency);
     //    insecureServer->registerNode(nodeUpdateFs);
     //    insecureServer->registerNode(nodeDeleteFs);
     insecureServer->registerNode(nodeAdmin);
@@ -696,6 +701,38 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     delete value;
 }
 
+void handleLatency(HTTPRequest *req, HTTPResponse *res)
+{
+    res->setHeader("Content-Type", "application/json");
+    res->setHeader("Access-Control-Allow-Origin", "*");
+    res->setHeader("Access-Control-Allow-Methods", "GET");
+
+    // Built by hand, the histograms would be a few hundred JSONValue allocations
+    std::string out = "{\"data\":";
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+    latencyStats.toJson(out);
+#else
+    out += "{}";
+#endif
+    out += ",\"threads\":";
+    concurrency::mainScheduler.toJson(out);
+    if (router) {
+        char buf[16];
+        out += ",\"trial_decrypts\":[";
+        for (size_t i = 0; i <= MAX_NUM_CHANNELS; i++) {
+            snprintf(buf, sizeof(buf), "%s%lu", i ? "," : "", (unsigned long)router->trialDecrypts[i]);
+            out += buf;
+        }
+        out += "]";
+    }
+    if (RadioLibInterface::instance) {
+        out += ",\"contention\":";
+        RadioLibInterface::instance->getContention().toJson(out);
+    }
+    out += ",\"status\":\"ok\"}";
+    res->print(out.c_str());
+}
+
 void handleNodes(HTTPRequest *req, HTTPResponse *res)
 {
     ResourceParameters *params = req->getParams();
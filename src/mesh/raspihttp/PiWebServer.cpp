@@ -37,14 +37,17 @@ mail:   marchammermann@googlemail.com
 #ifdef PORTDUINO_LINUX_HARDWARE
 #if __has_include(<ulfius.h>)
 #include "PiWebServer.h"
+#include "LatencyStats.h"
 #include "NodeDB.h"
 #include "PhoneAPI.h"
 #include "PowerFSM.h"
 #include "RadioLibInterface.h"
+#include "Router.h"
 #include "airtime.h"
 #include "graphics/Screen.h"
 #include "main.h"
 #include "mesh/wifi/WiFiAPClient.h"
+#include "platform/portduino/SimRadio.h"
 #include "sleep.h"
 #include <openssl/bn.h>
 #include <openssl/evp.h>
@@ -56,6 +59,8 @@ mail:   marchammermann@googlemail.com
 #include <ulfius.h>
 #include <yder.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <string>
 
@@ -248,23 +253,146 @@ int handleAPIv1ToRadio(const struct _u_request *req, struct _u_response *res, vo
     portduinoVFS->mountpoint(configWeb.rootPath);
 
     LOG_DEBUG("Received %d bytes from PUT request", s);
-    static_cast<HttpAPI *>(user_data)->handleToRadio(buffer, s);
+    HttpAPI *api = static_cast<HttpAPI *>(user_data);
+    {
+        std::lock_guard<std::mutex> guard(api->apiLock);
+        api->handleToRadio(buffer, s);
+    }
     LOG_DEBUG("end web->radio  ");
     return U_CALLBACK_COMPLETE;
 }
 
+void HttpAPI::onNowHasData(uint32_t fromRadioNum)
+{
+    {
+        std::lock_guard<std::mutex> guard(dataLock);
+        hasData = true;
+    }
+    dataReady.notify_all();
+}
+
+bool HttpAPI::waitForData(uint32_t timeoutMsec)
+{
+    std::unique_lock<std::mutex> lock(dataLock);
+    dataReady.wait_for(lock, std::chrono::milliseconds(timeoutMsec), [this] { return hasData || stopping; });
+    bool woken = hasData;
+    hasData = false;
+    return woken;
+}
+
+uint32_t HttpAPI::startStream()
+{
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> guard(dataLock);
+        id = ++streamId;
+    }
+    dataReady.notify_all(); // Have the previous stream notice it was replaced
+    return id;
+}
+
+bool HttpAPI::isCurrentStream(uint32_t id)
+{
+    std::lock_guard<std::mutex> guard(dataLock);
+    return id == streamId && !stopping;
+}
+
+void HttpAPI::stopStreams()
+{
+    {
+        std::lock_guard<std::mutex> guard(dataLock);
+        stopping = true;
+    }
+    dataReady.notify_all();
+}
+
+/// State of one Server-Sent-Events FromRadio stream
+struct FromRadioStream {
+    HttpAPI *api;
+    uint32_t id;
+    std::string out; // Events not sent yet
+    size_t outPos = 0;
+    uint32_t lastSentMsec;
+};
+
+/**
+ * Append every FromRadio available right now to the stream, as one event each: "data: <base64 FromRadio>\n\n"
+ */
+static void encodeFromRadioEvents(FromRadioStream *stream)
+{
+    uint8_t txBuf[MAX_STREAM_BUF_SIZE];
+    unsigned char b64[(MAX_STREAM_BUF_SIZE + 2) / 3 * 4 + 1];
+    std::lock_guard<std::mutex> guard(stream->api->apiLock);
+
+    // Leave some room for the client to catch up during the config handshake
+    while (stream->out.size() < 16 * 1024) {
+        uint32_t len = stream->api->getFromRadio(txBuf);
+        if (!len)
+            break;
+        size_t b64Len = 0;
+        if (!o_base64_encode(txBuf, len, b64, &b64Len))
+            continue;
+        stream->out += "data: ";
+        stream->out.append((const char *)b64, b64Len);
+        stream->out += "\n\n";
+    }
+}
+
+/**
+ * Streaming callback of a FromRadio stream. The web server runs a thread per connection, so this blocks until there is
+ * something to send.
+ */
+static ssize_t callback_fromradio_stream(void *cls, uint64_t pos, char *buf, size_t max)
+{
+    (void)(pos);
+    FromRadioStream *stream = (FromRadioStream *)cls;
+
+    while (stream->outPos == stream->out.size()) {
+        if (!stream->api->isCurrentStream(stream->id))
+            return U_STREAM_END;
+
+        stream->out.clear();
+        stream->outPos = 0;
+        encodeFromRadioEvents(stream);
+        if (!stream->out.empty())
+            break;
+
+        // Not every FromRadio comes with a notification (queue status, notifications), so look again every second anyway
+        if (!stream->api->waitForData(1000) && millis() - stream->lastSentMsec >= FROMRADIO_STREAM_KEEPALIVE_MSEC)
+            stream->out = ": keepalive\n\n";
+    }
+
+    size_t len = std::min(max, stream->out.size() - stream->outPos);
+    memcpy(buf, stream->out.data() + stream->outPos, len);
+    stream->outPos += len;
+    stream->lastSentMsec = millis();
+    return len;
+}
+
+static void callback_fromradio_stream_free(void *cls)
+{
+    delete (FromRadioStream *)cls;
+}
+
 /*
  * Adapt the radioapi to the Webservice handleAPIv1FromRadio
  * Trigger : WebGui(POLL)->handleAPIv1FromRadio->phoneapi->Meshtastic(Radio) events
+ *
+ * GET /api/v1/fromradio returns one FromRadio protobuf, empty if there is none.
+ * GET /api/v1/fromradio?all=true returns all available FromRadios, each one preceded by the 4 byte header of the TCP API
+ * (0x94 0xc3, 16 bit big endian length).
+ * GET /api/v1/fromradio?stream=true keeps the connection open and pushes FromRadios as Server-Sent-Events as soon as they
+ * are queued, one base64 encoded protobuf per event. Only one stream is served at a time, a new one ends the previous one.
  */
 int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res, void *user_data)
 {
 
     // LOG_DEBUG("handleAPIv1FromRadio radio -> web");
-    std::string valueAll;
+    HttpAPI *api = static_cast<HttpAPI *>(user_data);
+    const char *valueAll = u_map_get(req->map_url, "all");
+    const char *valueStream = u_map_get(req->map_url, "stream");
 
     // Status code is 200 OK by default.
-    ulfius_add_header_to_response(res, "Content-Type", "application/x-protobuf");
     ulfius_add_header_to_response(res, "Access-Control-Allow-Origin", "*");
     ulfius_add_header_to_response(res, "Access-Control-Allow-Methods", "GET");
     ulfius_add_header_to_response(res, "X-Protobuf-Schema",
@@ -275,33 +403,114 @@ int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res,
         return U_CALLBACK_COMPLETE;
     }
 
+    if (o_strcmp(valueStream, "true") == 0) {
+        FromRadioStream *stream = new FromRadioStream();
+        stream->api = api;
+        stream->id = api->startStream();
+        stream->lastSentMsec = millis();
+        ulfius_add_header_to_response(res, "Content-Type", "text/event-stream");
+        ulfius_add_header_to_response(res, "Cache-Control", "no-cache");
+        if (ulfius_set_stream_response(res, 200, callback_fromradio_stream, callback_fromradio_stream_free,
+                                       U_STREAM_SIZE_UNKNOWN, MAX_STREAM_BUF_SIZE, stream) != U_OK) {
+            LOG_DEBUG("handleAPIv1FromRadio - Error ulfius_set_stream_response");
+            delete stream;
+        }
+        return U_CALLBACK_COMPLETE;
+    }
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/x-protobuf");
     uint8_t txBuf[MAX_STREAM_BUF_SIZE];
-    uint32_t len = 1;
-
-    if (valueAll == "true") {
-        while (len) {
-            len = static_cast<HttpAPI *>(user_data)->getFromRadio(txBuf);
-            ulfius_set_response_properties(res, U_OPT_STATUS, 200, U_OPT_BINARY_BODY, txBuf, len);
-            const char *tmpa = (const char *)txBuf;
-            ulfius_set_string_body_response(res, 200, tmpa);
-            // LOG_DEBUG("\n----webAPI response all:----");
-            // LOG_DEBUG(tmpa);
-            // LOG_DEBUG("");
+    std::lock_guard<std::mutex> guard(api->apiLock);
+
+    if (o_strcmp(valueAll, "true") == 0) {
+        std::string body;
+        uint32_t len;
+        while ((len = api->getFromRadio(txBuf + 4))) {
+            txBuf[0] = 0x94;
+            txBuf[1] = 0xc3;
+            txBuf[2] = (len >> 8) & 0xff;
+            txBuf[3] = len & 0xff;
+            body.append((const char *)txBuf, len + 4);
         }
+        ulfius_set_binary_body_response(res, 200, body.data(), body.size());
         // Otherwise, just return one protobuf
     } else {
-        len = static_cast<HttpAPI *>(user_data)->getFromRadio(txBuf);
-        const char *tmpa = (const char *)txBuf;
-        ulfius_set_binary_body_response(res, 200, tmpa, len);
-        // LOG_DEBUG("\n----webAPI response:");
-        // LOG_DEBUG(tmpa);
-        // LOG_DEBUG("");
+        uint32_t len = api->getFromRadio(txBuf);
+        ulfius_set_binary_body_response(res, 200, (const char *)txBuf, len);
     }
 
     // LOG_DEBUG("end radio->web", len);
     return U_CALLBACK_COMPLETE;
 }
 
+std::string LatencySnapshot::request(uint32_t timeoutMsec)
+{
+    std::unique_lock<std::mutex> lock(dataLock);
+    uint32_t wanted = ++requested;
+    wakeFromOtherThread();
+    dataReady.wait_for(lock, std::chrono::milliseconds(timeoutMsec), [&] { return (int32_t)(built - wanted) >= 0; });
+    return json;
+}
+
+/// Builds the body for every request that came in since the last run, same format as /json/latency on the ESP32 web server
+int32_t LatencySnapshot::runOnce()
+{
+    uint32_t wanted;
+    {
+        std::lock_guard<std::mutex> guard(dataLock);
+        wanted = requested;
+    }
+    if (wanted == built)
+        return INT32_MAX;
+
+    std::string out = "{\"data\":";
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+    latencyStats.toJson(out);
+#else
+    out += "{}";
+#endif
+    out += ",\"threads\":";
+    concurrency::mainScheduler.toJson(out);
+    if (router) {
+        char buf[16];
+        out += ",\"trial_decrypts\":[";
+        for (size_t i = 0; i <= MAX_NUM_CHANNELS; i++) {
+            snprintf(buf, sizeof(buf), "%s%lu", i ? "," : "", (unsigned long)router->trialDecrypts[i]);
+            out += buf;
+        }
+        out += "]";
+    }
+    const RadioInterface *radio = RadioLibInterface::instance;
+    if (!radio)
+        radio = SimRadio::instance;
+    if (radio) {
+        out += ",\"contention\":";
+        radio->getContention().toJson(out);
+    }
+    out += ",\"status\":\"ok\"}";
+
+    {
+        std::lock_guard<std::mutex> guard(dataLock);
+        json.swap(out);
+        built = wanted;
+    }
+    dataReady.notify_all();
+    return INT32_MAX;
+}
+
+/*
+ * Latency probe histograms, thread and contention stats as JSON, built by the main loop
+ */
+static int handleLatency(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    LatencySnapshot *snapshot = static_cast<LatencySnapshot *>(user_data);
+    std::string out = snapshot->request(2000);
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_set_string_body_response(res, 200, out.c_str());
+    return U_CALLBACK_COMPLETE;
+}
+
 /*
 OpenSSL RSA Key Gen
 */
@@ -503,6 +712,7 @@ PiWebServerThread::PiWebServerThread()
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/fromradio/*", 1, &handleAPIv1FromRadio, &webAPI);
         ulfius_add_endpoint_by_val(&instanceWeb, "PUT", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, &webAPI);
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, &webAPI);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/latency", 1, &handleLatency, &latencySnapshot);
 
         // Add callback function to all endpoints for the Web Server
         ulfius_add_endpoint_by_val(&instanceWeb, "GET", NULL, "/*", 2, &callback_static_file, &configWeb);
@@ -526,6 +736,8 @@ PiWebServerThread::~PiWebServerThread()
 {
     u_map_clean(&configWeb.mime_types);
 
+    webAPI.stopStreams(); // The framework waits for its connection threads
+
     ulfius_stop_framework(&instanceWeb);
     ulfius_clean_instance(&instanceWeb);
     free(configWeb.rootPath);
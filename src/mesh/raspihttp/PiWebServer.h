@@ -2,13 +2,20 @@
 #ifdef PORTDUINO_LINUX_HARDWARE
 #if __has_include(<ulfius.h>)
 #include "PhoneAPI.h"
+#include "concurrency/OSThread.h"
 #include "ulfius-cfg.h"
 #include "ulfius.h"
 #include <Arduino.h>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <string>
 
 #define STATIC_FILE_CHUNK 256
 
+// A FromRadio stream sends a comment line after this much silence, so a client that went away is noticed
+#define FROMRADIO_STREAM_KEEPALIVE_MSEC 15000
+
 void initWebServer();
 void createSSLCert();
 int callback_static_file(const struct _u_request *request, struct _u_response *response, void *user_data);
@@ -27,14 +34,59 @@ class HttpAPI : public PhoneAPI
 {
 
   public:
-    // Nothing here yet
+    /// Held around every PhoneAPI call, the web server runs each request in a thread of its own
+    std::mutex apiLock;
+
+    /**
+     * Wait until there may be new FromRadios
+     * @return false if nothing happened within timeoutMsec
+     */
+    bool waitForData(uint32_t timeoutMsec);
+
+    /// There's only one PhoneAPI to read from, so a new FromRadio stream ends the previous one. @return the new stream id
+    uint32_t startStream();
+
+    /// @return false once a newer stream started or the server shuts down
+    bool isCurrentStream(uint32_t id);
+
+    /// End all streams, the web server is going down
+    void stopStreams();
 
   private:
-    // Nothing here yet
+    std::mutex dataLock;
+    std::condition_variable dataReady;
+    bool hasData = false;
+    bool stopping = false;
+    uint32_t streamId = 0;
 
   protected:
     /// Check the current underlying physical link to see if the client is currently connected
     virtual bool checkIsConnected() override { return true; } // FIXME, be smarter about this
+
+    /// Called from the main loop when packets were queued for the phone, wakes up the stream
+    virtual void onNowHasData(uint32_t fromRadioNum) override;
+};
+
+/**
+ * The /json/latency body, built on the main loop. The handlers run on ulfius threads, so rather than reading counters the
+ * main loop is updating they ask it for a fresh copy and wait for it.
+ */
+class LatencySnapshot : private concurrency::OSThread
+{
+  public:
+    LatencySnapshot() : concurrency::OSThread("LatencySnapshot", INT32_MAX) {}
+
+    /// Have the main loop build a fresh body. @return it, or the previous one if the main loop didn't get to it in time
+    std::string request(uint32_t timeoutMsec);
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    std::mutex dataLock;
+    std::condition_variable dataReady;
+    std::string json = "{\"data\":{},\"status\":\"ok\"}";
+    uint32_t requested = 0, built = 0;
 };
 
 class PiWebServerThread
@@ -45,6 +97,7 @@ class PiWebServerThread
     // struct _u_map mime_types;
     std::string webrootpath;
     HttpAPI webAPI;
+    LatencySnapshot latencySnapshot;
 
   public:
     PiWebServerThread();
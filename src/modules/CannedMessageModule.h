@@ -102,6 +102,8 @@ class CannedMessageModule : public SinglePortModule, public Observable<const UIF
             lastRxSnr = p->rx_snr;
         return (p->decoded.portnum == meshtastic_PortNum_ROUTING_APP) ? waitingForAck : false;
     }
+    // wantPacket() tracks the signal of every packet, so it has to see all of them
+    virtual bool getWantedPortNums(std::vector<meshtastic_PortNum> &portNums) override { return false; }
 
   protected:
     // === Thread Entry Point ===
@@ -227,6 +227,11 @@ bool ExternalNotificationModule::wantPacket(const meshtastic_MeshPacket *p)
     return MeshService::isTextPayload(p);
 }
 
+bool ExternalNotificationModule::getWantedPortNums(std::vector<meshtastic_PortNum> &portNums)
+{
+    return MeshService::getTextPayloadPortNums(portNums);
+}
+
 /**
  * Sets the external notification for the specified index.
  *
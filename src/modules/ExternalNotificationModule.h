@@ -64,6 +64,7 @@ class ExternalNotificationModule : public SinglePortModule, private concurrency:
     virtual int32_t runOnce() override;
 
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override;
+    virtual bool getWantedPortNums(std::vector<meshtastic_PortNum> &portNums) override;
 
     bool isNagging = false;
 
@@ -62,6 +62,7 @@ class NeighborInfoModule : public ProtobufModule<meshtastic_NeighborInfo>, priva
     /* Override wantPacket to say we want to see all packets when enabled, not just those for our port number.
       Exception is when the packet came via MQTT */
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override { return enabled && !p->via_mqtt; }
+    virtual bool getWantedPortNums(std::vector<meshtastic_PortNum> &portNums) override { return false; }
 
     /* These are for debugging only */
     void printNeighborInfo(const char *header, const meshtastic_NeighborInfo *np);
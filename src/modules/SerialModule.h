@@ -65,6 +65,12 @@ class SerialModuleRadio : public MeshModule
 
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override { return p->decoded.portnum == ourPortNum; }
 
+    virtual bool getWantedPortNums(std::vector<meshtastic_PortNum> &portNums) override
+    {
+        portNums.push_back(ourPortNum);
+        return true;
+    }
+
     meshtastic_MeshPacket *allocDataPacket()
     {
         // Update our local node info with our position (even if we don't decide to update anyone else)
@@ -0,0 +1,224 @@
+#include "StoreForwardLog.h"
+#include "FSCommon.h"
+#include "SPILock.h"
+#include "StoreForwardModule.h"
+#include <ErriezCRC32.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARCH_PORTDUINO
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define MAX_RECORD_SIZE (FIXED_SIZE + meshtastic_Constants_DATA_PAYLOAD_LEN + CRC_SIZE)
+
+static void putU32(uint8_t *p, uint32_t v)
+{
+    for (uint8_t i = 0; i < 4; i++)
+        p[i] = v >> (8 * i);
+}
+
+static uint32_t getU32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void StoreForwardLog::segmentName(char *buf, size_t len, uint32_t number)
+{
+    snprintf(buf, len, "%s/%08lu.log", dirName, (unsigned long)number);
+}
+
+size_t StoreForwardLog::encode(const PacketHistoryStruct &h, uint8_t *buf)
+{
+    size_t len = FIXED_SIZE + h.payload_size + CRC_SIZE;
+    buf[0] = (len - 2) & 0xff;
+    buf[1] = (len - 2) >> 8;
+    putU32(buf + 2, h.time);
+    putU32(buf + 6, h.to);
+    putU32(buf + 10, h.from);
+    putU32(buf + 14, h.id);
+    putU32(buf + 18, h.reply_id);
+    buf[22] = h.channel;
+    buf[23] = h.emoji;
+    buf[24] = 0;
+    buf[25] = 0;
+    memcpy(buf + FIXED_SIZE, h.payload, h.payload_size);
+    putU32(buf + len - CRC_SIZE, crc32Buffer(buf, len - CRC_SIZE));
+    return len;
+}
+
+bool StoreForwardLog::decode(const uint8_t *buf, size_t len, PacketHistoryStruct &h)
+{
+    if (len < FIXED_SIZE + CRC_SIZE || len > MAX_RECORD_SIZE || getU32(buf + len - CRC_SIZE) != crc32Buffer(buf, len - CRC_SIZE))
+        return false;
+
+    memset(&h, 0, sizeof(h));
+    h.time = getU32(buf + 2);
+    h.to = getU32(buf + 6);
+    h.from = getU32(buf + 10);
+    h.id = getU32(buf + 14);
+    h.reply_id = getU32(buf + 18);
+    h.channel = buf[22];
+    h.emoji = buf[23];
+    h.payload_size = len - FIXED_SIZE - CRC_SIZE;
+    memcpy(h.payload, buf + FIXED_SIZE, h.payload_size);
+    return true;
+}
+
+size_t StoreForwardLog::readSegment(Segment &seg, const RestoreCallback &restore)
+{
+    char name[48];
+    segmentName(name, sizeof(name), seg.number);
+    PacketHistoryStruct h;
+    size_t pos = 0;
+
+#ifdef ARCH_PORTDUINO
+    // Map the whole segment rather than reading it record by record
+    std::string path = std::string(portduinoVFS->mountpoint()) + name;
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    size_t size = st.st_size;
+    void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return 0;
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    const uint8_t *data = (const uint8_t *)mapped;
+    while (pos + 2 <= size) {
+        size_t len = 2 + (data[pos] | (data[pos + 1] << 8));
+        if (pos + len > size || !decode(data + pos, len, h))
+            break;
+        restore(h);
+        seg.packets++;
+        pos += len;
+    }
+    munmap(mapped, size);
+#elif defined(FSCom)
+    auto f = FSCom.open(name, FILE_O_READ);
+    if (!f)
+        return 0;
+
+    uint8_t record[MAX_RECORD_SIZE];
+    while (f.read(record, 2) == 2) {
+        size_t len = 2 + (record[0] | (record[1] << 8));
+        if (len > MAX_RECORD_SIZE || f.read(record + 2, len - 2) != len - 2 || !decode(record, len, h))
+            break;
+        restore(h);
+        seg.packets++;
+        pos += len;
+    }
+    f.close();
+#endif
+
+    seg.bytes = pos;
+    return pos;
+}
+
+void StoreForwardLog::dropOldSegments()
+{
+#ifdef FSCom
+    char name[48];
+    while (segments.size() > 1 &&
+           (storedPackets - segments.front().packets >= maxPackets || storedBytes > STOREFORWARD_LOG_MAX_BYTES)) {
+        segmentName(name, sizeof(name), segments.front().number);
+        FSCom.remove(name);
+        storedPackets -= segments.front().packets;
+        storedBytes -= segments.front().bytes;
+        segments.erase(segments.begin());
+    }
+#endif
+}
+
+void StoreForwardLog::begin(uint32_t _maxPackets, const RestoreCallback &restore)
+{
+    maxPackets = _maxPackets;
+    segments.clear();
+    storedPackets = storedBytes = 0;
+    usable = false;
+#ifdef FSCom
+    concurrency::LockGuard g(spiLock);
+    FSCom.mkdir(dirName);
+
+    struct SegmentFile {
+        uint32_t number;
+        uint32_t size;
+    };
+    std::vector<SegmentFile> files;
+    for (auto &file : getFiles(dirName, 0)) {
+        const char *base = strrchr(file.file_name, '/');
+        base = base ? base + 1 : file.file_name;
+        char *end;
+        unsigned long number = strtoul(base, &end, 10);
+        if (end != base && strcmp(end, ".log") == 0)
+            files.push_back({(uint32_t)number, file.size_bytes});
+    }
+    std::sort(files.begin(), files.end(), [](const SegmentFile &a, const SegmentFile &b) { return a.number < b.number; });
+
+    uint32_t startMs = millis();
+    bool lastClean = true;
+    for (auto &file : files) {
+        Segment seg = {file.number, 0, 0};
+        lastClean = readSegment(seg, restore) == file.size;
+        segments.push_back(seg);
+        storedPackets += seg.packets;
+        storedBytes += seg.bytes;
+    }
+    if (!segments.empty())
+        LOG_INFO("S&F restored %u messages from %u segments in %ums", storedPackets, (uint32_t)segments.size(),
+                 millis() - startMs);
+    dropOldSegments();
+
+    // Keep appending to the newest segment, unless it ended in a corrupt record or is full
+    if (segments.empty())
+        segments.push_back({0, 0, 0});
+    else if (!lastClean || segments.back().bytes >= STOREFORWARD_SEGMENT_BYTES)
+        segments.push_back({segments.back().number + 1, 0, 0});
+    usable = true;
+#endif
+}
+
+void StoreForwardLog::append(const PacketHistoryStruct &h)
+{
+    if (!usable)
+        return;
+#ifdef FSCom
+    uint8_t record[MAX_RECORD_SIZE];
+    size_t len = encode(h, record);
+
+    if (segments.back().bytes >= STOREFORWARD_SEGMENT_BYTES)
+        segments.push_back({segments.back().number + 1, 0, 0});
+    Segment &seg = segments.back();
+    char name[48];
+    segmentName(name, sizeof(name), seg.number);
+
+    concurrency::LockGuard g(spiLock);
+    auto f = FSCom.open(name, FILE_O_APPEND);
+    size_t written = f ? f.write((uint8_t const *)record, len) : 0;
+    if (f)
+        f.close();
+    if (written != len) {
+        // A partial record ends the segment when it's read back, don't append anything after it
+        LOG_ERROR("Can't append to %s, stop persisting S&F messages", name);
+        usable = false;
+        return;
+    }
+
+    seg.packets++;
+    seg.bytes += len;
+    storedPackets++;
+    storedBytes += len;
+    dropOldSegments();
+#endif
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "configuration.h"
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+// Segments are closed once they reach this size, and deleted as a whole once their packets aren't needed anymore
+#ifndef STOREFORWARD_SEGMENT_BYTES
+#ifdef ARCH_PORTDUINO
+#define STOREFORWARD_SEGMENT_BYTES (1024 * 1024)
+#else
+#define STOREFORWARD_SEGMENT_BYTES (16 * 1024)
+#endif
+#endif
+
+// Upper bound for all segments together, the oldest ones go first
+#ifndef STOREFORWARD_LOG_MAX_BYTES
+#ifdef ARCH_PORTDUINO
+#define STOREFORWARD_LOG_MAX_BYTES (256 * 1024 * 1024)
+#else
+#define STOREFORWARD_LOG_MAX_BYTES (256 * 1024)
+#endif
+#endif
+
+struct PacketHistoryStruct;
+
+/**
+ * Store & Forward history on the filesystem, so a router keeps the messages it holds across reboots.
+ *
+ * Every packet added to the history is appended as one record to the newest segment file in /storeforward, so storing a
+ * message writes that message and nothing else. Old segments are deleted as a whole once the newer ones hold enough packets
+ * to fill the in-memory history, or the log grows past STOREFORWARD_LOG_MAX_BYTES. At boot the segments are read oldest
+ * first to refill the history, native builds mmap them instead of reading them through the VFS.
+ *
+ * Record layout, little endian: [length of the rest:2][time:4][to:4][from:4][id:4][reply_id:4][channel:1][emoji:1]
+ * [reserved, written as 0:2][payload][crc32 of everything before:4]. Reading a segment stops at its first truncated or corrupt record.
+ */
+class StoreForwardLog
+{
+  public:
+    static constexpr const char *dirName = "/storeforward";
+
+    typedef std::function<void(const PacketHistoryStruct &)> RestoreCallback;
+
+    /**
+     * Read the log and get ready to append to it
+     * @param maxPackets how many packets the in-memory history holds, no more than that are kept on disk either
+     * @param restore called for every stored packet, oldest first
+     */
+    void begin(uint32_t maxPackets, const RestoreCallback &restore);
+
+    /// Persist a packet that was just added to the history
+    void append(const PacketHistoryStruct &h);
+
+  private:
+    struct Segment {
+        uint32_t number; // File name
+        uint32_t packets;
+        uint32_t bytes;
+    };
+
+    static constexpr size_t FIXED_SIZE = 26; // Length field and the fields before the payload
+    static constexpr size_t CRC_SIZE = 4;
+
+    std::vector<Segment> segments; // Oldest first, the last one is appended to
+    uint32_t maxPackets = 0;
+    uint32_t storedPackets = 0;
+    uint32_t storedBytes = 0;
+    bool usable = false;
+
+    static void segmentName(char *buf, size_t len, uint32_t number);
+
+    /// @return the record length of h, after encoding it to buf
+    static size_t encode(const PacketHistoryStruct &h, uint8_t *buf);
+
+    /// Decode and check the record at buf, of len bytes including the length field. @return false if it is corrupt
+    static bool decode(const uint8_t *buf, size_t len, PacketHistoryStruct &h);
+
+    /// Restore the records of a segment and count them in seg. @return the number of bytes that held valid records
+    size_t readSegment(Segment &seg, const RestoreCallback &restore);
+
+    /// Delete the oldest segments while they aren't needed, the caller holds spiLock
+    void dropOldSegments();
+};
@@ -25,6 +25,7 @@
 #include "mesh/generated/meshtastic/storeforward.pb.h"
 #include "modules/ModuleDev.h"
 #include <Arduino.h>
+#include <algorithm>
 #include <iterator>
 #include <map>
 
@@ -89,6 +90,10 @@ void StoreForwardModule::populatePSRAM()
     LOG_DEBUG("After PSRAM init: heap %d/%d PSRAM %d/%d", memGet.getFreeHeap(), memGet.getHeapSize(), memGet.getFreePsram(),
               memGet.getPsramSize());
     LOG_DEBUG("numberOfPackets for packetHistory - %u", numberOfPackets);
+
+    // Refill the history with what was stored before the last reboot
+    if (this->packetHistory && this->records)
+        historyLog.begin(this->records, [this](const PacketHistoryStruct &h) { historyStore(h); });
 }
 
 /**
@@ -108,6 +113,7 @@ void StoreForwardModule::historySend(uint32_t secAgo, uint32_t to)
         LOG_INFO("S&F - Send %u message(s)", queueSize);
         this->busy = true; // runOnce() will pickup the next steps once busy = true.
         this->busyTo = to;
+        this->historyCursorSet = false;
     } else {
         LOG_INFO("S&F - No history");
     }
@@ -134,16 +140,114 @@ uint32_t StoreForwardModule::getNumAvailablePackets(NodeNum dest, uint32_t last_
     if (lastRequest.find(dest) == lastRequest.end()) {
         lastRequest.emplace(dest, 0);
     }
-    for (uint32_t i = lastRequest[dest]; i < this->packetHistoryTotalCount; i++) {
-        if (this->packetHistory[i].time && (this->packetHistory[i].time > last_time)) {
-            // Client is only interested in packets not from itself and only in broadcast packets or packets towards it.
-            if (this->packetHistory[i].from != dest &&
-                (this->packetHistory[i].to == NODENUM_BROADCAST || this->packetHistory[i].to == dest)) {
-                count++;
+    historyFindAvailable(dest, last_time, &count);
+    return count;
+}
+
+uint32_t StoreForwardModule::historyFirstSeqAfter(uint32_t time)
+{
+    uint32_t lo = historyFirstSeq(), hi = historyNextSeq;
+
+    // The clock was set back while these packets were stored (RTC set by GPS or the phone after boot), check them all
+    if (this->historyUnorderedSeq > lo) {
+        for (; lo != hi; lo++)
+            if (historyAt(lo).time > time)
+                break;
+        return lo;
+    }
+
+    // Otherwise packets are stored in the order they arrived, so their times only go up
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (historyAt(mid).time > time)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+uint32_t StoreForwardModule::historyStartSeq(NodeNum dest, uint32_t last_time)
+{
+    uint32_t start = historyFirstSeqAfter(last_time);
+    auto req = lastRequest.find(dest);
+    if (req != lastRequest.end() && req->second > start)
+        start = req->second;
+    return start;
+}
+
+void StoreForwardModule::historyChainHeads(NodeNum dest, uint32_t chains[HISTORY_WALK_CHAINS])
+{
+    // Client is only interested in packets not from itself and only in broadcast packets or packets towards it.
+    chains[0] = historyChainLast(NODENUM_BROADCAST);
+    chains[1] = dest == NODENUM_BROADCAST ? NO_SEQ : historyChainLast(dest);
+    chains[2] = historyOverflowLastSeq;
+}
+
+uint32_t StoreForwardModule::historyFindAvailable(NodeNum dest, uint32_t last_time, uint32_t *count)
+{
+    uint32_t first = historyNextSeq;
+    uint32_t found = 0;
+
+    if (this->packetHistory && this->records) {
+        uint32_t start = historyStartSeq(dest, last_time);
+        uint32_t chains[HISTORY_WALK_CHAINS];
+        historyChainHeads(dest, chains);
+        for (uint8_t c = 0; c < HISTORY_WALK_CHAINS; c++) {
+            // Walk back from the newest packet, a link to a packet that was overwritten already is below start
+            for (uint32_t seq = chains[c]; seq != NO_SEQ && seq >= start; seq = historyAt(seq).prevInChain) {
+                if (historyWanted(historyAt(seq), dest, last_time)) {
+                    found++;
+                    if (seq < first)
+                        first = seq;
+                }
             }
         }
     }
-    return count;
+
+    if (count)
+        *count = found;
+    return first;
+}
+
+uint32_t StoreForwardModule::historyNextAvailable(NodeNum dest, uint32_t last_time)
+{
+    if (!this->packetHistory || !this->records)
+        return this->historyNextSeq;
+
+    // Start once per client, and again if the ring wrapped past the cursor since
+    if (!this->historyCursorSet || this->historyCursorTo != dest || this->historyCursorSeq < historyFirstSeq()) {
+        for (uint8_t c = 0; c < HISTORY_WALK_CHAINS; c++)
+            this->historyCursor[c] = NO_SEQ;
+        this->historyCursorSeq = historyStartSeq(dest, last_time);
+        this->historyCursorTo = dest;
+        this->historyCursorSet = true;
+    }
+
+    // A chain that ran out (or wasn't started yet) continues at its oldest packet not looked at, if any were added
+    uint32_t chains[HISTORY_WALK_CHAINS];
+    historyChainHeads(dest, chains);
+    for (uint8_t c = 0; c < HISTORY_WALK_CHAINS; c++)
+        if (this->historyCursor[c] == NO_SEQ)
+            for (uint32_t seq = chains[c]; seq != NO_SEQ && seq >= this->historyCursorSeq; seq = historyAt(seq).prevInChain)
+                this->historyCursor[c] = seq;
+
+    // Take the packets of all chains in the order they were stored, until one is for dest
+    for (;;) {
+        uint8_t next = HISTORY_WALK_CHAINS;
+        for (uint8_t c = 0; c < HISTORY_WALK_CHAINS; c++)
+            if (this->historyCursor[c] != NO_SEQ &&
+                (next == HISTORY_WALK_CHAINS || this->historyCursor[c] < this->historyCursor[next]))
+                next = c;
+        if (next == HISTORY_WALK_CHAINS)
+            return this->historyNextSeq;
+
+        uint32_t seq = this->historyCursor[next];
+        this->historyCursor[next] = historyAt(seq).nextInChain;
+        this->historyCursorSeq = seq + 1;
+        if (historyWanted(historyAt(seq), dest, last_time))
+            return seq;
+    }
 }
 
 /**
@@ -161,6 +265,7 @@ meshtastic_MeshPacket *StoreForwardModule::getForPhone()
             if (histSize) {
                 this->busy = true;
                 this->busyTo = to;
+                this->historyCursorSet = false;
             } else {
                 return nullptr;
             }
@@ -186,25 +291,89 @@ void StoreForwardModule::historyAdd(const meshtastic_MeshPacket &mp)
 {
     const auto &p = mp.decoded;
 
-    if (this->packetHistoryTotalCount == this->records) {
-        LOG_WARN("S&F - PSRAM Full. Starting overwrite");
-        this->packetHistoryTotalCount = 0;
-        for (auto &i : lastRequest) {
-            i.second = 0; // Clear the last request index for each client device
-        }
+    if (!this->packetHistory || !this->records)
+        return;
+
+    PacketHistoryStruct h;
+    h.time = getTime();
+    h.to = mp.to;
+    h.channel = mp.channel;
+    h.from = getFrom(&mp);
+    h.id = mp.id;
+    h.reply_id = p.reply_id;
+    h.emoji = (bool)p.emoji;
+    h.payload_size = p.payload.size;
+    memcpy(h.payload, p.payload.bytes, meshtastic_Constants_DATA_PAYLOAD_LEN);
+
+    historyStore(h);
+    historyLog.append(h);
+}
+
+void StoreForwardModule::historyStore(const PacketHistoryStruct &packet)
+{
+    if (this->historyNextSeq >= this->records) {
+        if (this->historyNextSeq == this->records)
+            LOG_WARN("S&F - PSRAM Full. Starting overwrite");
+        // The oldest packet makes room, if it was the only one left of its chain that chain is gone
+        const PacketHistoryStruct &oldest = historyAt(historyFirstSeq());
+        if (oldest.nextInChain == NO_SEQ)
+            historyChainRemove(oldest.to, oldest.seq);
     }
 
-    this->packetHistory[this->packetHistoryTotalCount].time = getTime();
-    this->packetHistory[this->packetHistoryTotalCount].to = mp.to;
-    this->packetHistory[this->packetHistoryTotalCount].channel = mp.channel;
-    this->packetHistory[this->packetHistoryTotalCount].from = getFrom(&mp);
-    this->packetHistory[this->packetHistoryTotalCount].id = mp.id;
-    this->packetHistory[this->packetHistoryTotalCount].reply_id = p.reply_id;
-    this->packetHistory[this->packetHistoryTotalCount].emoji = (bool)p.emoji;
-    this->packetHistory[this->packetHistoryTotalCount].payload_size = p.payload.size;
-    memcpy(this->packetHistory[this->packetHistoryTotalCount].payload, p.payload.bytes, meshtastic_Constants_DATA_PAYLOAD_LEN);
-
-    this->packetHistoryTotalCount++;
+    if (this->historyNextSeq > historyFirstSeq() && packet.time < historyAt(this->historyNextSeq - 1).time)
+        this->historyUnorderedSeq = this->historyNextSeq;
+
+    PacketHistoryStruct &h = historyAt(this->historyNextSeq);
+    h = packet;
+    h.seq = this->historyNextSeq++;
+    h.nextInChain = NO_SEQ;
+    h.prevInChain = historyChainAppend(h.to, h.seq);
+    if (h.prevInChain != NO_SEQ)
+        historyAt(h.prevInChain).nextInChain = h.seq;
+}
+
+StoreForwardModule::HistoryChain *StoreForwardModule::historyChainFind(NodeNum to)
+{
+    return std::lower_bound(historyChains, historyChains + historyChainCount, to,
+                            [](const HistoryChain &c, NodeNum n) { return c.to < n; });
+}
+
+uint32_t StoreForwardModule::historyChainLast(NodeNum to)
+{
+    HistoryChain *c = historyChainFind(to);
+    return c != historyChains + historyChainCount && c->to == to ? c->lastSeq : NO_SEQ;
+}
+
+uint32_t StoreForwardModule::historyChainAppend(NodeNum to, uint32_t seq)
+{
+    HistoryChain *end = historyChains + historyChainCount;
+    HistoryChain *c = historyChainFind(to);
+    uint32_t *last = &historyOverflowLastSeq;
+    if (c != end && c->to == to) {
+        last = &c->lastSeq;
+    } else if (historyChainCount < STOREFORWARD_MAX_CHAINS) {
+        std::copy_backward(c, end, end + 1);
+        c->to = to;
+        c->lastSeq = NO_SEQ;
+        historyChainCount++;
+        last = &c->lastSeq;
+    }
+
+    uint32_t prev = *last;
+    *last = seq;
+    return prev;
+}
+
+void StoreForwardModule::historyChainRemove(NodeNum to, uint32_t seq)
+{
+    HistoryChain *end = historyChains + historyChainCount;
+    HistoryChain *c = historyChainFind(to);
+    if (c != end && c->to == to && c->lastSeq == seq) {
+        std::copy(c + 1, end, c);
+        historyChainCount--;
+    } else if (historyOverflowLastSeq == seq) {
+        historyOverflowLastSeq = NO_SEQ;
+    }
 }
 
 /**
@@ -235,54 +404,49 @@ bool StoreForwardModule::sendPayload(NodeNum dest, uint32_t last_time)
  */
 meshtastic_MeshPacket *StoreForwardModule::preparePayload(NodeNum dest, uint32_t last_time, bool local)
 {
-    for (uint32_t i = lastRequest[dest]; i < this->packetHistoryTotalCount; i++) {
-        if (this->packetHistory[i].time && (this->packetHistory[i].time > last_time)) {
-            /*  Copy the messages that were received by the server in the last msAgo
-                to the packetHistoryTXQueue structure.
-                Client not interested in packets from itself and only in broadcast packets or packets towards it. */
-            if (this->packetHistory[i].from != dest &&
-                (this->packetHistory[i].to == NODENUM_BROADCAST || this->packetHistory[i].to == dest)) {
-
-                meshtastic_MeshPacket *p = allocDataPacket();
-
-                p->to = local ? this->packetHistory[i].to : dest; // PhoneAPI can handle original `to`
-                p->from = this->packetHistory[i].from;
-                p->id = this->packetHistory[i].id;
-                p->channel = this->packetHistory[i].channel;
-                p->decoded.reply_id = this->packetHistory[i].reply_id;
-                p->rx_time = this->packetHistory[i].time;
-                p->decoded.emoji = (uint32_t)this->packetHistory[i].emoji;
-
-                // Let's assume that if the server received the S&F request that the client is in range.
-                //   TODO: Make this configurable.
-                p->want_ack = false;
-
-                if (local) { // PhoneAPI gets normal TEXT_MESSAGE_APP
-                    p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
-                    memcpy(p->decoded.payload.bytes, this->packetHistory[i].payload, this->packetHistory[i].payload_size);
-                    p->decoded.payload.size = this->packetHistory[i].payload_size;
-                } else {
-                    meshtastic_StoreAndForward sf = meshtastic_StoreAndForward_init_zero;
-                    sf.which_variant = meshtastic_StoreAndForward_text_tag;
-                    sf.variant.text.size = this->packetHistory[i].payload_size;
-                    memcpy(sf.variant.text.bytes, this->packetHistory[i].payload, this->packetHistory[i].payload_size);
-                    if (this->packetHistory[i].to == NODENUM_BROADCAST) {
-                        sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_BROADCAST;
-                    } else {
-                        sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_DIRECT;
-                    }
-
-                    p->decoded.payload.size = pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes),
-                                                                 &meshtastic_StoreAndForward_msg, &sf);
-                }
+    uint32_t seq = historyNextAvailable(dest, last_time);
+    if (seq == this->historyNextSeq)
+        return nullptr;
+
+    /*  Copy the messages that were received by the server in the last msAgo
+        to the packetHistoryTXQueue structure. */
+    const PacketHistoryStruct &h = historyAt(seq);
+    meshtastic_MeshPacket *p = allocDataPacket();
+
+    p->to = local ? h.to : dest; // PhoneAPI can handle original `to`
+    p->from = h.from;
+    p->id = h.id;
+    p->channel = h.channel;
+    p->decoded.reply_id = h.reply_id;
+    p->rx_time = h.time;
+    p->decoded.emoji = (uint32_t)h.emoji;
 
-                lastRequest[dest] = i + 1; // Update the last request index for the client device
+    // Let's assume that if the server received the S&F request that the client is in range.
+    //   TODO: Make this configurable.
+    p->want_ack = false;
 
-                return p;
-            }
+    if (local) { // PhoneAPI gets normal TEXT_MESSAGE_APP
+        p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+        memcpy(p->decoded.payload.bytes, h.payload, h.payload_size);
+        p->decoded.payload.size = h.payload_size;
+    } else {
+        meshtastic_StoreAndForward sf = meshtastic_StoreAndForward_init_zero;
+        sf.which_variant = meshtastic_StoreAndForward_text_tag;
+        sf.variant.text.size = h.payload_size;
+        memcpy(sf.variant.text.bytes, h.payload, h.payload_size);
+        if (h.to == NODENUM_BROADCAST) {
+            sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_BROADCAST;
+        } else {
+            sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_DIRECT;
         }
+
+        p->decoded.payload.size =
+            pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes), &meshtastic_StoreAndForward_msg, &sf);
     }
-    return nullptr;
+
+    lastRequest[dest] = seq + 1; // Update the last request position for the client device
+
+    return p;
 }
 
 /**
@@ -362,7 +526,7 @@ void StoreForwardModule::statsSend(uint32_t to)
     sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_STATS;
     sf.which_variant = meshtastic_StoreAndForward_stats_tag;
     sf.variant.stats.messages_total = this->records;
-    sf.variant.stats.messages_saved = this->packetHistoryTotalCount;
+    sf.variant.stats.messages_saved = historyCount();
     sf.variant.stats.messages_max = this->records;
     sf.variant.stats.up_time = millis() / 1000;
     sf.variant.stats.requests = this->requests;
@@ -399,7 +563,7 @@ ProcessMessage StoreForwardModule::handleReceived(const meshtastic_MeshPacket &m
                 }
             } else {
                 storeForwardModule->historyAdd(mp);
-                LOG_INFO("S&F stored. Message history contains %u records now", this->packetHistoryTotalCount);
+                LOG_INFO("S&F stored. Message history contains %u records now", historyCount());
             }
         } else if (!isFromUs(&mp) && mp.decoded.portnum == meshtastic_PortNum_STORE_FORWARD_APP) {
             auto &p = mp.decoded;
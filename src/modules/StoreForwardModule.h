@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ProtobufModule.h"
+#include "StoreForwardLog.h"
 #include "concurrency/OSThread.h"
 #include "mesh/generated/meshtastic/storeforward.pb.h"
 
@@ -9,6 +10,11 @@
 #include <functional>
 #include <unordered_map>
 
+// Destinations that get their own chain in the history index, packets to any further ones share the overflow chain
+#ifndef STOREFORWARD_MAX_CHAINS
+#define STOREFORWARD_MAX_CHAINS 64
+#endif
+
 struct PacketHistoryStruct {
     uint32_t time;
     uint32_t to;
@@ -19,6 +25,9 @@ struct PacketHistoryStruct {
     bool emoji;
     uint8_t payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
     pb_size_t payload_size;
+    uint32_t seq;         // Position in the history, the packet lives in slot seq % records
+    uint32_t prevInChain; // seq of the previous packet in the same chain, see StoreForwardModule::historyChains
+    uint32_t nextInChain; // seq of the next packet in the same chain
 };
 
 class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<meshtastic_StoreAndForward>
@@ -27,8 +36,32 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
     uint32_t busyTo = 0;
     char routerMessage[meshtastic_Constants_DATA_PAYLOAD_LEN] = {0};
 
+    /* The history is a ring of `records` packets, once full every new packet replaces the oldest one. Packets are numbered
+       by an ever increasing seq, so a position stays valid (or is recognizably gone) while the ring wraps. */
     PacketHistoryStruct *packetHistory = 0;
-    uint32_t packetHistoryTotalCount = 0;
+    static constexpr uint32_t NO_SEQ = UINT32_MAX;
+    uint32_t historyNextSeq = 0;      // seq of the next packet added, the ring holds [historyFirstSeq(), historyNextSeq)
+    uint32_t historyUnorderedSeq = 0; // Newest packet stored with an older time than the one before it (the clock went back)
+    StoreForwardLog historyLog;       // The same packets on the filesystem, to survive reboots
+
+    /* Packets are linked into chains by `to`: the broadcasts and the packets to each node, as long as there is room in
+       historyChains, and one shared chain for everything else. A client only has to walk the broadcast chain, its own
+       chain and the overflow chain. */
+    struct HistoryChain {
+        NodeNum to;
+        uint32_t lastSeq; // Newest packet of the chain
+    };
+    HistoryChain historyChains[STOREFORWARD_MAX_CHAINS]; // Sorted by `to`
+    uint32_t historyChainCount = 0;
+    uint32_t historyOverflowLastSeq = NO_SEQ;
+
+    /* Where sending the history to historyCursorTo is at, so sending it is one pass forward through its chains: the next
+       packet of each chain (NO_SEQ once it ran out), every packet of them before historyCursorSeq was looked at already. */
+    static constexpr uint8_t HISTORY_WALK_CHAINS = 3;
+    uint32_t historyCursor[HISTORY_WALK_CHAINS];
+    uint32_t historyCursorSeq = 0;
+    NodeNum historyCursorTo = 0;
+    bool historyCursorSet = false;
     uint32_t last_time = 0;
     uint32_t requestCount = 0;
 
@@ -37,7 +70,7 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
     bool is_client = false;
     bool is_server = false;
 
-    // Unordered_map stores the last request for each nodeNum (`to` field)
+    // Unordered_map stores the seq of the next packet to consider for each nodeNum (`to` field)
     std::unordered_map<NodeNum, uint32_t> lastRequest;
 
   public:
@@ -81,9 +114,58 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
         }
     }
 
+    virtual bool getWantedPortNums(std::vector<meshtastic_PortNum> &portNums) override
+    {
+        portNums.insert(portNums.end(), {meshtastic_PortNum_TEXT_MESSAGE_APP, meshtastic_PortNum_STORE_FORWARD_APP});
+        return true;
+    }
+
   private:
     void populatePSRAM();
 
+    uint32_t historyFirstSeq() const { return historyNextSeq > records ? historyNextSeq - records : 0; }
+    uint32_t historyCount() const { return historyNextSeq - historyFirstSeq(); }
+    PacketHistoryStruct &historyAt(uint32_t seq) { return packetHistory[seq % records]; }
+
+    /// Put a packet into the ring, replacing the oldest one if it is full
+    void historyStore(const PacketHistoryStruct &h);
+
+    /// @return the chain for to, or where it would go, in historyChains
+    HistoryChain *historyChainFind(NodeNum to);
+    /// @return the newest packet of the chain for to, NO_SEQ if there is none
+    uint32_t historyChainLast(NodeNum to);
+    /// Make seq the newest packet of the chain for to, starting a new chain if there is room
+    /// @return the packet that was the newest of that chain before, NO_SEQ if there was none
+    uint32_t historyChainAppend(NodeNum to, uint32_t seq);
+    /// The chain ending at the packet seq (to `to`) just lost its last packet
+    void historyChainRemove(NodeNum to, uint32_t seq);
+
+    /// @return the seq of the first packet stored after time, historyNextSeq if there is none
+    uint32_t historyFirstSeqAfter(uint32_t time);
+
+    /// Whether h is for dest: stored after last_time, broadcast or to dest, not from dest
+    static bool historyWanted(const PacketHistoryStruct &h, NodeNum dest, uint32_t last_time)
+    {
+        return h.time && h.time > last_time && (h.to == NODENUM_BROADCAST || h.to == dest) && h.from != dest;
+    }
+
+    /// @return the seq to look for packets for dest from, where it left off or the start of the time window if that is later
+    uint32_t historyStartSeq(NodeNum dest, uint32_t last_time);
+
+    /// Fill chains with the newest packet of each chain dest can have packets in, NO_SEQ for none
+    void historyChainHeads(NodeNum dest, uint32_t chains[HISTORY_WALK_CHAINS]);
+
+    /**
+     * Find the packets dest hasn't been sent yet: stored after last_time, broadcast or to dest, not from dest.
+     * Only walks the chains dest can have packets in, and only back to where dest left off.
+     * @param count if not NULL, set to the number of such packets
+     * @return the seq of the oldest one, or historyNextSeq if there is none
+     */
+    uint32_t historyFindAvailable(NodeNum dest, uint32_t last_time, uint32_t *count);
+
+    /// @return the next packet to send to dest, moving historyCursor past it, or historyNextSeq if there is none
+    uint32_t historyNextAvailable(NodeNum dest, uint32_t last_time);
+
     // S&F Defaults
     uint32_t historyReturnMax = 25;     // Return maximum of 25 records by default.
     uint32_t historyReturnWindow = 240; // Return history of last 4 hours by default.
@@ -1,6 +1,8 @@
 #include "DeviceTelemetry.h"
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
+#include "CryptoEngine.h"
 #include "Default.h"
+#include "LatencyStats.h"
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "PowerFSM.h"
@@ -150,6 +152,27 @@ meshtastic_Telemetry DeviceTelemetryModule::getLocalStatsTelemetry()
 
     LOG_INFO("num_packets_tx=%i, num_packets_rx=%i, num_packets_rx_bad=%i", telemetry.variant.local_stats.num_packets_tx,
              telemetry.variant.local_stats.num_packets_rx, telemetry.variant.local_stats.num_packets_rx_bad);
+    if (router) {
+        // Packets per number of trial decrypts, most need none (foreign hash) or one
+        uint32_t multiple = 0;
+        for (size_t i = 2; i <= MAX_NUM_CHANNELS; i++)
+            multiple += router->trialDecrypts[i];
+        LOG_INFO("Trial decrypts: none=%u, one=%u, several=%u", router->trialDecrypts[0], router->trialDecrypts[1], multiple);
+    }
+#if !MESHTASTIC_EXCLUDE_LATENCY_PROBES
+    // LocalStats has no fields for these, so they go out through the log (and the phone's debug log stream)
+    latencyStats.logSummary();
+#endif
+    concurrency::mainScheduler.logSummary();
+    if (RadioLibInterface::instance)
+        RadioLibInterface::instance->getContention().logSummary();
+#ifdef ARCH_PORTDUINO
+    if (SimRadio::instance)
+        SimRadio::instance->getContention().logSummary();
+#endif
+#if !(MESHTASTIC_EXCLUDE_PKI)
+    LOG_INFO("PKI shared key cache: hits=%u, misses=%u", crypto->getSharedKeyHits(), crypto->getSharedKeyMisses());
+#endif
 
     return telemetry;
 }
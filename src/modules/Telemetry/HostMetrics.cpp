@@ -3,14 +3,24 @@
 #include "MeshService.h"
 #if ARCH_PORTDUINO
 #include "PortduinoGlue.h"
-#include <filesystem>
+#include "concurrency/Scheduler.h"
 #endif
 
+void HostMetricsModule::startSampler()
+{
+#if ARCH_PORTDUINO
+    if (settingsMap[hostMetrics_interval] != 0)
+        sampler = new HostSampler(settingsStrings[hostMetrics_user_command], 60 * 1000 * settingsMap[hostMetrics_interval]);
+#endif
+}
+
 int32_t HostMetricsModule::runOnce()
 {
 #if ARCH_PORTDUINO
-    if (settingsMap[hostMetrics_interval] == 0) {
+    if (settingsMap[hostMetrics_interval] == 0 || !sampler) {
         return disable();
+    } else if (!sampler->get().valid) {
+        return 1000; // The first sample is still being taken
     } else {
         sendMetrics();
         return 60 * 1000 * settingsMap[hostMetrics_interval];
@@ -71,53 +81,31 @@ meshtastic_MeshPacket *HostMetricsModule::allocReply()
 #if ARCH_PORTDUINO
 meshtastic_Telemetry HostMetricsModule::getHostMetrics()
 {
-    std::string file_line;
     meshtastic_Telemetry t = meshtastic_Telemetry_init_zero;
     t.which_variant = meshtastic_Telemetry_host_metrics_tag;
     t.variant.host_metrics = meshtastic_HostMetrics_init_zero;
 
-    if (access("/proc/uptime", R_OK) == 0) {
-        std::ifstream proc_uptime("/proc/uptime");
-        if (proc_uptime.is_open()) {
-            std::getline(proc_uptime, file_line, ' ');
-            proc_uptime.close();
-            t.variant.host_metrics.uptime_seconds = stoul(file_line);
-        }
+    // Everything was read by the sampler thread already, nothing here waits on the host
+    HostSampler::Sample sample = sampler->get();
+    t.variant.host_metrics.uptime_seconds = sample.uptimeSeconds;
+    t.variant.host_metrics.diskfree1_bytes = sample.diskfreeBytes;
+    t.variant.host_metrics.freemem_bytes = sample.freememBytes;
+    t.variant.host_metrics.load1 = sample.load1;
+    t.variant.host_metrics.load5 = sample.load5;
+    t.variant.host_metrics.load15 = sample.load15;
+    if (sample.userCommandTimedOut)
+        LOG_WARN("HostMetrics user command took too long and was killed");
+    if (sample.userString.length() > 1) {
+        strncpy(t.variant.host_metrics.user_string, sample.userString.c_str(), sizeof(t.variant.host_metrics.user_string));
+        t.variant.host_metrics.user_string[sizeof(t.variant.host_metrics.user_string) - 1] = '\0';
+        t.variant.host_metrics.has_user_string = true;
     }
 
-    std::filesystem::space_info root = std::filesystem::space("/");
-    t.variant.host_metrics.diskfree1_bytes = root.available;
-
-    if (access("/proc/meminfo", R_OK) == 0) {
-        std::ifstream proc_meminfo("/proc/meminfo");
-        if (proc_meminfo.is_open()) {
-            do {
-                std::getline(proc_meminfo, file_line);
-            } while (file_line.find("MemAvailable") == std::string::npos);
-            proc_meminfo.close();
-            t.variant.host_metrics.freemem_bytes = stoull(file_line.substr(file_line.find_first_of("0123456789"))) * 1024;
-        }
-    }
-    if (access("/proc/loadavg", R_OK) == 0) {
-        std::ifstream proc_loadavg("/proc/loadavg");
-        if (proc_loadavg.is_open()) {
-            std::getline(proc_loadavg, file_line, ' ');
-            t.variant.host_metrics.load1 = stof(file_line) * 100;
-            std::getline(proc_loadavg, file_line, ' ');
-            t.variant.host_metrics.load5 = stof(file_line) * 100;
-            std::getline(proc_loadavg, file_line, ' ');
-            t.variant.host_metrics.load15 = stof(file_line) * 100;
-            proc_loadavg.close();
-        }
-    }
-    if (settingsStrings[hostMetrics_user_command] != "") {
-        std::string userCommandResult = exec(settingsStrings[hostMetrics_user_command].c_str());
-        if (userCommandResult.length() > 1) {
-            strncpy(t.variant.host_metrics.user_string, userCommandResult.c_str(), sizeof(t.variant.host_metrics.user_string));
-            t.variant.host_metrics.user_string[sizeof(t.variant.host_metrics.user_string) - 1] = '\0';
-            t.variant.host_metrics.has_user_string = true;
-        }
-    }
+    // HostMetrics has no fields for these, they go out through the log
+    uint32_t lagMeanMsec, lagMaxMsec;
+    concurrency::mainScheduler.takeLag(lagMeanMsec, lagMaxMsec);
+    LOG_INFO("meshtasticd: rss=%lluKB, cpu=%.1fs (%.1f%%), main loop lag mean=%ums, max=%ums",
+             (unsigned long long)(sample.rssBytes / 1024), sample.cpuMsec / 1000.0f, sample.cpuPercent, lagMeanMsec, lagMaxMsec);
     return t;
 }
 
@@ -1,6 +1,9 @@
 #pragma once
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
 #include "ProtobufModule.h"
+#if ARCH_PORTDUINO
+#include "HostSampler.h"
+#endif
 
 class HostMetricsModule : private concurrency::OSThread, public ProtobufModule<meshtastic_Telemetry>
 {
@@ -16,6 +19,7 @@ class HostMetricsModule : private concurrency::OSThread, public ProtobufModule<m
         uptimeLastMs = millis();
         nodeStatusObserver.observe(&nodeStatus->onNewStatus);
         setIntervalFromNow(setStartDelay()); // Wait until NodeInfo is sent
+        startSampler();
     }
     virtual bool wantUIFrame() { return false; }
 
@@ -34,6 +38,12 @@ class HostMetricsModule : private concurrency::OSThread, public ProtobufModule<m
   private:
     meshtastic_Telemetry getHostMetrics();
 
+    /// Start sampling in the background, if host metrics are enabled
+    void startSampler();
+#if ARCH_PORTDUINO
+    HostSampler *sampler = NULL;
+#endif
+
     uint32_t lastSentToMesh = 0;
     uint32_t uptimeWrapCount;
     uint32_t uptimeLastMs;
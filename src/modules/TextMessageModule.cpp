@@ -26,4 +26,9 @@ ProcessMessage TextMessageModule::handleReceived(const meshtastic_MeshPacket &mp
 bool TextMessageModule::wantPacket(const meshtastic_MeshPacket *p)
 {
     return MeshService::isTextPayload(p);
+}
+
+bool TextMessageModule::getWantedPortNums(std::vector<meshtastic_PortNum> &portNums)
+{
+    return MeshService::getTextPayloadPortNums(portNums);
 }
\ No newline at end of file
@@ -377,9 +377,9 @@ void mqttInit()
 #if HAS_NETWORKING
 MQTT::MQTT() : MQTT(std::unique_ptr<MQTTClient>(new MQTTClient())) {}
 MQTT::MQTT(std::unique_ptr<MQTTClient> _mqttClient)
-    : concurrency::OSThread("mqtt"), mqttQueue(MAX_MQTT_QUEUE), mqttClient(std::move(_mqttClient)), pubSub(*mqttClient)
+    : concurrency::OSThread("mqtt"), mqttQueue(MQTT_QUEUE_BYTES), mqttClient(std::move(_mqttClient)), pubSub(*mqttClient)
 #else
-MQTT::MQTT() : concurrency::OSThread("mqtt"), mqttQueue(MAX_MQTT_QUEUE)
+MQTT::MQTT() : concurrency::OSThread("mqtt"), mqttQueue(MQTT_QUEUE_BYTES)
 #endif
 {
     if (moduleConfig.mqtt.enabled) {
@@ -578,11 +578,11 @@ int32_t MQTT::runOnce()
             return 5000; // If we don't want connection now, check again in 5 secs
         else {
             reconnect();
-            // If we succeeded, empty the queue one by one and start reading rapidly, else try again in 30 seconds (TCP
+            // If we succeeded, start emptying the queue and reading rapidly, else try again in 30 seconds (TCP
             // connections are EXPENSIVE so try rarely)
             if (isConnectedDirectly()) {
                 publishQueuedMessages();
-                return 200;
+                return mqttQueue.isEmpty() ? 200 : 20;
             } else
                 return 30000;
         }
@@ -591,6 +591,9 @@ int32_t MQTT::runOnce()
         if (!wantConnection) {
             LOG_INFO("MQTT link not needed, drop");
             pubSub.disconnect();
+        } else if (!mqttQueue.isEmpty()) {
+            // Catch up with what was queued while the server was gone, a batch per run
+            publishQueuedMessages();
         }
 
         powerFSM.trigger(EVENT_CONTACT_FROM_PHONE); // Suppress entering light sleep (because that would turn off bluetooth)
@@ -650,34 +653,51 @@ void MQTT::publishQueuedMessages()
     if (mqttQueue.isEmpty())
         return;
 
-    LOG_DEBUG("Publish enqueued MQTT message");
-    const std::unique_ptr<QueueEntry> entry(mqttQueue.dequeuePtr(0));
-    LOG_INFO("publish %s, %u bytes from queue", entry->topic.c_str(), entry->envBytes.size());
-    publish(entry->topic.c_str(), entry->envBytes.data(), entry->envBytes.size(), false);
+    // The client proxy hands every message to the phone queue, don't flood that
+    const size_t maxBatch = moduleConfig.mqtt.proxy_to_client_enabled ? 1 : SIZE_MAX;
+    const uint32_t start = millis();
+    size_t published = 0;
+    char topic[UINT8_MAX + 1];
+
+    do {
+        size_t envLen = mqttQueue.peek(topic, sizeof(topic) - 1, bytes, sizeof(bytes));
+        if (!envLen) { // Doesn't fit our buffer, can't be published anyway
+            mqttQueue.pop();
+            continue;
+        }
+        LOG_DEBUG("publish %s, %u bytes from queue", topic, envLen);
+        if (!publish(topic, bytes, envLen, false))
+            break; // Lost the server again, keep the message for next time
+        mqttQueue.pop();
+        published++;
 
 #if !defined(ARCH_NRF52) ||                                                                                                      \
     defined(NRF52_USE_JSON) // JSON is not supported on nRF52, see issue #2804 ### Fixed by using ArduinoJson ###
-    if (!moduleConfig.mqtt.json_enabled)
-        return;
+        if (!moduleConfig.mqtt.json_enabled)
+            continue;
 
-    // handle json topic
-    const DecodedServiceEnvelope env(entry->envBytes.data(), entry->envBytes.size());
-    if (!env.validDecode || env.packet == NULL || env.channel_id == NULL)
-        return;
+        // handle json topic
+        const DecodedServiceEnvelope env(bytes, envLen);
+        if (!env.validDecode || env.packet == NULL || env.channel_id == NULL)
+            continue;
 
-    auto jsonString = MeshPacketSerializer::JsonSerialize(env.packet);
-    if (jsonString.length() == 0)
-        return;
+        auto jsonString = MeshPacketSerializer::JsonSerialize(env.packet);
+        if (jsonString.length() == 0)
+            continue;
 
-    std::string topicJson;
-    if (env.packet->pki_encrypted) {
-        topicJson = jsonTopic + "PKI/" + owner.id;
-    } else {
-        topicJson = jsonTopic + env.channel_id + "/" + owner.id;
-    }
-    LOG_INFO("JSON publish message to %s, %u bytes: %s", topicJson.c_str(), jsonString.length(), jsonString.c_str());
-    publish(topicJson.c_str(), jsonString.c_str(), false);
+        std::string topicJson;
+        if (env.packet->pki_encrypted) {
+            topicJson = jsonTopic + "PKI/" + owner.id;
+        } else {
+            topicJson = jsonTopic + env.channel_id + "/" + owner.id;
+        }
+        LOG_INFO("JSON publish message to %s, %u bytes: %s", topicJson.c_str(), jsonString.length(), jsonString.c_str());
+        publish(topicJson.c_str(), jsonString.c_str(), false);
 #endif // ARCH_NRF52 NRF52_USE_JSON
+    } while (!mqttQueue.isEmpty() && published < maxBatch && millis() - start < MQTT_DRAIN_BUDGET_MSEC);
+
+    LOG_INFO("Published %u queued MQTT messages in %ums, %u left, %u dropped since boot", published, millis() - start,
+             mqttQueue.numUsed(), mqttQueue.getDropped());
 }
 
 void MQTT::onSend(const meshtastic_MeshPacket &mp_encrypted, const meshtastic_MeshPacket &mp_decoded, ChannelIndex chIndex)
@@ -754,19 +774,11 @@ void MQTT::onSend(const meshtastic_MeshPacket &mp_encrypted, const meshtastic_Me
 #endif // ARCH_NRF52 NRF52_USE_JSON
     } else {
         LOG_INFO("MQTT not connected, queue packet");
-        QueueEntry *entry;
-        if (mqttQueue.numFree() == 0) {
-            LOG_WARN("MQTT queue is full, discard oldest");
-            entry = mqttQueue.dequeuePtr(0);
-        } else {
-            entry = new QueueEntry;
-        }
-        entry->topic = std::move(topic);
-        entry->envBytes.assign(bytes, numBytes);
-        if (mqttQueue.enqueue(entry, 0) == false) {
-            LOG_CRIT("Failed to add a message to mqttQueue!");
-            abort();
-        }
+        uint32_t dropped = mqttQueue.getDropped();
+        if (!mqttQueue.enqueue(topic.c_str(), bytes, numBytes))
+            LOG_WARN("MQTT message too big to queue, discard");
+        else if (mqttQueue.getDropped() != dropped)
+            LOG_WARN("MQTT queue is full, discard %u oldest", mqttQueue.getDropped() - dropped);
     }
 }
 
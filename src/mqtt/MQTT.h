@@ -24,7 +24,21 @@
 #include <memory>
 #endif
 
-#define MAX_MQTT_QUEUE 16
+#include "MQTTQueue.h"
+
+// Bytes set aside for messages queued while the server can't be reached, a service envelope is typically 60-250 bytes
+#ifndef MQTT_QUEUE_BYTES
+#ifdef ARCH_PORTDUINO
+#define MQTT_QUEUE_BYTES (64 * 1024)
+#else
+#define MQTT_QUEUE_BYTES (4 * 1024)
+#endif
+#endif
+
+// How long one run may spend publishing queued messages once the server is back
+#ifndef MQTT_DRAIN_BUDGET_MSEC
+#define MQTT_DRAIN_BUDGET_MSEC 20
+#endif
 
 /**
  * Our wrapper/singleton for sending/receiving MQTT "udp" packets.  This object isolates the MQTT protocol implementation from
@@ -58,6 +72,10 @@ class MQTT : private concurrency::OSThread
 
     void start() { setIntervalFromNow(0); };
 
+    /// Messages waiting for the server, and messages dropped since boot because too many were waiting
+    size_t getQueueDepth() { return mqttQueue.numUsed(); }
+    uint32_t getQueueDrops() { return mqttQueue.getDropped(); }
+
     bool isUsingDefaultServer() { return isConfiguredForDefaultServer; }
     bool isUsingDefaultRootTopic() { return isConfiguredForDefaultRootTopic; }
 
@@ -65,11 +83,7 @@ class MQTT : private concurrency::OSThread
     static bool isValidConfig(const meshtastic_ModuleConfig_MQTTConfig &config) { return isValidConfig(config, nullptr); }
 
   protected:
-    struct QueueEntry {
-        std::string topic;
-        std::basic_string<uint8_t> envBytes; // binary/pb_encode_to_bytes ServiceEnvelope
-    };
-    PointerQueue<QueueEntry> mqttQueue;
+    MQTTQueue mqttQueue;
 
     int reconnectCount = 0;
     bool isConfiguredForDefaultServer = true;
@@ -127,6 +141,7 @@ class MQTT : private concurrency::OSThread
     /// Called when a new publish arrives from the MQTT server
     void onReceive(char *topic, byte *payload, size_t length);
 
+    /// Publish queued messages until the queue is empty or MQTT_DRAIN_BUDGET_MSEC is used up
     void publishQueuedMessages();
 
     void publishNodeInfo();
@@ -0,0 +1,83 @@
+#include "MQTTQueue.h"
+#include <string.h>
+
+MQTTQueue::MQTTQueue(size_t _capacity) : ring(new uint8_t[_capacity]), capacity(_capacity) {}
+
+MQTTQueue::~MQTTQueue()
+{
+    delete[] ring;
+}
+
+void MQTTQueue::write(size_t pos, const uint8_t *src, size_t len)
+{
+    pos %= capacity;
+    size_t first = len < capacity - pos ? len : capacity - pos;
+    memcpy(ring + pos, src, first);
+    memcpy(ring, src + first, len - first);
+}
+
+void MQTTQueue::read(size_t pos, uint8_t *dst, size_t len) const
+{
+    pos %= capacity;
+    size_t first = len < capacity - pos ? len : capacity - pos;
+    memcpy(dst, ring + pos, first);
+    memcpy(dst + first, ring, len - first);
+}
+
+size_t MQTTQueue::headSize() const
+{
+    uint8_t header[HEADER_LEN];
+    read(head, header, HEADER_LEN);
+    return HEADER_LEN + header[0] + (header[1] | (header[2] << 8));
+}
+
+bool MQTTQueue::enqueue(const char *topic, const uint8_t *envelope, size_t envelopeLen)
+{
+    size_t topicLen = strlen(topic);
+    size_t size = HEADER_LEN + topicLen + envelopeLen;
+    if (topicLen > UINT8_MAX || envelopeLen > UINT16_MAX || size > capacity)
+        return false;
+
+    while (capacity - used < size) {
+        pop();
+        dropped++;
+    }
+
+    size_t tail = head + used;
+    uint8_t header[HEADER_LEN] = {(uint8_t)topicLen, (uint8_t)(envelopeLen & 0xff), (uint8_t)(envelopeLen >> 8)};
+    write(tail, header, HEADER_LEN);
+    write(tail + HEADER_LEN, (const uint8_t *)topic, topicLen);
+    write(tail + HEADER_LEN + topicLen, envelope, envelopeLen);
+    used += size;
+    count++;
+    return true;
+}
+
+size_t MQTTQueue::peek(char *topic, size_t maxTopicLen, uint8_t *envelope, size_t maxEnvelopeLen) const
+{
+    if (!count)
+        return 0;
+
+    uint8_t header[HEADER_LEN];
+    read(head, header, HEADER_LEN);
+    size_t topicLen = header[0];
+    size_t envelopeLen = header[1] | (header[2] << 8);
+    if (topicLen > maxTopicLen || envelopeLen > maxEnvelopeLen)
+        return 0;
+
+    read(head + HEADER_LEN, (uint8_t *)topic, topicLen);
+    topic[topicLen] = '\0';
+    read(head + HEADER_LEN + topicLen, envelope, envelopeLen);
+    return envelopeLen;
+}
+
+void MQTTQueue::pop()
+{
+    if (!count)
+        return;
+
+    size_t size = headSize();
+    head = (head + size) % capacity;
+    used -= size;
+    count--;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Service envelopes waiting for the MQTT server to come back, together with their topics.
+ *
+ * All messages share one byte ring that is allocated up front, each one stored as [topic length:1][envelope length:2]
+ * [topic][envelope] and allowed to wrap around the end of the ring. Queuing copies the bytes in and never allocates. When
+ * there's no room, the oldest messages are dropped to make some.
+ */
+class MQTTQueue
+{
+  public:
+    explicit MQTTQueue(size_t capacity);
+    ~MQTTQueue();
+
+    /// Queue a message, dropping the oldest ones if needed. @return false if it can't fit even in an empty ring
+    bool enqueue(const char *topic, const uint8_t *envelope, size_t envelopeLen);
+
+    /**
+     * Copy out the oldest message without removing it
+     * @param topic receives the zero terminated topic, at least maxTopicLen + 1 bytes
+     * @param envelope receives the envelope, at least maxEnvelopeLen bytes
+     * @return the envelope length, 0 if the queue is empty or the message doesn't fit the buffers
+     */
+    size_t peek(char *topic, size_t maxTopicLen, uint8_t *envelope, size_t maxEnvelopeLen) const;
+
+    /// Remove the oldest message
+    void pop();
+
+    bool isEmpty() const { return !count; }
+    size_t numUsed() const { return count; }
+    size_t bytesUsed() const { return used; }
+
+    /// Messages dropped because the ring was full, since boot
+    uint32_t getDropped() const { return dropped; }
+
+  private:
+    static const size_t HEADER_LEN = 3;
+
+    uint8_t *ring;
+    size_t capacity;
+    size_t head = 0; // First byte of the oldest message
+    size_t used = 0;
+    size_t count = 0;
+    uint32_t dropped = 0;
+
+    void write(size_t pos, const uint8_t *src, size_t len);
+    void read(size_t pos, uint8_t *dst, size_t len) const;
+    /// @return the total size of the message at head
+    size_t headSize() const;
+};
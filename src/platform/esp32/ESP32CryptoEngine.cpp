@@ -3,39 +3,39 @@
 
 #include "mbedtls/aes.h"
 
-class ESP32CryptoEngine : public CryptoEngine
+/// Key schedule in an mbedtls context, which uses the AES hardware of the ESP32
+class ESP32KeySchedule : public AESKeySchedule
 {
-
     mbedtls_aes_context aes;
 
   public:
-    ESP32CryptoEngine() { mbedtls_aes_init(&aes); }
+    ESP32KeySchedule() { mbedtls_aes_init(&aes); }
+
+    ~ESP32KeySchedule() { mbedtls_aes_free(&aes); }
 
-    ~ESP32CryptoEngine() { mbedtls_aes_free(&aes); }
+    virtual void setKey(const uint8_t *key, size_t keyLen) override { mbedtls_aes_setkey_enc(&aes, key, keyLen * 8); }
+
+    virtual void encryptBlock(uint8_t *out, const uint8_t *in) override
+    {
+        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, in, out);
+    }
 
     /**
-     * Encrypt a packet
-     *
-     * @param bytes is updated in place
-     *  TODO: return bool, and handle graciously when something fails
+     * The whole packet in one call, so the hardware is claimed once rather than per block. mbedtls counts with all 16 bytes
+     * of the counter, which for packets of up to MAX_BLOCKSIZE never carries out of the counterSize bytes anyway.
      */
-    virtual void encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, uint8_t *bytes) override
+    virtual void ctr(uint8_t *counter, size_t counterSize, size_t numBytes, uint8_t *bytes) override
     {
-        if (_key.length > 0) {
-            if (numBytes <= MAX_BLOCKSIZE) {
-                mbedtls_aes_setkey_enc(&aes, _key.bytes, _key.length * 8);
-                static uint8_t scratch[MAX_BLOCKSIZE];
-                uint8_t stream_block[16];
-                size_t nc_off = 0;
-                memcpy(scratch, bytes, numBytes);
-                memset(scratch + numBytes, 0,
-                       sizeof(scratch) - numBytes); // Fill rest of buffer with zero (in case cypher looks at it)
-                mbedtls_aes_crypt_ctr(&aes, numBytes, &nc_off, _nonce, stream_block, scratch, bytes);
-            } else {
-                LOG_ERROR("Packet too large for crypto engine: %d. noop encryption!", numBytes);
-            }
-        }
+        uint8_t stream_block[16];
+        size_t nc_off = 0;
+        mbedtls_aes_crypt_ctr(&aes, numBytes, &nc_off, counter, stream_block, bytes, bytes);
     }
 };
 
-CryptoEngine *crypto = new ESP32CryptoEngine();
\ No newline at end of file
+class ESP32CryptoEngine : public CryptoEngine
+{
+  protected:
+    virtual AESKeySchedule *newKeySchedule(size_t keyLen) override { return new ESP32KeySchedule(); }
+};
+
+CryptoEngine *crypto = new ESP32CryptoEngine();
@@ -2,6 +2,34 @@
 #include "aes-256/tiny-aes.h"
 #include "configuration.h"
 #include <Adafruit_nRFCrypto.h>
+
+/// AES256 key expanded by tiny-aes, the same code the AES256 channels always used here
+class TinyAESKeySchedule : public AESKeySchedule
+{
+    AES_ctx ctx;
+
+  public:
+    ~TinyAESKeySchedule() { memset(&ctx, 0, sizeof(ctx)); }
+
+    virtual void setKey(const uint8_t *key, size_t keyLen) override { AES_init_ctx(&ctx, key); }
+
+    // tiny-aes only exposes CTR, and the key stream for one block is E(K, counter)
+    virtual void encryptBlock(uint8_t *out, const uint8_t *in) override
+    {
+        AES_ctx_set_iv(&ctx, in);
+        memset(out, 0, AES_BLOCKLEN);
+        AES_CTR_xcrypt_buffer(&ctx, out, AES_BLOCKLEN);
+    }
+
+    // tiny-aes counts with all 16 bytes, which for packets of up to MAX_BLOCKSIZE never carries out of counterSize bytes
+    virtual void ctr(uint8_t *counter, size_t counterSize, size_t numBytes, uint8_t *bytes) override
+    {
+        AES_ctx_set_iv(&ctx, counter);
+        AES_CTR_xcrypt_buffer(&ctx, bytes, numBytes);
+        memcpy(counter, ctx.Iv, AES_BLOCKLEN);
+    }
+};
+
 class NRF52CryptoEngine : public CryptoEngine
 {
   public:
@@ -12,10 +40,9 @@ class NRF52CryptoEngine : public CryptoEngine
     virtual void encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, uint8_t *bytes) override
     {
         if (_key.length > 16) {
-            AES_ctx ctx;
-            AES_init_ctx_iv(&ctx, _key.bytes, _nonce);
-            AES_CTR_xcrypt_buffer(&ctx, bytes, numBytes);
+            CryptoEngine::encryptAESCtr(_key, _nonce, numBytes, bytes);
         } else if (_key.length > 0) {
+            // The CryptoCell takes the raw key on every call, there is no schedule to keep
             nRFCrypto.begin();
             nRFCrypto_AES ctx;
             uint8_t myLen = ctx.blockLen(numBytes);
@@ -27,6 +54,14 @@ class NRF52CryptoEngine : public CryptoEngine
             memcpy(bytes, encBuf, numBytes);
         }
     }
+
+  protected:
+    virtual AESKeySchedule *newKeySchedule(size_t keyLen) override
+    {
+        if (keyLen == 32)
+            return new TinyAESKeySchedule();
+        return CryptoEngine::newKeySchedule(keyLen);
+    }
 };
 
-CryptoEngine *crypto = new NRF52CryptoEngine();
\ No newline at end of file
+CryptoEngine *crypto = new NRF52CryptoEngine();
@@ -0,0 +1,197 @@
+#include "HostSampler.h"
+
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/statvfs.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+static uint64_t steadyMsec()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Read a whole /proc file from an open fd into buf, NUL terminated. @return false if nothing could be read
+static bool readProcFile(int fd, char *buf, size_t size)
+{
+    if (fd < 0)
+        return false;
+    ssize_t n = pread(fd, buf, size - 1, 0);
+    if (n <= 0)
+        return false;
+    buf[n] = '\0';
+    return true;
+}
+
+HostSampler::HostSampler(const std::string &_userCommand, uint32_t _commandPeriodMsec)
+    : userCommand(_userCommand), commandPeriodMsec(_commandPeriodMsec)
+{
+    uptimeFd = open("/proc/uptime", O_RDONLY | O_CLOEXEC);
+    meminfoFd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+    loadavgFd = open("/proc/loadavg", O_RDONLY | O_CLOEXEC);
+    statFd = open("/proc/self/stat", O_RDONLY | O_CLOEXEC);
+    thread = std::thread(&HostSampler::run, this);
+}
+
+HostSampler::~HostSampler()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    stopCond.notify_one();
+    thread.join();
+
+    for (int fd : {uptimeFd, meminfoFd, loadavgFd, statFd})
+        if (fd >= 0)
+            close(fd);
+}
+
+HostSampler::Sample HostSampler::get()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return latest;
+}
+
+void HostSampler::run()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    while (!stopping) {
+        Sample s = latest;
+        guard.unlock();
+
+        sample(s);
+        uint64_t now = steadyMsec();
+        if (!userCommand.empty() && (!commandRan || now - lastCommandMsec >= commandPeriodMsec)) {
+            s.userString = runCommand(s.userCommandTimedOut);
+            lastCommandMsec = now;
+            commandRan = true;
+        }
+
+        guard.lock();
+        latest = s;
+        stopCond.wait_for(guard, std::chrono::milliseconds(SAMPLE_PERIOD_MSEC), [this] { return stopping; });
+    }
+}
+
+void HostSampler::sample(Sample &s)
+{
+    char buf[4096];
+
+    if (readProcFile(uptimeFd, buf, sizeof(buf)))
+        s.uptimeSeconds = strtoul(buf, NULL, 10);
+
+    if (readProcFile(meminfoFd, buf, sizeof(buf))) {
+        const char *avail = strstr(buf, "MemAvailable:");
+        if (avail)
+            s.freememBytes = strtoull(avail + strlen("MemAvailable:"), NULL, 10) * 1024;
+    }
+
+    if (readProcFile(loadavgFd, buf, sizeof(buf))) {
+        char *p = buf;
+        s.load1 = strtof(p, &p) * 100;
+        s.load5 = strtof(p, &p) * 100;
+        s.load15 = strtof(p, &p) * 100;
+    }
+
+    struct statvfs root;
+    if (statvfs("/", &root) == 0)
+        s.diskfreeBytes = (uint64_t)root.f_bavail * root.f_frsize;
+
+    // Fields after the command name, which can itself hold spaces and parens: utime and stime are the 14th and 15th, in
+    // clock ticks, rss is the 24th, in pages
+    const char *fields;
+    if (readProcFile(statFd, buf, sizeof(buf)) && (fields = strrchr(buf, ')'))) {
+        char *p = (char *)fields + 1;
+        unsigned long long values[25] = {};
+        for (int field = 3; field <= 24; field++) {
+            while (*p == ' ')
+                p++;
+            if (field == 3) // The state, a letter
+                p++;
+            else
+                values[field] = strtoull(p, &p, 10);
+        }
+        long ticksPerSec = sysconf(_SC_CLK_TCK);
+        if (ticksPerSec > 0)
+            s.cpuMsec = (values[14] + values[15]) * 1000 / ticksPerSec;
+        s.rssBytes = values[24] * sysconf(_SC_PAGESIZE);
+    }
+
+    uint64_t now = steadyMsec();
+    if (lastSampleMsec && now > lastSampleMsec)
+        s.cpuPercent = (float)(s.cpuMsec - lastCpuMsec) * 100 / (now - lastSampleMsec);
+    lastCpuMsec = s.cpuMsec;
+    lastSampleMsec = now;
+    s.valid = true;
+}
+
+std::string HostSampler::runCommand(bool &timedOut)
+{
+    timedOut = false;
+    std::string out;
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0)
+        return out;
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    char *argv[] = {(char *)"sh", (char *)"-c", (char *)userCommand.c_str(), NULL};
+    pid_t pid;
+    int err = posix_spawn(&pid, "/bin/sh", &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (err != 0) {
+        close(fds[0]);
+        return out;
+    }
+
+    uint64_t deadline = steadyMsec() + COMMAND_TIMEOUT_MSEC;
+    char buf[256];
+    while (true) {
+        uint64_t now = steadyMsec();
+        if (now >= deadline) {
+            timedOut = true;
+            break;
+        }
+        struct pollfd p = {fds[0], POLLIN, 0};
+        int ready = poll(&p, 1, deadline - now);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready <= 0) {
+            timedOut = ready == 0;
+            break;
+        }
+        ssize_t n = read(fds[0], buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) // The command is done printing
+            break;
+        if (out.size() < MAX_COMMAND_OUTPUT)
+            out.append(buf, n < (ssize_t)(MAX_COMMAND_OUTPUT - out.size()) ? n : MAX_COMMAND_OUTPUT - out.size());
+    }
+    close(fds[0]);
+
+    // It may also have closed stdout and kept running
+    while (!timedOut && waitpid(pid, NULL, WNOHANG) == 0) {
+        if (steadyMsec() >= deadline)
+            timedOut = true;
+        else
+            usleep(10 * 1000);
+    }
+    if (timedOut) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        out.clear();
+    }
+    return out;
+}
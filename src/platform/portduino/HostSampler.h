@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+/**
+ * Samples the host and this process on a thread of its own, so building a HostMetrics report never waits on /proc, the
+ * disk or the user's command.
+ *
+ * The /proc files stay open and are read again with pread() every SAMPLE_PERIOD_MSEC. The user command runs through
+ * /bin/sh once per command period, and is killed if it takes longer than COMMAND_TIMEOUT_MSEC. Nothing here logs, the
+ * logger belongs to the main loop.
+ */
+class HostSampler
+{
+  public:
+    struct Sample {
+        bool valid = false;
+        uint32_t uptimeSeconds = 0;
+        uint64_t freememBytes = 0;
+        uint64_t diskfreeBytes = 0;
+        uint16_t load1 = 0, load5 = 0, load15 = 0; // In 1/100ths
+
+        uint64_t rssBytes = 0;  // Resident memory of this process
+        uint64_t cpuMsec = 0;   // User and system CPU time of this process
+        float cpuPercent = 0;   // Of one core, between the last two samples
+        std::string userString; // What the user command printed last time, empty if it failed
+        bool userCommandTimedOut = false;
+    };
+
+    HostSampler(const std::string &userCommand, uint32_t commandPeriodMsec);
+    ~HostSampler();
+
+    /// The latest sample, valid is false until the first one is done
+    Sample get();
+
+  private:
+    static constexpr uint32_t SAMPLE_PERIOD_MSEC = 10 * 1000;
+    static constexpr uint32_t COMMAND_TIMEOUT_MSEC = 10 * 1000;
+    static constexpr size_t MAX_COMMAND_OUTPUT = 1024; // Way more than fits in user_string
+
+    std::string userCommand;
+    uint32_t commandPeriodMsec;
+
+    int uptimeFd, meminfoFd, loadavgFd, statFd;
+
+    // Only touched by the sampler thread
+    uint64_t lastCpuMsec = 0;
+    uint64_t lastSampleMsec = 0;
+    uint64_t lastCommandMsec = 0;
+    bool commandRan = false;
+
+    std::mutex lock;
+    std::condition_variable stopCond;
+    bool stopping = false;
+    Sample latest;
+    std::thread thread;
+
+    void run();
+    void sample(Sample &s);
+
+    /// @return what the command printed, empty if it failed or timed out
+    std::string runCommand(bool &timedOut);
+};
@@ -0,0 +1,567 @@
+#include "MeshSim.h"
+#include "mesh/NextHopRouter.h"
+#include "mesh/RadioInterface.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+
+/// A signal this far below the decoding limit is too weak to matter, not even as interference
+#define MESHSIM_INTERFERENCE_MARGIN_DB 10
+
+MeshSim::MeshSim(const Config &config) : cfg(config), rng(config.seed)
+{
+    slotTimeMsec = RadioInterface::computeSlotTimeMsec(cfg.bw, cfg.sf, false);
+    // Demodulation floor of the SX126x/SX127x, -7.5 dB at SF7 and 2.5 dB lower per SF step
+    snrLimitDb = -7.5 - 2.5 * (cfg.sf - 7);
+    noiseFloorDbm = -174 + 10 * log10(cfg.bw * 1000) + cfg.noiseFigureDb;
+    buildTopology();
+}
+
+void MeshSim::buildTopology()
+{
+    std::uniform_real_distribution<float> position(0, cfg.areaMeters);
+    std::normal_distribution<float> shadowing(0, cfg.shadowingSigmaDb);
+
+    nodes.assign(cfg.numNodes, Node());
+    for (auto &n : nodes) {
+        n.x = position(rng);
+        n.y = position(rng);
+    }
+    if (cfg.routerFraction > 0) {
+        for (auto &n : nodes)
+            n.isRouter = std::uniform_real_distribution<float>(0, 1)(rng) < cfg.routerFraction;
+    }
+
+    linkRssi.assign(cfg.numNodes, std::vector<float>(cfg.numNodes, -1000));
+    for (uint32_t a = 0; a < cfg.numNodes; a++) {
+        for (uint32_t b = a + 1; b < cfg.numNodes; b++) {
+            float d = std::max(1.0f, hypotf(nodes[a].x - nodes[b].x, nodes[a].y - nodes[b].y));
+            float loss = cfg.refLossDb + 10 * cfg.pathLossExponent * log10f(d) + shadowing(rng);
+            linkRssi[a][b] = linkRssi[b][a] = cfg.txPowerDbm - loss;
+            if (linkRssi[a][b] - noiseFloorDbm >= snrLimitDb) {
+                nodes[a].neighbours.push_back(b);
+                nodes[b].neighbours.push_back(a);
+            }
+        }
+    }
+}
+
+void MeshSim::schedule(uint32_t time, EventType type, uint32_t node, uint32_t arg)
+{
+    events.push(Event{time, nextSeq++, type, node, arg});
+}
+
+uint32_t MeshSim::packetTime() const
+{
+    return RadioInterface::getPacketTime(cfg.payloadLen + 16, cfg.bw, cfg.sf, cfg.cr, cfg.preambleLength);
+}
+
+void MeshSim::logChannelBusy(uint32_t node, uint32_t start, uint32_t end)
+{
+    // Split over the 10 second periods, like AirTime does on every tick
+    Node &n = nodes[node];
+    while (start < end) {
+        uint32_t period = start / UTIL_PERIOD_MSEC;
+        uint32_t periodEnd = (period + 1) * UTIL_PERIOD_MSEC;
+        uint8_t i = period % UTIL_PERIODS;
+        if (n.utilPeriod[i] != period) {
+            n.utilPeriod[i] = period;
+            n.utilMsec[i] = 0;
+        }
+        n.utilMsec[i] += std::min(end, periodEnd) - start;
+        start = std::min(end, periodEnd);
+    }
+}
+
+float MeshSim::channelUtilizationPercent(uint32_t node) const
+{
+    const Node &n = nodes[node];
+    uint32_t current = now / UTIL_PERIOD_MSEC;
+    uint32_t busy = 0;
+    for (uint8_t i = 0; i < UTIL_PERIODS; i++)
+        if (n.utilPeriod[i] + UTIL_PERIODS > current)
+            busy += n.utilMsec[i];
+    return 100.0f * busy / (UTIL_PERIODS * UTIL_PERIOD_MSEC);
+}
+
+uint8_t MeshSim::cwMin(uint32_t node) const
+{
+    return cfg.adaptiveContention ? nodes[node].contention.getCWmin() : RadioInterface::CWmin;
+}
+
+uint8_t MeshSim::cwMax(uint32_t node) const
+{
+    return cfg.adaptiveContention ? nodes[node].contention.getCWmax() : RadioInterface::CWmax;
+}
+
+uint32_t MeshSim::slotMsec(uint32_t node) const
+{
+    return cfg.adaptiveContention ? nodes[node].contention.getSlotTimeMsec(slotTimeMsec) : slotTimeMsec;
+}
+
+uint8_t MeshSim::cwSize(uint32_t node) const
+{
+    return RadioInterface::computeCWsizeForUtil(channelUtilizationPercent(node), cwMin(node), cwMax(node));
+}
+
+uint32_t MeshSim::txDelayMsec(uint32_t node)
+{
+    return RadioInterface::computeTxDelayMsec(cwSize(node), slotMsec(node), [this](uint32_t n) { return randomUpTo(n); });
+}
+
+uint32_t MeshSim::txDelayMsecWeighted(uint32_t node, float snr)
+{
+    uint8_t size = RadioInterface::computeCWsizeForSnr(snr, cwMin(node), cwMax(node));
+    return RadioInterface::computeTxDelayMsecWeighted(nodes[node].isRouter, size, slotMsec(node), slotTimeMsec,
+                                                      [this](uint32_t n) { return randomUpTo(n); });
+}
+
+uint32_t MeshSim::retransmissionMsec(uint32_t node) const
+{
+    return RadioInterface::computeRetransmissionMsec(packetTime(), cwSize(node), slotMsec(node), slotTimeMsec);
+}
+
+void MeshSim::originate(uint32_t node)
+{
+    SimPacket p = {};
+    p.from = node;
+    p.id = nextPacketId++;
+    p.hopLimit = p.hopStart = cfg.hopLimit;
+    p.relayNode = node;
+    p.nextHop = BROADCAST;
+    p.to = BROADCAST;
+
+    if (cfg.numNodes > 1 && std::uniform_real_distribution<float>(0, 1)(rng) < cfg.directFraction) {
+        p.to = (node + 1 + randomUpTo(cfg.numNodes - 1)) % cfg.numNodes;
+        p.wantAck = true;
+        if (cfg.router == NEXT_HOP) {
+            auto hop = nodes[node].nextHops.find(p.to);
+            if (hop != nodes[node].nextHops.end())
+                p.nextHop = hop->second;
+        }
+        nodes[node].retransmitting[p.id] = NextHopRouter::NUM_RELIABLE_RETX - 1;
+        schedule(now + retransmissionMsec(node), RETRANSMIT, node, p.id);
+    }
+
+    MessageStats &m = messages[p.id];
+    m.from = p.from;
+    m.to = p.to;
+    m.originatedAt = now;
+
+    // Our own packets are remembered too, so we ignore them when they get relayed back to us
+    nodes[node].seen[key(p.from, p.id)].nextHop = p.nextHop;
+    enqueueTx(node, p, txDelayMsec(node));
+}
+
+void MeshSim::retransmit(uint32_t node, uint32_t id)
+{
+    Node &n = nodes[node];
+    auto pending = n.retransmitting.find(id);
+    if (pending == n.retransmitting.end())
+        return; // Acked in the meantime
+
+    MessageStats &m = messages[id];
+    SimPacket p = {};
+    p.from = node;
+    p.to = m.to;
+    p.id = id;
+    p.hopLimit = p.hopStart = cfg.hopLimit;
+    p.relayNode = node;
+    p.nextHop = BROADCAST;
+    p.wantAck = true;
+
+    if (pending->second == 0) {
+        n.retransmitting.erase(pending);
+        return; // Out of retries
+    }
+    pending->second--;
+
+    if (cfg.router == NEXT_HOP) {
+        auto hop = n.nextHops.find(p.to);
+        if (hop != n.nextHops.end()) {
+            if (pending->second == 0) {
+                // Last try, like NextHopRouter: forget the route and fall back to flooding
+                n.nextHops.erase(hop);
+                numFallbacks++;
+            } else {
+                p.nextHop = hop->second;
+            }
+        }
+    }
+
+    numRetransmissions++;
+    cancelTx(node, p.from, p.id); // Don't send a stale copy still sitting in the queue
+    enqueueTx(node, p, txDelayMsec(node));
+    schedule(now + retransmissionMsec(node), RETRANSMIT, node, id);
+}
+
+void MeshSim::enqueueTx(uint32_t node, const SimPacket &p, uint32_t delay, bool isRelay)
+{
+    nodes[node].txQueue.push_back(QueuedTx{p, now + delay, now, isRelay});
+    armTxTimer(node);
+}
+
+void MeshSim::armTxTimer(uint32_t node)
+{
+    Node &n = nodes[node];
+    if (n.transmitting || n.txQueue.empty())
+        return; // txEnd() will call us again
+
+    uint32_t at = UINT32_MAX;
+    for (auto &q : n.txQueue)
+        at = std::min(at, q.txAfter);
+    at = std::max(at, now);
+    // Only ever keep the earliest timer, stale TX_ATTEMPT events are recognised by their time
+    if (at < n.txTimerAt) {
+        n.txTimerAt = at;
+        schedule(at, TX_ATTEMPT, node, at);
+    }
+}
+
+bool MeshSim::cancelTx(uint32_t node, uint32_t from, uint32_t id)
+{
+    auto &q = nodes[node].txQueue;
+    for (auto it = q.begin(); it != q.end(); ++it) {
+        if (it->p.from == from && it->p.id == id) {
+            q.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void MeshSim::txAttempt(uint32_t node)
+{
+    Node &n = nodes[node];
+    n.txTimerAt = UINT32_MAX;
+    if (n.transmitting || n.txQueue.empty())
+        return;
+
+    // First ready packet in queue order
+    auto next = n.txQueue.end();
+    for (auto it = n.txQueue.begin(); it != n.txQueue.end(); ++it) {
+        if (it->txAfter <= now) {
+            next = it;
+            break;
+        }
+    }
+    if (next == n.txQueue.end()) {
+        armTxTimer(node);
+        return;
+    }
+
+    // CAD and actively receiving checks, as in RadioLibInterface::canSendImmediately()
+    bool busy = false;
+    for (auto &r : n.receiving)
+        busy |= r.rssi - noiseFloorDbm >= snrLimitDb;
+    n.contention.txAttempt(busy);
+    if (busy) {
+        numCadBusy++;
+        next->txAfter = now + txDelayMsec(node);
+        armTxTimer(node);
+        return;
+    }
+
+    if (next->isRelay) {
+        numRelaysSent++;
+        totalRelayDelayMsec += now - next->enqueuedAt;
+    }
+    Transmission t = {node, next->p, now, now + packetTime()};
+    n.txQueue.erase(next);
+    n.transmitting = true;
+    numTx++;
+    totalAirtimeMsec += t.end - t.start;
+    logChannelBusy(node, t.start, t.end);
+
+    // Half duplex, whatever we were receiving is gone
+    for (auto &r : n.receiving) {
+        if (!r.lost) {
+            r.lost = true;
+            numHalfDuplexLosses++;
+        }
+    }
+
+    uint32_t txIndex = transmissions.size();
+    transmissions.push_back(t);
+
+    float decodable = noiseFloorDbm + snrLimitDb;
+    for (uint32_t m = 0; m < cfg.numNodes; m++) {
+        float rssi = linkRssi[node][m];
+        if (m == node || rssi < decodable - MESHSIM_INTERFERENCE_MARGIN_DB)
+            continue;
+
+        Reception r = {txIndex, rssi, rssi < decodable, false};
+        if (nodes[m].transmitting && !r.lost) {
+            r.lost = true;
+            numHalfDuplexLosses++;
+        }
+        // Collisions, the stronger signal survives if it is captureDb above the other one
+        for (auto &other : nodes[m].receiving) {
+            if (!r.lost && r.rssi < other.rssi + cfg.captureDb) {
+                r.lost = r.collided = true;
+                numCollisions++;
+            }
+            if (!other.lost && other.rssi < r.rssi + cfg.captureDb) {
+                other.lost = other.collided = true;
+                numCollisions++;
+            }
+        }
+        nodes[m].receiving.push_back(r);
+    }
+
+    schedule(t.end, TX_END, node, txIndex);
+}
+
+void MeshSim::txEnd(uint32_t txIndex)
+{
+    const Transmission &t = transmissions[txIndex];
+    nodes[t.sender].transmitting = false;
+
+    for (uint32_t m = 0; m < cfg.numNodes; m++) {
+        auto &rx = nodes[m].receiving;
+        for (auto it = rx.begin(); it != rx.end(); ++it) {
+            if (it->txIndex != txIndex)
+                continue;
+            Reception r = *it;
+            rx.erase(it);
+            logChannelBusy(m, t.start, t.end);
+            if (!r.lost || r.collided)
+                nodes[m].contention.rxFrame(!r.lost);
+            if (!r.lost)
+                handleReceived(m, t.p, r.rssi - noiseFloorDbm);
+            break;
+        }
+    }
+
+    armTxTimer(t.sender);
+}
+
+bool MeshSim::wasRelayer(const Node &n, uint32_t relayer, uint32_t from, uint32_t id) const
+{
+    auto rec = n.seen.find(key(from, id));
+    if (rec == n.seen.end())
+        return false;
+    return std::find(rec->second.relayers.begin(), rec->second.relayers.end(), relayer) != rec->second.relayers.end();
+}
+
+void MeshSim::learnNextHop(uint32_t node, const SimPacket &ack)
+{
+    // NextHopRouter::sniffReceived(): if whoever relayed the ACK to us also relayed the original packet we sent or relayed,
+    // it is a good next hop towards the ACK sender
+    Node &n = nodes[node];
+    uint32_t origFrom = ack.to;
+    if (!wasRelayer(n, node, origFrom, ack.requestId))
+        return;
+    if (wasRelayer(n, ack.relayNode, origFrom, ack.requestId) || (ack.hopStart == ack.hopLimit && ack.relayNode == ack.from))
+        n.nextHops[ack.from] = ack.relayNode;
+}
+
+void MeshSim::handleReceived(uint32_t node, const SimPacket &p, float snr)
+{
+    Node &n = nodes[node];
+    auto rec = n.seen.find(key(p.from, p.id));
+
+    if (rec != n.seen.end()) {
+        // A dupe, someone else already relayed it, so we don't have to (FloodingRouter::perhapsCancelDupe)
+        std::vector<uint32_t> &relayers = rec->second.relayers;
+        if (std::find(relayers.begin(), relayers.end(), p.relayNode) == relayers.end())
+            relayers.push_back(p.relayNode);
+
+        bool weAreNextHop = cfg.router == NEXT_HOP && rec->second.nextHop == node;
+        if (!weAreNextHop && p.from != node && cancelTx(node, p.from, p.id))
+            numCancelledRelays++;
+
+        // ReliableRouter: a repeated want_ack packet straight from its sender means our ACK got lost
+        if (p.to == node && p.wantAck && p.hopStart == p.hopLimit)
+            sendAck(node, p);
+        return;
+    }
+
+    SeenRecord &seen = n.seen[key(p.from, p.id)];
+    seen.nextHop = p.nextHop;
+    seen.relayers.push_back(p.relayNode);
+
+    if (p.requestId) {
+        if (cfg.router == NEXT_HOP)
+            learnNextHop(node, p);
+        if (p.to == node) {
+            MessageStats &m = messages[p.requestId];
+            if (!m.ackedAt)
+                m.ackedAt = now;
+            n.retransmitting.erase(p.requestId);
+            return;
+        }
+    } else if (p.to == node) {
+        MessageStats &m = messages[p.id];
+        if (!m.deliveredAt)
+            m.deliveredAt = now;
+        if (p.wantAck)
+            sendAck(node, p);
+        return;
+    } else if (p.to == BROADCAST) {
+        messages[p.id].reached++;
+    }
+
+    relay(node, p, snr);
+}
+
+void MeshSim::sendAck(uint32_t node, const SimPacket &p)
+{
+    SimPacket ack = {};
+    ack.from = node;
+    ack.to = p.from;
+    ack.id = nextPacketId++;
+    ack.requestId = p.id;
+    ack.hopLimit = ack.hopStart = cfg.hopLimit;
+    ack.relayNode = node;
+    ack.nextHop = BROADCAST;
+    if (cfg.router == NEXT_HOP) {
+        auto hop = nodes[node].nextHops.find(ack.to);
+        if (hop != nodes[node].nextHops.end())
+            ack.nextHop = hop->second;
+    }
+
+    nodes[node].seen[key(ack.from, ack.id)].nextHop = ack.nextHop;
+    numAcks++;
+    enqueueTx(node, ack, txDelayMsec(node));
+}
+
+void MeshSim::relay(uint32_t node, const SimPacket &p, float snr)
+{
+    if (p.hopLimit == 0)
+        return;
+
+    SimPacket copy = p;
+    if (cfg.router == NEXT_HOP && p.nextHop != BROADCAST) {
+        if (p.nextHop != node)
+            return; // Someone else was asked to relay this one
+        auto hop = nodes[node].nextHops.find(p.to);
+        copy.nextHop = hop != nodes[node].nextHops.end() && hop->second != p.relayNode ? hop->second : BROADCAST;
+    }
+    copy.hopLimit--;
+    copy.relayNode = node;
+
+    // We count as a relayer of our own copy, for learnNextHop()
+    nodes[node].seen[key(p.from, p.id)].relayers.push_back(node);
+    numRelays++;
+    enqueueTx(node, copy, txDelayMsecWeighted(node, snr), true);
+}
+
+void MeshSim::run()
+{
+    auto wallStart = std::chrono::steady_clock::now();
+    std::exponential_distribution<double> interval(1.0 / cfg.messageIntervalMsec);
+
+    // Spread the messages over the run, the originating node is picked when each one is due
+    uint32_t t = 0;
+    for (uint32_t i = 0; i < cfg.numMessages && cfg.numNodes; i++) {
+        t += (uint32_t)interval(rng);
+        schedule(t, ORIGINATE, randomUpTo(cfg.numNodes));
+    }
+
+    while (!events.empty()) {
+        Event e = events.top();
+        events.pop();
+        now = e.time;
+
+        switch (e.type) {
+        case ORIGINATE:
+            originate(e.node);
+            break;
+        case TX_ATTEMPT:
+            if (nodes[e.node].txTimerAt == e.arg)
+                txAttempt(e.node);
+            break;
+        case TX_END:
+            txEnd(e.arg);
+            break;
+        case RETRANSMIT:
+            retransmit(e.node, e.arg);
+            break;
+        }
+    }
+
+    wallClockSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+}
+
+void MeshSim::printReport()
+{
+    uint32_t numDirect = 0, numDelivered = 0, numAcked = 0, numBroadcast = 0;
+    uint64_t reached = 0;
+    std::vector<uint32_t> latencies;
+    for (auto &it : messages) {
+        const MessageStats &m = it.second;
+        if (m.to == BROADCAST) {
+            numBroadcast++;
+            reached += m.reached;
+            continue;
+        }
+        numDirect++;
+        if (m.ackedAt)
+            numAcked++;
+        if (m.deliveredAt) {
+            numDelivered++;
+            latencies.push_back(m.deliveredAt - m.originatedAt);
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    uint32_t neighbours = 0, isolated = 0, routers = 0;
+    for (auto &n : nodes) {
+        neighbours += n.neighbours.size();
+        if (n.neighbours.empty())
+            isolated++;
+        if (n.isRouter)
+            routers++;
+    }
+
+    printf("MeshSim: %u nodes in %.0fx%.0f m, seed %u, %s router\n", cfg.numNodes, cfg.areaMeters, cfg.areaMeters, cfg.seed,
+           cfg.router == NEXT_HOP ? "next hop" : "flooding");
+    printf("  radio: SF%u BW%.0f CR4/%u, airtime %u ms, slot %u ms\n", cfg.sf, cfg.bw, cfg.cr, packetTime(), slotTimeMsec);
+    printf("  topology: %.1f neighbours per node, %u isolated, %u routers\n",
+           cfg.numNodes ? (float)neighbours / cfg.numNodes : 0, isolated, routers);
+    if (numDirect)
+        printf("  direct messages: %u, delivered %.1f%%, acked %.1f%%\n", numDirect, 100.0 * numDelivered / numDirect,
+               100.0 * numAcked / numDirect);
+    if (numBroadcast && cfg.numNodes > 1)
+        printf("  broadcasts: %u, mean reach %.1f%% of the other nodes\n", numBroadcast,
+               100.0 * reached / numBroadcast / (cfg.numNodes - 1));
+    if (!latencies.empty()) {
+        uint64_t sum = 0;
+        for (uint32_t l : latencies)
+            sum += l;
+        printf("  delivery latency: mean %u ms, p50 %u ms, p95 %u ms\n", (uint32_t)(sum / latencies.size()),
+               latencies[latencies.size() / 2], latencies[latencies.size() * 95 / 100]);
+    }
+    printf("  transmissions: %u (relays queued %u, acks %u, retransmissions %u, next hop fallbacks %u)\n", numTx, numRelays,
+           numAcks, numRetransmissions, numFallbacks);
+    printf("  relays cancelled %u, CAD busy %u, collisions (per receiver) %u, half duplex losses %u\n", numCancelledRelays,
+           numCadBusy, numCollisions, numHalfDuplexLosses);
+    if (numRelaysSent)
+        printf("  relay delay: mean %u ms from reception to transmission\n",
+               (uint32_t)(totalRelayDelayMsec / numRelaysSent));
+    if (cfg.adaptiveContention) {
+        float cwMinSum = 0, cwMaxSum = 0, busy = 0, errors = 0;
+        for (auto &n : nodes) {
+            cwMinSum += n.contention.getCWmin();
+            cwMaxSum += n.contention.getCWmax();
+            busy += n.contention.getBusyPercent();
+            errors += n.contention.getErrorPercent();
+        }
+        printf("  adaptive contention: mean CW %.1f-%.1f, busy %.1f%%, rx errors %.1f%% at the end\n",
+               cwMinSum / cfg.numNodes, cwMaxSum / cfg.numNodes, busy / cfg.numNodes, errors / cfg.numNodes);
+    }
+    printf("  airtime: %.1f s total, %.2f%% duty cycle per node\n", totalAirtimeMsec / 1000.0,
+           now && cfg.numNodes ? 100.0 * totalAirtimeMsec / now / cfg.numNodes : 0);
+    printf("  simulated %.1f s in %.3f s\n", now / 1000.0, wallClockSecs);
+}
+
+int runMeshSim(const MeshSim::Config &config)
+{
+    MeshSim sim(config);
+    sim.run();
+    sim.printReport();
+    return 0;
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "mesh/ContentionEstimator.h"
+#include "mesh/RadioInterface.h"
+#include <cstdint>
+#include <map>
+#include <queue>
+#include <random>
+#include <vector>
+
+/**
+ * A deterministic discrete-event simulator of a whole LoRa mesh, run headless with `meshtasticd --meshsim NODES`.
+ *
+ * The firmware keeps its state in process wide singletons (nodeDB, router, config, channels...), so N complete stacks can't
+ * live in one process. Instead every simulated node runs a model of the relaying rules of FloodingRouter / NextHopRouter
+ * (dedup, hop limits, SNR weighted contention windows, dupe cancelling, next hop learning from ACKs, retransmissions with
+ * the fallback to flooding) on top of a radio model: airtime from RadioInterface::getPacketTime, CAD before transmitting,
+ * half duplex, log-distance path loss with shadowing, SNR limits per spreading factor and collisions with capture.
+ *
+ * Everything runs on a virtual millisecond clock from a single seeded PRNG, so a given (config, seed) always produces
+ * exactly the same report, much faster than real time.
+ *
+ * With adaptiveContention every node sizes its windows with its own ContentionEstimator, fed from its CAD results and from
+ * the frames it lost to collisions, like RadioInterface built with ADAPTIVE_CONTENTION_WINDOW.
+ */
+class MeshSim
+{
+  public:
+    enum RouterModel { FLOODING, NEXT_HOP };
+
+    struct Config {
+        uint32_t numNodes = 100;
+        uint32_t seed = 1;
+        RouterModel router = FLOODING;
+        uint32_t numMessages = 200;          // Messages originated over the run
+        uint32_t messageIntervalMsec = 30000; // Mean time between originated messages (exponential)
+        float directFraction = 0.5;          // Share of messages that are want_ack DMs, the rest are broadcasts
+        float routerFraction = 0;            // Share of nodes with the ROUTER role, they relay from the short window
+        uint8_t payloadLen = 40;             // Encrypted payload bytes, the 16 byte header is added on top
+        uint8_t hopLimit = 3;
+        float areaMeters = 20000; // Nodes are placed uniformly in a square of this side
+
+        // Radio, LongFast by default
+        float bw = 250;
+        uint8_t sf = 11;
+        uint8_t cr = 5;
+        uint16_t preambleLength = 16;
+        float txPowerDbm = 20;
+
+        // Path loss model: loss = refLossDb + 10 * exponent * log10(d / 1m) + shadowing
+        float refLossDb = 40;
+        float pathLossExponent = 3.0;
+        float shadowingSigmaDb = 6;
+        float noiseFigureDb = 6;
+        float captureDb = 6; // A reception survives an overlapping weaker one if it is this much stronger
+
+        bool adaptiveContention = false; // Size contention windows with ContentionEstimator, like ADAPTIVE_CONTENTION_WINDOW
+    };
+
+    explicit MeshSim(const Config &config);
+
+    /// Run the whole scenario, until every message has been delivered or given up on
+    void run();
+
+    /// Print the results of run() to stdout
+    void printReport();
+
+  private:
+    static const uint32_t BROADCAST = UINT32_MAX;
+    static const uint8_t UTIL_PERIODS = 6; // Same as AirTime, 6 periods of 10 seconds
+    static const uint32_t UTIL_PERIOD_MSEC = 10 * 1000;
+
+    struct SimPacket {
+        uint32_t from; // Originating node
+        uint32_t to;   // Destination node or BROADCAST
+        uint32_t id;
+        uint32_t relayNode; // Node that transmitted this copy
+        uint32_t nextHop;   // Node asked to relay this copy, or BROADCAST for no preference
+        uint32_t requestId; // For ACKs, the id of the acknowledged packet
+        uint8_t hopLimit, hopStart;
+        bool wantAck;
+    };
+
+    struct QueuedTx {
+        SimPacket p;
+        uint32_t txAfter;    // Contention window expiry
+        uint32_t enqueuedAt; // For the relay delay
+        bool isRelay;
+    };
+
+    struct Reception {
+        uint32_t txIndex;
+        float rssi;
+        bool lost;
+        bool collided; // Lost to a collision, the radio sees a frame it can't decode
+    };
+
+    struct SeenRecord {
+        uint32_t nextHop;
+        std::vector<uint32_t> relayers;
+    };
+
+    struct Node {
+        float x, y;
+        bool isRouter = false;            // ROUTER/REPEATER role, for the SNR weighted relay delay
+        std::vector<uint32_t> neighbours; // Nodes that can decode us
+        std::vector<QueuedTx> txQueue;
+        uint32_t txTimerAt = UINT32_MAX; // When the pending TX_ATTEMPT fires
+        bool transmitting = false;
+        std::vector<Reception> receiving;
+        std::map<uint64_t, SeenRecord> seen;        // PacketHistory equivalent, keyed by (from, id)
+        std::map<uint32_t, uint32_t> nextHops;      // Destination -> learned next hop
+        std::map<uint32_t, uint8_t> retransmitting; // Own want_ack packet id -> transmissions left
+        uint32_t utilMsec[UTIL_PERIODS] = {};       // Busy channel time per period, like AirTime::channelUtilization
+        uint32_t utilPeriod[UTIL_PERIODS] = {};     // Which period each utilMsec entry belongs to
+        ContentionEstimator contention = ContentionEstimator(RadioInterface::CWmin, RadioInterface::CWmax);
+    };
+
+    struct Transmission {
+        uint32_t sender;
+        SimPacket p;
+        uint32_t start, end;
+    };
+
+    enum EventType { ORIGINATE, TX_ATTEMPT, TX_END, RETRANSMIT };
+
+    struct Event {
+        uint32_t time;
+        uint64_t seq; // Keeps events at the same time in insertion order, for determinism
+        EventType type;
+        uint32_t node;
+        uint32_t arg;
+        bool operator>(const Event &o) const { return time != o.time ? time > o.time : seq > o.seq; }
+    };
+
+    struct MessageStats {
+        uint32_t from, to;
+        uint32_t originatedAt;
+        uint32_t deliveredAt = 0; // first delivery to the destination, 0 if never
+        uint32_t ackedAt = 0;     // want_ack DMs only
+        uint32_t reached = 0;     // broadcasts only, number of nodes that got it
+    };
+
+    Config cfg;
+    std::mt19937 rng;
+    uint32_t now = 0;
+    uint64_t nextSeq = 0;
+    uint32_t nextPacketId = 1;
+    uint32_t slotTimeMsec;
+    float snrLimitDb;
+    float noiseFloorDbm;
+
+    std::vector<Node> nodes;
+    std::vector<std::vector<float>> linkRssi; // linkRssi[a][b] == linkRssi[b][a]
+    std::vector<Transmission> transmissions;
+    std::map<uint32_t, MessageStats> messages; // By originating packet id
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+    // Counters for the report
+    uint32_t numTx = 0, numRelays = 0, numAcks = 0, numRetransmissions = 0, numCollisions = 0, numHalfDuplexLosses = 0,
+             numCadBusy = 0, numCancelledRelays = 0, numFallbacks = 0, numRelaysSent = 0;
+    uint64_t totalAirtimeMsec = 0, totalRelayDelayMsec = 0;
+    double wallClockSecs = 0;
+
+    void buildTopology();
+    void schedule(uint32_t time, EventType type, uint32_t node, uint32_t arg = 0);
+    uint32_t randomUpTo(uint32_t n) { return std::uniform_int_distribution<uint32_t>(0, n - 1)(rng); }
+
+    uint32_t packetTime() const;
+    void logChannelBusy(uint32_t node, uint32_t start, uint32_t end);
+    float channelUtilizationPercent(uint32_t node) const;
+    uint8_t cwMin(uint32_t node) const;
+    uint8_t cwMax(uint32_t node) const;
+    uint32_t slotMsec(uint32_t node) const;
+    uint8_t cwSize(uint32_t node) const;
+    uint32_t txDelayMsec(uint32_t node);
+    uint32_t txDelayMsecWeighted(uint32_t node, float snr);
+    uint32_t retransmissionMsec(uint32_t node) const;
+
+    void originate(uint32_t node);
+    void enqueueTx(uint32_t node, const SimPacket &p, uint32_t delay, bool isRelay = false);
+    void armTxTimer(uint32_t node);
+    void txAttempt(uint32_t node);
+    void txEnd(uint32_t txIndex);
+    void retransmit(uint32_t node, uint32_t id);
+    bool cancelTx(uint32_t node, uint32_t from, uint32_t id);
+    void handleReceived(uint32_t node, const SimPacket &p, float snr);
+    void sendAck(uint32_t node, const SimPacket &p);
+    void relay(uint32_t node, const SimPacket &p, float snr);
+    bool wasRelayer(const Node &n, uint32_t relayer, uint32_t from, uint32_t id) const;
+    void learnNextHop(uint32_t node, const SimPacket &ack);
+
+    static uint64_t key(uint32_t from, uint32_t id) { return ((uint64_t)from << 32) | id; }
+};
+
+/// Entry point used by portduinoSetup() when --meshsim is given, @return the process exit code
+int runMeshSim(const MeshSim::Config &config);
@@ -5,6 +5,7 @@
 #include "sleep.h"
 #include "target_specific.h"
 
+#include "MeshSim.h"
 #include "PortduinoGlue.h"
 #include "api/ServerAPI.h"
 #include "linux/gpio/LinuxGPIOPin.h"
@@ -34,6 +35,19 @@ Ch341Hal *ch341Hal = nullptr;
 char *configPath = nullptr;
 char *optionMac = nullptr;
 bool forceSimulated = false;
+static bool runSimulator = false;
+static MeshSim::Config simConfig;
+
+// Long only options, argp wants keys outside the printable range for those
+enum {
+    OPT_MESHSIM = 0x100,
+    OPT_MESHSIM_SEED,
+    OPT_MESHSIM_ROUTER,
+    OPT_MESHSIM_MESSAGES,
+    OPT_MESHSIM_AREA,
+    OPT_MESHSIM_ADAPTIVE,
+    OPT_MESHSIM_ROUTERS
+};
 
 // FIXME - move setBluetoothEnable into a HALPlatform class
 void setBluetoothEnable(bool enable)
@@ -68,6 +82,38 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
     case 'h':
         optionMac = arg;
         break;
+    case OPT_MESHSIM:
+        runSimulator = true;
+        if (sscanf(arg, "%u", &simConfig.numNodes) < 1)
+            return ARGP_ERR_UNKNOWN;
+        break;
+    case OPT_MESHSIM_SEED:
+        if (sscanf(arg, "%u", &simConfig.seed) < 1)
+            return ARGP_ERR_UNKNOWN;
+        break;
+    case OPT_MESHSIM_ROUTER:
+        if (strcmp(arg, "nexthop") == 0)
+            simConfig.router = MeshSim::NEXT_HOP;
+        else if (strcmp(arg, "flooding") == 0)
+            simConfig.router = MeshSim::FLOODING;
+        else
+            return ARGP_ERR_UNKNOWN;
+        break;
+    case OPT_MESHSIM_MESSAGES:
+        if (sscanf(arg, "%u", &simConfig.numMessages) < 1)
+            return ARGP_ERR_UNKNOWN;
+        break;
+    case OPT_MESHSIM_AREA:
+        if (sscanf(arg, "%f", &simConfig.areaMeters) < 1)
+            return ARGP_ERR_UNKNOWN;
+        break;
+    case OPT_MESHSIM_ADAPTIVE:
+        simConfig.adaptiveContention = true;
+        break;
+    case OPT_MESHSIM_ROUTERS:
+        if (sscanf(arg, "%f", &simConfig.routerFraction) < 1)
+            return ARGP_ERR_UNKNOWN;
+        break;
 
     case ARGP_KEY_ARG:
         return 0;
@@ -83,6 +129,13 @@ void portduinoCustomInit()
                                            {"config", 'c', "CONFIG_PATH", 0, "Full path of the .yaml config file to use."},
                                            {"hwid", 'h', "HWID", 0, "The mac address to assign to this virtual machine"},
                                            {"sim", 's', 0, 0, "Run in Simulated radio mode"},
+                                           {"meshsim", OPT_MESHSIM, "NODES", 0, "Simulate a mesh of NODES nodes and exit"},
+                                           {"meshsim-seed", OPT_MESHSIM_SEED, "SEED", 0, "Random seed for --meshsim"},
+                                           {"meshsim-router", OPT_MESHSIM_ROUTER, "flooding|nexthop", 0, "Router for --meshsim"},
+                                           {"meshsim-messages", OPT_MESHSIM_MESSAGES, "COUNT", 0, "Messages sent in --meshsim"},
+                                           {"meshsim-area", OPT_MESHSIM_AREA, "METERS", 0, "Side of the --meshsim area"},
+                                           {"meshsim-adaptive", OPT_MESHSIM_ADAPTIVE, 0, 0, "Adaptive contention in --meshsim"},
+                                           {"meshsim-routers", OPT_MESHSIM_ROUTERS, "FRACTION", 0, "ROUTER share in --meshsim"},
                                            {0}};
     static void *childArguments;
     static char doc[] = "Meshtastic native build.";
@@ -141,6 +194,9 @@ void getMacAddr(uint8_t *dmac)
  */
 void portduinoSetup()
 {
+    if (runSimulator)
+        exit(runMeshSim(simConfig));
+
     printf("Set up Meshtastic on Portduino...\n");
     int max_GPIO = 0;
     const configNames GPIO_lines[] = {cs_pin,
@@ -170,13 +170,16 @@ void SimRadio::onNotify(uint32_t notification)
         // has placed the unit into standby)  FIXME, how will this work if the chipset is in sleep mode?
         if (!txQueue.empty()) {
             if (!canSendImmediately()) {
+                contention.txAttempt(true);
                 // LOG_DEBUG("Currently Rx/Tx-ing: set random delay");
                 setTransmitDelay(); // currently Rx/Tx-ing: reset random delay
             } else {
                 if (isChannelActive()) { // check if there is currently a LoRa packet on the channel
+                    contention.txAttempt(true);
                     // LOG_DEBUG("Channel is active: set random delay");
                     setTransmitDelay(); // reset random delay
                 } else {
+                    contention.txAttempt(false);
                     // Send any outgoing packets we have ready
                     meshtastic_MeshPacket *txp = txQueue.dequeue();
                     assert(txp);
@@ -252,6 +255,7 @@ void SimRadio::startReceive(meshtastic_MeshPacket *p)
     if (isActivelyReceiving()) {
         LOG_WARN("Collision detected, dropping current and previous packet!");
         rxBad++;
+        contention.rxFrame(false);
         airTime->logAirtime(RX_ALL_LOG, getPacketTime(receivingPacket));
         packetPool.release(receivingPacket);
         receivingPacket = nullptr;
@@ -304,6 +308,7 @@ void SimRadio::handleReceiveInterrupt()
 
     LOG_DEBUG("HANDLE RECEIVE INTERRUPT");
     rxGood++;
+    contention.rxFrame(true);
 
     meshtastic_MeshPacket *mp = packetPool.allocCopy(*receivingPacket); // keep a copy in packetPool
     packetPool.release(receivingPacket);                                // release the original
@@ -0,0 +1,176 @@
+#include "JSONWriter.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+JSONWriter::JSONWriter(char *_buf, size_t _size) : buf(_buf), size(_size) {}
+
+void JSONWriter::put(char c)
+{
+    // Always keep a byte for the terminator
+    if (len + 1 >= size) {
+        overflow = true;
+        return;
+    }
+    buf[len++] = c;
+}
+
+void JSONWriter::put(const char *s, size_t n)
+{
+    if (len + n >= size) {
+        overflow = true;
+        return;
+    }
+    memcpy(buf + len, s, n);
+    len += n;
+}
+
+void JSONWriter::separate()
+{
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (depth == 0 || depth > MAX_DEPTH)
+        return;
+
+    uint32_t bit = 1UL << (depth - 1);
+    if (nonEmpty & bit)
+        put(',');
+    nonEmpty |= bit;
+}
+
+void JSONWriter::open(char c)
+{
+    separate();
+    put(c);
+    depth++;
+    if (depth <= MAX_DEPTH)
+        nonEmpty &= ~(1UL << (depth - 1));
+}
+
+void JSONWriter::close(char c)
+{
+    put(c);
+    if (depth)
+        depth--;
+}
+
+JSONWriter &JSONWriter::beginObject()
+{
+    open('{');
+    return *this;
+}
+
+JSONWriter &JSONWriter::endObject()
+{
+    close('}');
+    return *this;
+}
+
+JSONWriter &JSONWriter::beginArray()
+{
+    open('[');
+    return *this;
+}
+
+JSONWriter &JSONWriter::endArray()
+{
+    close(']');
+    return *this;
+}
+
+JSONWriter &JSONWriter::key(const char *name)
+{
+    string(name);
+    put(':');
+    afterKey = true;
+    return *this;
+}
+
+JSONWriter &JSONWriter::string(const char *s)
+{
+    return string(s, strlen(s));
+}
+
+// Same escaping as JSONValue::StringifyString, including its treatment of bytes >= 0x80 where char is signed
+JSONWriter &JSONWriter::string(const char *s, size_t n)
+{
+    separate();
+    put('"');
+    const char *end = s + n;
+    for (const char *iter = s; iter != end; ++iter) {
+        char chr = *iter;
+
+        if (chr == '"' || chr == '\\' || chr == '/') {
+            put('\\');
+            put(chr);
+        } else if (chr == '\b') {
+            put("\\b", 2);
+        } else if (chr == '\f') {
+            put("\\f", 2);
+        } else if (chr == '\n') {
+            put("\\n", 2);
+        } else if (chr == '\r') {
+            put("\\r", 2);
+        } else if (chr == '\t') {
+            put("\\t", 2);
+        } else if (chr < 0x20 || chr == 0x7F) {
+            char escaped[7];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", chr);
+            put(escaped, strlen(escaped));
+        } else if ((chr & 0xE0) == 0xC0 && end - iter - 1 >= 1) {
+            put(iter, 2);
+            iter += 1;
+        } else if ((chr & 0xF0) == 0xE0 && end - iter - 1 >= 2) {
+            put(iter, 3);
+            iter += 2;
+        } else if ((chr & 0xF8) == 0xF0 && end - iter - 1 >= 3) {
+            put(iter, 4);
+            iter += 3;
+        } else {
+            put(chr);
+        }
+    }
+    put('"');
+    return *this;
+}
+
+// JSONValue prints numbers through a std::stringstream with precision 15, which is "%.15g"
+JSONWriter &JSONWriter::number(double d)
+{
+    separate();
+    if (isinf(d) || isnan(d)) {
+        put("null", 4);
+    } else {
+        char digits[32];
+        int n = snprintf(digits, sizeof(digits), "%.15g", d);
+        put(digits, n);
+    }
+    return *this;
+}
+
+JSONWriter &JSONWriter::boolean(bool b)
+{
+    separate();
+    if (b)
+        put("true", 4);
+    else
+        put("false", 5);
+    return *this;
+}
+
+JSONWriter &JSONWriter::raw(const char *json, size_t n)
+{
+    separate();
+    put(json, n);
+    return *this;
+}
+
+size_t JSONWriter::finish()
+{
+    if (overflow || size == 0)
+        return 0;
+    buf[len] = '\0';
+    return len;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Writes JSON text straight into a caller supplied buffer, without building a tree of values first.
+ *
+ * Commas and colons are placed automatically, the caller only opens and closes containers, names object members with
+ * key() and writes one value after each key. Strings are escaped and numbers formatted exactly like JSONValue::Stringify
+ * does, so the output matches the tree based serializer byte for byte as long as members are written in sorted order
+ * (JSONObject is a std::map). Once the buffer is full everything else is dropped and finish() returns 0.
+ */
+class JSONWriter
+{
+  public:
+    JSONWriter(char *buf, size_t size);
+
+    JSONWriter &beginObject();
+    JSONWriter &endObject();
+    JSONWriter &beginArray();
+    JSONWriter &endArray();
+
+    /// Start the next member of the current object, write its value next
+    JSONWriter &key(const char *name);
+
+    JSONWriter &string(const char *s);
+    JSONWriter &string(const char *s, size_t len);
+    JSONWriter &number(double d);
+    JSONWriter &boolean(bool b);
+
+    /// Write a value that is already JSON encoded
+    JSONWriter &raw(const char *json, size_t len);
+
+    /// Zero terminate the text. @return its length, 0 if it didn't fit the buffer
+    size_t finish();
+
+  private:
+    static const uint8_t MAX_DEPTH = 32;
+
+    char *buf;
+    size_t size;
+    size_t len = 0;
+    bool overflow = false;
+    uint8_t depth = 0;
+    uint32_t nonEmpty = 0; // Bit per open container, set once it has an element
+    bool afterKey = false;
+
+    void put(char c);
+    void put(const char *s, size_t n);
+    /// Add the comma needed before the next element of the innermost container
+    void separate();
+    void open(char c);
+    void close(char c);
+};
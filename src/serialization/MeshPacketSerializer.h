@@ -1,6 +1,15 @@
+#pragma once
+
 #include <meshtastic/mesh.pb.h>
 #include <string>
 
+// Stack buffer tried first, enough for all but long text messages or traceroutes full of escaped characters
+#ifndef MESHPACKET_JSON_BUFFER
+#define MESHPACKET_JSON_BUFFER 1024
+#endif
+// Longest JSON a packet can turn into
+#define MESHPACKET_JSON_MAX 8192
+
 static const char hexChars[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
 
 class MeshPacketSerializer
@@ -9,15 +18,21 @@ class MeshPacketSerializer
     static std::string JsonSerialize(const meshtastic_MeshPacket *mp, bool shouldLog = true);
     static std::string JsonSerializeEncrypted(const meshtastic_MeshPacket *mp);
 
+    /**
+     * Write the JSON for a decoded packet straight into buf, without allocating anything per field
+     * @return the length of the zero terminated JSON, 0 if it doesn't fit in bufSize
+     */
+    static size_t JsonSerialize(const meshtastic_MeshPacket *mp, char *buf, size_t bufSize, bool shouldLog = true);
+
   private:
-    static std::string bytesToHex(const uint8_t *bytes, int len)
+    /// Write len bytes as hex to out, which has room for 2 * len chars. @return the number of chars written
+    static size_t bytesToHex(const uint8_t *bytes, int len, char *out)
     {
-        std::string result = "";
         for (int i = 0; i < len; ++i) {
             char const byte = bytes[i];
-            result += hexChars[(byte & 0xF0) >> 4];
-            result += hexChars[(byte & 0x0F) >> 0];
+            out[2 * i] = hexChars[(byte & 0xF0) >> 4];
+            out[2 * i + 1] = hexChars[(byte & 0x0F) >> 0];
         }
-        return result;
+        return 2 * len;
     }
-};
\ No newline at end of file
+};
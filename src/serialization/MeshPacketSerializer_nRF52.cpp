@@ -398,7 +398,8 @@ std::string MeshPacketSerializer::JsonSerializeEncrypted(const meshtastic_MeshPa
         jsonObj["hop_start"] = (unsigned int)(mp->hop_start);
     }
     jsonObj["size"] = (unsigned int)mp->encrypted.size;
-    auto encryptedStr = bytesToHex(mp->encrypted.bytes, mp->encrypted.size);
+    char hex[2 * sizeof(mp->encrypted.bytes)];
+    std::string encryptedStr(hex, bytesToHex(mp->encrypted.bytes, mp->encrypted.size, hex));
     jsonObj["bytes"] = encryptedStr.c_str();
 
     // serialize and write it to the stream
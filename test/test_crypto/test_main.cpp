@@ -1,5 +1,7 @@
 // trunk-ignore-all(gitleaks): These are dummy values. Not real secrets.
 #include "CryptoEngine.h"
+#include "CTR.h"
+#include "aes-ccm.h"
 
 #include "TestUtil.h"
 #include <unity.h>
@@ -152,6 +154,91 @@ void test_PKC(void)
     TEST_ASSERT_EQUAL_MEMORY(expected_decrypted, decrypted, 10);
 }
 
+void test_PKCSharedKeyCache(void)
+{
+    uint8_t private_key[32];
+    uint8_t other_private_key[32];
+    meshtastic_UserLite_public_key_t public_key;
+    uint8_t plaintext[10];
+    uint8_t encrypted[128] __attribute__((__aligned__));
+    uint8_t decrypted[128] __attribute__((__aligned__));
+    uint8_t first_shared[32];
+
+    HexToBytes(public_key.bytes, "db18fc50eea47f00251cb784819a3cf5fc361882597f589f0d7ff820e8064457");
+    public_key.size = 32;
+    HexToBytes(private_key, "a00330633e63522f8a4d81ec6d9d1e6617f6c8ffd3a4c698229537d44e522277");
+    HexToBytes(other_private_key, "18630f93598637c35da623a74559cf944374a559114c7937811041fc8605564a");
+    HexToBytes(plaintext, "08011204746573744800");
+    crypto->setDHPrivateKey(private_key);
+    crypto->clearSharedKeyCache();
+
+    uint32_t hits = crypto->getSharedKeyHits(), misses = crypto->getSharedKeyMisses();
+    TEST_ASSERT(crypto->encryptCurve25519(0, 0x0929, public_key, 0x13b2d662, 10, plaintext, encrypted));
+    memcpy(first_shared, crypto->shared_key, 32);
+    TEST_ASSERT_EQUAL_UINT32(misses + 1, crypto->getSharedKeyMisses());
+
+    // Same peer again comes from the cache, with the same key
+    TEST_ASSERT(crypto->decryptCurve25519(0x0929, public_key, 0x13b2d662, 22, encrypted, decrypted));
+    TEST_ASSERT_EQUAL_UINT32(hits + 1, crypto->getSharedKeyHits());
+    TEST_ASSERT_EQUAL_UINT32(misses + 1, crypto->getSharedKeyMisses());
+    TEST_ASSERT_EQUAL_MEMORY(first_shared, crypto->shared_key, 32);
+    TEST_ASSERT_EQUAL_MEMORY(plaintext, decrypted, 10);
+
+    // A new private key must not be served keys derived from the old one
+    crypto->setDHPrivateKey(other_private_key);
+    TEST_ASSERT(crypto->encryptCurve25519(0, 0x0929, public_key, 0x13b2d662, 10, plaintext, encrypted));
+    TEST_ASSERT_EQUAL_UINT32(misses + 2, crypto->getSharedKeyMisses());
+    TEST_ASSERT(memcmp(first_shared, crypto->shared_key, 32) != 0);
+
+    crypto->setDHPrivateKey(private_key);
+    TEST_ASSERT(crypto->encryptCurve25519(0, 0x0929, public_key, 0x13b2d662, 10, plaintext, encrypted));
+    TEST_ASSERT_EQUAL_UINT32(misses + 3, crypto->getSharedKeyMisses());
+    TEST_ASSERT_EQUAL_MEMORY(first_shared, crypto->shared_key, 32);
+
+    // More peers than fit push the least recently used one out
+    meshtastic_UserLite_public_key_t peer = public_key;
+    for (int i = 0; i < PKI_SHARED_KEY_CACHE_SIZE; i++) {
+        peer.bytes[0] = i + 1;
+        TEST_ASSERT(crypto->encryptCurve25519(0, 0x0929, peer, 0x13b2d662, 10, plaintext, encrypted));
+    }
+    misses = crypto->getSharedKeyMisses();
+    TEST_ASSERT(crypto->encryptCurve25519(0, 0x0929, public_key, 0x13b2d662, 10, plaintext, encrypted));
+    TEST_ASSERT_EQUAL_UINT32(misses + 1, crypto->getSharedKeyMisses());
+    TEST_ASSERT_EQUAL_MEMORY(first_shared, crypto->shared_key, 32);
+}
+
+void test_benchmarkPKC(void)
+{
+    const int packets = 50;
+    uint8_t private_key[32];
+    meshtastic_UserLite_public_key_t public_key;
+    uint8_t plaintext[64] = {0};
+    uint8_t encrypted[128] __attribute__((__aligned__));
+    uint8_t decrypted[128] __attribute__((__aligned__));
+
+    HexToBytes(public_key.bytes, "db18fc50eea47f00251cb784819a3cf5fc361882597f589f0d7ff820e8064457");
+    public_key.size = 32;
+    HexToBytes(private_key, "a00330633e63522f8a4d81ec6d9d1e6617f6c8ffd3a4c698229537d44e522277");
+    crypto->setDHPrivateKey(private_key);
+    TEST_ASSERT(crypto->encryptCurve25519(0, 0x0929, public_key, 1, sizeof(plaintext), plaintext, encrypted));
+
+    uint32_t start = micros();
+    for (int i = 0; i < packets; i++) {
+        crypto->clearSharedKeyCache();
+        TEST_ASSERT(crypto->decryptCurve25519(0x0929, public_key, 1, sizeof(plaintext) + 12, encrypted, decrypted));
+    }
+    uint32_t uncachedUs = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < packets; i++)
+        TEST_ASSERT(crypto->decryptCurve25519(0x0929, public_key, 1, sizeof(plaintext) + 12, encrypted, decrypted));
+    uint32_t cachedUs = micros() - start;
+
+    TEST_ASSERT_EQUAL_MEMORY(plaintext, decrypted, sizeof(plaintext));
+    LOG_INFO("PKI decrypt of %u bytes: %.1f us/packet deriving the key, %.1f us/packet from the cache",
+             (uint32_t)sizeof(plaintext), (float)uncachedUs / packets, (float)cachedUs / packets);
+}
+
 void test_AES_CTR(void)
 {
     uint8_t expected[32];
@@ -178,6 +265,87 @@ void test_AES_CTR(void)
     TEST_ASSERT_EQUAL_MEMORY(expected, plain, 16);
 }
 
+// The Crypto library's own CTR mode, which encryptAESCtr() used before it kept key schedules
+static void referenceAESCtr(const CryptoKey &k, const uint8_t *nonce, size_t numBytes, const uint8_t *in, uint8_t *out)
+{
+    CTRCommon *ctr;
+    if (k.length == 16)
+        ctr = new CTR<AES128>();
+    else
+        ctr = new CTR<AES256>();
+    ctr->setKey(k.bytes, k.length);
+    ctr->setIV(nonce, 16);
+    ctr->setCounterSize(4);
+    ctr->encrypt(out, in, numBytes);
+    delete ctr;
+}
+
+void test_AES_CTRMatchesReference(void)
+{
+    const int8_t keyLengths[] = {16, 32};
+    uint8_t nonce[16];
+    uint8_t plain[MAX_BLOCKSIZE], expected[MAX_BLOCKSIZE], actual[MAX_BLOCKSIZE];
+    CryptoKey k;
+
+    HexToBytes(nonce, "62d6b2130000000029090000000000f8"); // Counter carries into the next byte
+    for (size_t i = 0; i < sizeof(plain); i++)
+        plain[i] = i * 7;
+
+    for (int8_t keyLength : keyLengths) {
+        k.length = keyLength;
+        for (int i = 0; i < keyLength; i++)
+            k.bytes[i] = i + keyLength;
+        for (size_t len = 1; len <= MAX_BLOCKSIZE; len++) {
+            referenceAESCtr(k, nonce, len, plain, expected);
+            memcpy(actual, plain, len);
+            crypto->encryptAESCtr(k, nonce, len, actual);
+            TEST_ASSERT_EQUAL_MEMORY(expected, actual, len);
+        }
+    }
+}
+
+void test_benchmarkAES(void)
+{
+    const int packets = 500;
+    const size_t packetLen = 233; // Largest payload a LoRa packet carries
+    uint8_t bytes[MAX_BLOCKSIZE] = {0};
+    uint8_t nonce[16] = {0};
+    uint8_t auth[8];
+    CryptoKey k;
+    k.length = 32;
+    HexToBytes(k.bytes, "776BEFF2851DB06F4C8A0542C8696F6C6A81AF1EEC96B4D37FC1D689E6C1C104");
+
+    // Channel packets, CTR
+    uint32_t start = micros();
+    for (int i = 0; i < packets; i++) {
+        crypto->clearKeySchedules();
+        crypto->encryptAESCtr(k, nonce, packetLen, bytes);
+    }
+    uint32_t expandingUs = micros() - start;
+    start = micros();
+    for (int i = 0; i < packets; i++)
+        crypto->encryptAESCtr(k, nonce, packetLen, bytes);
+    uint32_t cachedUs = micros() - start;
+    LOG_INFO("AES256-CTR %u byte packets: %.1f us/packet expanding the key, %.1f us/packet (%.0f KB/s) with it kept",
+             (uint32_t)packetLen, (float)expandingUs / packets, (float)cachedUs / packets,
+             packetLen * packets * 1000000.0f / 1024 / cachedUs);
+
+    // PKI packets, CCM
+    start = micros();
+    for (int i = 0; i < packets; i++) {
+        crypto->clearKeySchedules();
+        aes_ccm_ae(k.bytes, 32, nonce, 8, bytes, packetLen, nullptr, 0, bytes, auth);
+    }
+    expandingUs = micros() - start;
+    start = micros();
+    for (int i = 0; i < packets; i++)
+        aes_ccm_ae(k.bytes, 32, nonce, 8, bytes, packetLen, nullptr, 0, bytes, auth);
+    cachedUs = micros() - start;
+    LOG_INFO("AES256-CCM %u byte packets: %.1f us/packet expanding the key, %.1f us/packet (%.0f KB/s) with it kept",
+             (uint32_t)packetLen, (float)expandingUs / packets, (float)cachedUs / packets,
+             packetLen * packets * 1000000.0f / 1024 / cachedUs);
+}
+
 void setup()
 {
     // NOTE!!! Wait for >2 secs
@@ -191,7 +359,11 @@ void setup()
     RUN_TEST(test_ECB_AES256);
     RUN_TEST(test_DH25519);
     RUN_TEST(test_AES_CTR);
+    RUN_TEST(test_AES_CTRMatchesReference);
     RUN_TEST(test_PKC);
+    RUN_TEST(test_PKCSharedKeyCache);
+    RUN_TEST(test_benchmarkPKC);
+    RUN_TEST(test_benchmarkAES);
     exit(UNITY_END()); // stop unit testing
 }
 
@@ -225,7 +225,7 @@ bool loopUntil(std::function<bool()> conditionMet)
 {
     long start = millis();
     while (start + 4000 > millis()) {
-        long delayMsec = concurrency::mainController.runOrDelay();
+        long delayMsec = concurrency::mainScheduler.runOrDelay();
         if (conditionMet())
             return true;
         concurrency::mainDelay.delay(std::min(delayMsec, 5L));
@@ -491,6 +491,32 @@ void test_sendQueued(void)
     TEST_ASSERT_EQUAL(decoded.id, env.packet->id);
 }
 
+// Test that a backlog too big for the queue drops the oldest messages, and all the rest goes out after reconnecting.
+void test_sendQueuedOverflow(void)
+{
+    pubsub->connected_ = false;
+    pubsub->refuseConnection_ = true;
+    TEST_ASSERT_TRUE(loopUntil([] { return !unitTest->getPubSub().connected(); }));
+
+    meshtastic_MeshPacket p = decoded;
+    for (int i = 0; i < 500; i++) {
+        p.id = decoded.id + i;
+        mqtt->onSend(encrypted, p, 0);
+    }
+    const int queued = unitTest->queueSize();
+    TEST_ASSERT_LESS_THAN(500, queued);
+    TEST_ASSERT_EQUAL(500 - queued, mqtt->getQueueDrops());
+
+    pubsub->refuseConnection_ = false;
+    TEST_ASSERT_TRUE(loopUntil([] { return unitTest->queueSize() == 0; }));
+
+    TEST_ASSERT_EQUAL(queued, pubsub->published_.size());
+    const DecodedServiceEnvelope &first = std::get<DecodedServiceEnvelope>(pubsub->published_.front().second);
+    TEST_ASSERT_EQUAL(decoded.id + 500 - queued, first.packet->id);
+    const DecodedServiceEnvelope &last = std::get<DecodedServiceEnvelope>(pubsub->published_.back().second);
+    TEST_ASSERT_EQUAL(decoded.id + 499, last.packet->id);
+}
+
 // Verify reconnecting with the proxy enabled does not reconnect to a MQTT server.
 void test_reconnectProxyDoesNotReconnectMqtt(void)
 {
@@ -882,6 +908,7 @@ void setup()
     RUN_TEST(test_noRangeTestAppOnDefaultServer);
     RUN_TEST(test_noDetectionSensorAppOnDefaultServer);
     RUN_TEST(test_sendQueued);
+    RUN_TEST(test_sendQueuedOverflow);
     RUN_TEST(test_reconnectProxyDoesNotReconnectMqtt);
     RUN_TEST(test_receiveEmptyMeshPacket);
     RUN_TEST(test_receiveDecodedProto);
@@ -0,0 +1,164 @@
+#include "DebugConfiguration.h"
+#include "FSCommon.h"
+#include "SPILock.h"
+#include "mesh/NodeIndex.h"
+#include "mesh/NodeJournal.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+
+#include <vector>
+
+static std::vector<meshtastic_NodeInfoLite> nodes;
+
+void setUp(void)
+{
+    nodes.assign(1000, meshtastic_NodeInfoLite());
+}
+
+void tearDown(void) {}
+
+// Same loop NodeDB::getMeshNode used before the index existed, kept here as the baseline
+static int linearFind(NodeNum n, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        if (nodes[i].num == n)
+            return i;
+    return -1;
+}
+
+static void fillNodes(size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        nodes[i].num = 0x10000000 + i * 7919; // spread out, like real nodenums derived from MACs
+}
+
+void test_findMatchesLinearScan(void)
+{
+    fillNodes(500);
+    NodeIndex index;
+    index.rebuild(&nodes, 500);
+
+    for (size_t i = 0; i < 500; i++)
+        TEST_ASSERT_EQUAL_INT(i, index.find(nodes[i].num));
+    TEST_ASSERT_EQUAL_INT(-1, index.find(0x12345));
+    TEST_ASSERT_EQUAL_INT(-1, index.find(0));
+}
+
+void test_insertAppendedNodes(void)
+{
+    NodeIndex index;
+    index.rebuild(&nodes, 0);
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        nodes[i].num = 1000 + i; // sequential nums must not cluster
+        index.insert(i);
+    }
+    for (size_t i = 0; i < nodes.size(); i++)
+        TEST_ASSERT_EQUAL_INT(i, index.find(1000 + i));
+}
+
+void test_rebuildAfterRemoval(void)
+{
+    fillNodes(10);
+    NodeIndex index;
+    index.rebuild(&nodes, 10);
+
+    // Same compaction NodeDB::removeNodeByNum does
+    NodeNum removed = nodes[3].num;
+    for (size_t i = 3; i < 9; i++)
+        nodes[i] = nodes[i + 1];
+    index.rebuild(&nodes, 9);
+
+    TEST_ASSERT_EQUAL_INT(-1, index.find(removed));
+    for (size_t i = 0; i < 9; i++)
+        TEST_ASSERT_EQUAL_INT(i, index.find(nodes[i].num));
+}
+
+void test_duplicatesReturnFirst(void)
+{
+    fillNodes(10);
+    nodes[7].num = nodes[2].num;
+    NodeIndex index;
+    index.rebuild(&nodes, 10);
+
+    TEST_ASSERT_EQUAL_INT(2, index.find(nodes[7].num));
+}
+
+void test_benchmarkLookup(void)
+{
+    const size_t lookups = 20000;
+    const size_t counts[] = {10, 100, 250, 500, 1000};
+
+    for (size_t count : counts) {
+        fillNodes(count);
+        NodeIndex index;
+        index.rebuild(&nodes, count);
+
+        volatile int sink = 0;
+        uint32_t start = micros();
+        for (size_t i = 0; i < lookups; i++)
+            sink += linearFind(nodes[(i * 31) % count].num, count);
+        uint32_t linearUs = micros() - start;
+
+        start = micros();
+        for (size_t i = 0; i < lookups; i++)
+            sink += index.find(nodes[(i * 31) % count].num);
+        uint32_t indexUs = micros() - start;
+
+        LOG_INFO("NodeDB lookup, %u nodes: linear %.3f us/lookup, indexed %.3f us/lookup", (uint32_t)count,
+                 (float)linearUs / lookups, (float)indexUs / lookups);
+    }
+}
+
+// A full database evicts its oldest node to make room for a new one, replaying the journal must end up with the new node
+void test_journalReplaysEvictionWhenFull(void)
+{
+    const size_t capacity = 8;
+    const size_t snapshotSize = 1000; // Only has to match between start() and replay()
+    std::vector<meshtastic_NodeInfoLite> db(capacity, meshtastic_NodeInfoLite());
+    for (size_t i = 0; i < capacity; i++) {
+        db[i].num = 0x1000 + i;
+        db[i].last_heard = i;
+    }
+
+    FSCom.mkdir("/prefs");
+    NodeJournal journal;
+    journal.start(snapshotSize, db, capacity);
+    std::vector<meshtastic_NodeInfoLite> snapshot = db;
+
+    // What getOrCreateMeshNode does when there is no room: drop the oldest node, append the new one
+    db.erase(db.begin());
+    db.push_back(meshtastic_NodeInfoLite());
+    db.back().num = 0x2000;
+    TEST_ASSERT_TRUE(journal.append(db, capacity));
+
+    NodeJournal reloaded;
+    size_t count = reloaded.replay(snapshot, capacity, snapshotSize);
+    journal.discard();
+
+    TEST_ASSERT_EQUAL_INT(capacity, count);
+    bool foundNew = false, foundEvicted = false;
+    for (size_t i = 0; i < count; i++) {
+        foundNew |= snapshot[i].num == 0x2000;
+        foundEvicted |= snapshot[i].num == 0x1000;
+    }
+    TEST_ASSERT_TRUE(foundNew);
+    TEST_ASSERT_FALSE(foundEvicted);
+}
+
+void setup()
+{
+    initializeTestEnvironment();
+    initSPI();
+    UNITY_BEGIN();
+    RUN_TEST(test_findMatchesLinearScan);
+    RUN_TEST(test_insertAppendedNodes);
+    RUN_TEST(test_rebuildAfterRemoval);
+    RUN_TEST(test_duplicatesReturnFirst);
+    RUN_TEST(test_benchmarkLookup);
+    RUN_TEST(test_journalReplaysEvictionWhenFull);
+    exit(UNITY_END());
+}
+
+void loop() {}
@@ -0,0 +1,219 @@
+#include "DebugConfiguration.h"
+#include "Observer.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+
+#include <list>
+#include <vector>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Records every notification, and optionally does something nasty from inside onNotify
+class Recorder : public Observer<int>
+{
+  public:
+    std::vector<int> *log;
+    int id;
+    int result = 0;
+    Observable<int> *unobserveOnNotify = NULL;
+    Recorder *deleteOnNotify = NULL;
+    Recorder *addOnNotify = NULL;
+    Observable<int> *source = NULL; // Where addOnNotify gets subscribed
+
+    Recorder(std::vector<int> *_log, int _id) : log(_log), id(_id) {}
+
+  protected:
+    virtual int onNotify(int) override
+    {
+        log->push_back(id);
+        if (unobserveOnNotify) {
+            unobserve(unobserveOnNotify);
+            unobserveOnNotify = NULL;
+        }
+        if (deleteOnNotify) {
+            delete deleteOnNotify;
+            deleteOnNotify = NULL;
+        }
+        if (addOnNotify) {
+            addOnNotify->observe(source);
+            addOnNotify = NULL;
+        }
+        return result;
+    }
+};
+
+void test_notifyInSubscriptionOrder(void)
+{
+    std::vector<int> log;
+    Observable<int> subject;
+    std::vector<Recorder *> recorders;
+    // More than fit inline, so the list has to spill to the heap
+    for (int i = 0; i < 20; i++) {
+        recorders.push_back(new Recorder(&log, i));
+        recorders.back()->observe(&subject);
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, subject.notifyObservers(1));
+    TEST_ASSERT_EQUAL_INT(20, log.size());
+    for (int i = 0; i < 20; i++)
+        TEST_ASSERT_EQUAL_INT(i, log[i]);
+
+    for (Recorder *r : recorders)
+        delete r;
+    log.clear();
+    subject.notifyObservers(2);
+    TEST_ASSERT_EQUAL_INT(0, log.size());
+}
+
+void test_abortStopsNotification(void)
+{
+    std::vector<int> log;
+    Observable<int> subject;
+    Recorder a(&log, 0), b(&log, 1), c(&log, 2);
+    a.observe(&subject);
+    b.observe(&subject);
+    c.observe(&subject);
+    b.result = 42;
+
+    TEST_ASSERT_EQUAL_INT(42, subject.notifyObservers(1));
+    TEST_ASSERT_EQUAL_INT(2, log.size());
+}
+
+void test_unobserveDuringNotify(void)
+{
+    std::vector<int> log;
+    Observable<int> subject;
+    Recorder a(&log, 0), b(&log, 1), c(&log, 2);
+    a.observe(&subject);
+    b.observe(&subject);
+    c.observe(&subject);
+    b.unobserveOnNotify = &subject;
+
+    subject.notifyObservers(1);
+    TEST_ASSERT_EQUAL_INT(3, log.size());
+
+    log.clear();
+    subject.notifyObservers(2);
+    TEST_ASSERT_EQUAL_INT(2, log.size());
+    TEST_ASSERT_EQUAL_INT(0, log[0]);
+    TEST_ASSERT_EQUAL_INT(2, log[1]);
+}
+
+void test_deleteLaterObserverDuringNotify(void)
+{
+    std::vector<int> log;
+    Observable<int> subject;
+    Recorder a(&log, 0), c(&log, 2);
+    Recorder *b = new Recorder(&log, 1);
+    a.observe(&subject);
+    b->observe(&subject);
+    c.observe(&subject);
+    a.deleteOnNotify = b;
+
+    subject.notifyObservers(1);
+    TEST_ASSERT_EQUAL_INT(2, log.size());
+    TEST_ASSERT_EQUAL_INT(0, log[0]);
+    TEST_ASSERT_EQUAL_INT(2, log[1]);
+}
+
+void test_observeDuringNotify(void)
+{
+    std::vector<int> log;
+    Observable<int> subject;
+    Recorder a(&log, 0), b(&log, 1);
+    a.source = &subject;
+    a.addOnNotify = &b;
+    a.observe(&subject);
+
+    subject.notifyObservers(1);
+    TEST_ASSERT_EQUAL_INT(1, log.size());
+
+    log.clear();
+    subject.notifyObservers(2);
+    TEST_ASSERT_EQUAL_INT(2, log.size());
+    TEST_ASSERT_EQUAL_INT(1, log[1]);
+}
+
+// Makes onNotify public, so the baseline can make the same virtual call Observable does
+class BaselineObserver : public Observer<int>
+{
+  public:
+    virtual int onNotify(int arg) override = 0;
+};
+
+class Counter : public BaselineObserver
+{
+  public:
+    volatile int sum = 0;
+
+    virtual int onNotify(int arg) override
+    {
+        sum += arg;
+        return 0;
+    }
+};
+
+// The std::list based Observable this replaced, kept here as the baseline
+class ListObservable
+{
+  public:
+    std::list<BaselineObserver *> observers;
+
+    int notifyObservers(int arg)
+    {
+        for (typename std::list<BaselineObserver *>::const_iterator iterator = observers.begin(); iterator != observers.end();
+             ++iterator) {
+            int result = (*iterator)->onNotify(arg);
+            if (result != 0)
+                return result;
+        }
+        return 0;
+    }
+};
+
+void test_benchmarkNotify(void)
+{
+    const size_t notifies = 20000;
+    const size_t counts[] = {1, 4, 16, 64};
+
+    for (size_t count : counts) {
+        std::vector<Counter> counters(count);
+        Observable<int> subject;
+        ListObservable baseline;
+        for (Counter &c : counters) {
+            c.observe(&subject);
+            baseline.observers.push_back(&c);
+        }
+
+        uint32_t start = micros();
+        for (size_t i = 0; i < notifies; i++)
+            baseline.notifyObservers(1);
+        uint32_t listUs = micros() - start;
+
+        start = micros();
+        for (size_t i = 0; i < notifies; i++)
+            subject.notifyObservers(1);
+        uint32_t vectorUs = micros() - start;
+
+        TEST_ASSERT_EQUAL_INT(2 * notifies, counters[0].sum);
+        LOG_INFO("Notify %u observers: std::list %.3f us/notify, contiguous %.3f us/notify", (uint32_t)count,
+                 (float)listUs / notifies, (float)vectorUs / notifies);
+    }
+}
+
+void setup()
+{
+    initializeTestEnvironment();
+    UNITY_BEGIN();
+    RUN_TEST(test_notifyInSubscriptionOrder);
+    RUN_TEST(test_abortStopsNotification);
+    RUN_TEST(test_unobserveDuringNotify);
+    RUN_TEST(test_deleteLaterObserverDuringNotify);
+    RUN_TEST(test_observeDuringNotify);
+    RUN_TEST(test_benchmarkNotify);
+    exit(UNITY_END());
+}
+
+void loop() {}
@@ -0,0 +1,224 @@
+#include "DebugConfiguration.h"
+#include "TestUtil.h"
+#include <unity.h>
+
+#ifdef ARCH_PORTDUINO
+#include "mesh/MeshPacketQueue.h"
+#include "mesh/NodeDB.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+bool CompareMeshPacketFunc(const meshtastic_MeshPacket *p1, const meshtastic_MeshPacket *p2);
+
+namespace
+{
+constexpr NodeNum OUR_NODE = 0x1000;
+
+class MockNodeDB : public NodeDB
+{
+};
+
+// The sorted vector MeshPacketQueue used before the heap, kept here as the reference its behaviour must match
+class SortedPacketQueue
+{
+    size_t maxLen;
+    std::vector<meshtastic_MeshPacket *> queue;
+
+    bool replaceLowerPriorityPacket(meshtastic_MeshPacket *p)
+    {
+        if (queue.empty())
+            return false;
+
+        auto *backPacket = queue.back();
+        if (!backPacket->tx_after && backPacket->priority < p->priority) {
+            queue.pop_back();
+            packetPool.release(backPacket);
+            enqueue(p);
+            return true;
+        }
+
+        if (backPacket->tx_after) {
+            auto it = queue.end();
+            auto refPacket = *--it;
+            for (; refPacket->tx_after && it != queue.begin(); refPacket = *--it)
+                ;
+            if (!refPacket->tx_after && refPacket->priority < p->priority) {
+                queue.erase(it);
+                packetPool.release(refPacket);
+                enqueue(p);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+  public:
+    explicit SortedPacketQueue(size_t _maxLen) : maxLen(_maxLen) {}
+
+    bool enqueue(meshtastic_MeshPacket *p)
+    {
+        if (queue.size() >= maxLen)
+            return replaceLowerPriorityPacket(p);
+
+        queue.insert(std::upper_bound(queue.begin(), queue.end(), p, CompareMeshPacketFunc), p);
+        return true;
+    }
+
+    size_t getFree() { return maxLen - queue.size(); }
+
+    meshtastic_MeshPacket *dequeue()
+    {
+        if (queue.empty())
+            return NULL;
+        auto *p = queue.front();
+        queue.erase(queue.begin());
+        return p;
+    }
+
+    meshtastic_MeshPacket *getFront() { return queue.empty() ? NULL : queue.front(); }
+
+    meshtastic_MeshPacket *remove(NodeNum from, PacketId id, bool tx_normal, bool tx_late)
+    {
+        for (auto it = queue.begin(); it != queue.end(); it++) {
+            auto p = (*it);
+            if (getFrom(p) == from && p->id == id && ((tx_normal && !p->tx_after) || (tx_late && p->tx_after))) {
+                queue.erase(it);
+                return p;
+            }
+        }
+        return NULL;
+    }
+
+    bool find(NodeNum from, PacketId id)
+    {
+        for (auto p : queue)
+            if (getFrom(p) == from && p->id == id)
+                return true;
+        return false;
+    }
+
+    ~SortedPacketQueue()
+    {
+        for (auto p : queue)
+            packetPool.release(p);
+    }
+};
+
+// Packets are compared by the serial stored in rx_time, each queue holds its own copy of every packet
+uint32_t serialOf(const meshtastic_MeshPacket *p)
+{
+    return p ? p->rx_time : 0;
+}
+
+const meshtastic_MeshPacket_Priority priorities[] = {
+    meshtastic_MeshPacket_Priority_BACKGROUND, meshtastic_MeshPacket_Priority_DEFAULT, meshtastic_MeshPacket_Priority_RELIABLE,
+    meshtastic_MeshPacket_Priority_RESPONSE, meshtastic_MeshPacket_Priority_ACK};
+
+// A small key space, so duplicate (from, id) pairs and index collisions are common
+meshtastic_MeshPacket randomPacket(std::mt19937 &rng, uint32_t serial)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_default;
+    uint32_t r = rng();
+    p.from = (r & 3) == 0 ? 0 : ((r & 3) == 1 ? OUR_NODE : 0x2000 + (r >> 2) % 4);
+    p.id = 1 + (r >> 8) % 12;
+    p.priority = priorities[(r >> 16) % 5];
+    p.tx_after = (r >> 24) % 4 == 0 ? 1000 + (r >> 26) : 0;
+    p.rx_time = serial;
+    return p;
+}
+
+void runEquivalence(uint32_t seed, size_t maxLen, int ops)
+{
+    std::mt19937 rng(seed);
+    MeshPacketQueue queue(maxLen);
+    SortedPacketQueue reference(maxLen);
+    uint32_t serial = 0;
+
+    for (int i = 0; i < ops; i++) {
+        uint32_t op = rng() % 10;
+        if (op < 5) {
+            meshtastic_MeshPacket p = randomPacket(rng, ++serial);
+            meshtastic_MeshPacket *a = packetPool.allocCopy(p), *b = packetPool.allocCopy(p);
+            bool queued = queue.enqueue(a);
+            TEST_ASSERT_EQUAL(reference.enqueue(b), queued);
+            if (!queued) {
+                packetPool.release(a);
+                packetPool.release(b);
+            }
+        } else if (op < 7) {
+            meshtastic_MeshPacket *a = queue.dequeue(), *b = reference.dequeue();
+            TEST_ASSERT_EQUAL_UINT32(serialOf(b), serialOf(a));
+            if (a)
+                packetPool.release(a);
+            if (b)
+                packetPool.release(b);
+        } else if (op < 9) {
+            meshtastic_MeshPacket key = randomPacket(rng, 0);
+            bool txNormal = rng() % 4 != 0, txLate = rng() % 4 != 0;
+            meshtastic_MeshPacket *a = queue.remove(getFrom(&key), key.id, txNormal, txLate);
+            meshtastic_MeshPacket *b = reference.remove(getFrom(&key), key.id, txNormal, txLate);
+            TEST_ASSERT_EQUAL_UINT32(serialOf(b), serialOf(a));
+            if (a)
+                packetPool.release(a);
+            if (b)
+                packetPool.release(b);
+        } else {
+            meshtastic_MeshPacket key = randomPacket(rng, 0);
+            TEST_ASSERT_EQUAL(reference.find(getFrom(&key), key.id), queue.find(getFrom(&key), key.id));
+        }
+
+        TEST_ASSERT_EQUAL(reference.getFree(), queue.getFree());
+        TEST_ASSERT_EQUAL_UINT32(serialOf(reference.getFront()), serialOf(queue.getFront()));
+    }
+
+    while (meshtastic_MeshPacket *p = queue.dequeue())
+        packetPool.release(p);
+}
+} // namespace
+
+void setUp(void)
+{
+    myNodeInfo.my_node_num = OUR_NODE;
+}
+
+void tearDown(void) {}
+
+// Mostly below capacity, exercises ordering, remove and find
+void test_matchesSortedQueue(void)
+{
+    for (uint32_t seed = 1; seed <= 20; seed++)
+        runEquivalence(seed, 64, 5000);
+}
+
+// A small queue that is full most of the time, exercises replacing lower priority packets
+void test_matchesSortedQueueWhenFull(void)
+{
+    for (uint32_t seed = 100; seed <= 120; seed++)
+        runEquivalence(seed, 6, 5000);
+}
+
+void setup()
+{
+    initializeTestEnvironment();
+    const std::unique_ptr<MockNodeDB> mockNodeDB(new MockNodeDB());
+    nodeDB = mockNodeDB.get();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_matchesSortedQueue);
+    RUN_TEST(test_matchesSortedQueueWhenFull);
+    exit(UNITY_END());
+}
+#else
+void setup()
+{
+    initializeTestEnvironment();
+    LOG_WARN("This test requires the ARCH_PORTDUINO variant");
+    UNITY_BEGIN();
+    exit(UNITY_END());
+}
+#endif
+void loop() {}
@@ -0,0 +1,339 @@
+#include "DebugConfiguration.h"
+#include "TestUtil.h"
+#include <unity.h>
+
+#ifdef ARCH_PORTDUINO
+#include "mesh/NodeDB.h"
+#include "mesh/generated/meshtastic/remote_hardware.pb.h"
+#include "mesh/generated/meshtastic/telemetry.pb.h"
+#include "mesh/mesh-pb-constants.h"
+#include "serialization/MeshPacketSerializer.h"
+
+#include <memory>
+#include <string.h>
+#include <string>
+#include <vector>
+
+std::string treeSerialize(const meshtastic_MeshPacket *mp, bool shouldLog);
+std::string treeSerializeEncrypted(const meshtastic_MeshPacket *mp);
+
+namespace
+{
+// Names traceroutes by the node number, leaving some nodes unknown
+class MockNodeDB : public NodeDB
+{
+  public:
+    meshtastic_NodeInfoLite *getMeshNode(NodeNum n) override
+    {
+        if (n % 3 == 0)
+            return NULL;
+        node = meshtastic_NodeInfoLite{.num = n, .has_user = true};
+        snprintf(node.user.long_name, sizeof(node.user.long_name), "Node \"%u\" / \xc3\xa9t\xc3\xa9", n);
+        return &node;
+    }
+    meshtastic_NodeInfoLite node = {};
+};
+
+meshtastic_MeshPacket makePacket(meshtastic_PortNum portnum, const pb_msgdesc_t *fields, const void *msg)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_default;
+    p.from = 0x12345678;
+    p.to = 0xffffffff;
+    p.id = 0xdeadbeef;
+    p.channel = 8;
+    p.rx_time = 1700000000;
+    p.rx_snr = -7.25;
+    p.rx_rssi = -110;
+    p.hop_start = 5;
+    p.hop_limit = 3;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p.decoded.portnum = portnum;
+    if (fields)
+        p.decoded.payload.size = pb_encode_to_bytes(p.decoded.payload.bytes, sizeof(p.decoded.payload.bytes), fields, msg);
+    return p;
+}
+
+meshtastic_MeshPacket makeText(meshtastic_PortNum portnum, const char *text)
+{
+    meshtastic_MeshPacket p = makePacket(portnum, NULL, NULL);
+    p.decoded.payload.size = strlen(text);
+    memcpy(p.decoded.payload.bytes, text, p.decoded.payload.size);
+    return p;
+}
+
+// One packet for every portnum and variant the serializer knows, with awkward values where it matters
+std::vector<meshtastic_MeshPacket> samplePackets()
+{
+    std::vector<meshtastic_MeshPacket> packets;
+
+    const char *texts[] = {"Hello mesh", "quote \" slash / backslash \\ tab \t newline \n", "\x01\x1f\x7f control",
+                           "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \xc3", "{\"b\":[1,2.5,-3e2,true,null],\"a\":\"x/y\"}",
+                           "  [1, 2, 3]  ", "true story", "12 monkeys", "null", "\"quoted\"", "-", ""};
+    for (const char *text : texts) {
+        packets.push_back(makeText(meshtastic_PortNum_TEXT_MESSAGE_APP, text));
+        packets.push_back(makeText(meshtastic_PortNum_DETECTION_SENSOR_APP, text));
+    }
+
+    meshtastic_Telemetry t = meshtastic_Telemetry_init_default;
+    t.which_variant = meshtastic_Telemetry_device_metrics_tag;
+    t.variant.device_metrics = {.has_battery_level = true, .battery_level = 87, .has_voltage = true, .voltage = 4.1,
+                                .has_channel_utilization = true, .channel_utilization = 12.3456789,
+                                .has_air_util_tx = true, .air_util_tx = 0.1, .has_uptime_seconds = true,
+                                .uptime_seconds = 123456};
+    packets.push_back(makePacket(meshtastic_PortNum_TELEMETRY_APP, &meshtastic_Telemetry_msg, &t));
+    t.variant.device_metrics.has_battery_level = false;
+    packets.push_back(makePacket(meshtastic_PortNum_TELEMETRY_APP, &meshtastic_Telemetry_msg, &t));
+
+    t = meshtastic_Telemetry_init_default;
+    t.which_variant = meshtastic_Telemetry_environment_metrics_tag;
+    meshtastic_EnvironmentMetrics &env = t.variant.environment_metrics;
+    env.has_temperature = env.has_relative_humidity = env.has_barometric_pressure = env.has_gas_resistance = true;
+    env.has_voltage = env.has_current = env.has_lux = env.has_white_lux = env.has_iaq = env.has_wind_speed = true;
+    env.has_wind_direction = env.has_wind_gust = env.has_wind_lull = env.has_radiation = true;
+    env.temperature = -12.5;
+    env.relative_humidity = 55.55;
+    env.barometric_pressure = 1013.25;
+    env.gas_resistance = 1e6;
+    env.voltage = 3.3;
+    env.current = -0.001;
+    env.lux = 1e-3;
+    env.white_lux = 12345.678;
+    env.iaq = 50;
+    env.wind_speed = 7.7;
+    env.wind_direction = 270;
+    env.wind_gust = 12;
+    env.wind_lull = 0;
+    env.radiation = 0.15;
+    packets.push_back(makePacket(meshtastic_PortNum_TELEMETRY_APP, &meshtastic_Telemetry_msg, &t));
+
+    t = meshtastic_Telemetry_init_default;
+    t.which_variant = meshtastic_Telemetry_air_quality_metrics_tag;
+    meshtastic_AirQualityMetrics &aq = t.variant.air_quality_metrics;
+    aq.has_pm10_standard = aq.has_pm25_standard = aq.has_pm100_standard = true;
+    aq.has_pm10_environmental = aq.has_pm25_environmental = aq.has_pm100_environmental = true;
+    aq.pm10_standard = 1;
+    aq.pm25_standard = 2;
+    aq.pm100_standard = 3;
+    aq.pm10_environmental = 4;
+    aq.pm25_environmental = 5;
+    aq.pm100_environmental = 6;
+    packets.push_back(makePacket(meshtastic_PortNum_TELEMETRY_APP, &meshtastic_Telemetry_msg, &t));
+
+    t = meshtastic_Telemetry_init_default;
+    t.which_variant = meshtastic_Telemetry_power_metrics_tag;
+    meshtastic_PowerMetrics &pm = t.variant.power_metrics;
+    pm.has_ch1_voltage = pm.has_ch1_current = pm.has_ch2_voltage = pm.has_ch2_current = true;
+    pm.has_ch3_voltage = pm.has_ch3_current = true;
+    pm.ch1_voltage = 12.1;
+    pm.ch1_current = 100.5;
+    pm.ch2_voltage = 5;
+    pm.ch2_current = -3;
+    pm.ch3_voltage = 3.3;
+    pm.ch3_current = 0.25;
+    packets.push_back(makePacket(meshtastic_PortNum_TELEMETRY_APP, &meshtastic_Telemetry_msg, &t));
+
+    t = meshtastic_Telemetry_init_default;
+    t.which_variant = meshtastic_Telemetry_local_stats_tag; // Not serialized, gives an empty payload
+    packets.push_back(makePacket(meshtastic_PortNum_TELEMETRY_APP, &meshtastic_Telemetry_msg, &t));
+
+    meshtastic_User user = meshtastic_User_init_default;
+    strcpy(user.id, "!12345678");
+    strcpy(user.long_name, "Long \"name\" \xf0\x9f\x93\xa1");
+    strcpy(user.short_name, "LN/1");
+    user.hw_model = meshtastic_HardwareModel_TBEAM;
+    user.role = meshtastic_Config_DeviceConfig_Role_ROUTER;
+    packets.push_back(makePacket(meshtastic_PortNum_NODEINFO_APP, &meshtastic_User_msg, &user));
+
+    meshtastic_Position pos = meshtastic_Position_init_default;
+    pos.latitude_i = 525200000;
+    pos.longitude_i = -134000000;
+    packets.push_back(makePacket(meshtastic_PortNum_POSITION_APP, &meshtastic_Position_msg, &pos));
+    pos.time = 1700000001;
+    pos.timestamp = 1700000002;
+    pos.altitude = -20;
+    pos.ground_speed = 3;
+    pos.ground_track = 180;
+    pos.sats_in_view = 9;
+    pos.PDOP = 150;
+    pos.HDOP = 100;
+    pos.VDOP = 120;
+    pos.precision_bits = 32;
+    packets.push_back(makePacket(meshtastic_PortNum_POSITION_APP, &meshtastic_Position_msg, &pos));
+
+    meshtastic_Waypoint wp = meshtastic_Waypoint_init_default;
+    wp.id = 42;
+    strcpy(wp.name, "Camp");
+    strcpy(wp.description, "Meet \"here\"\r\n");
+    wp.expire = 1800000000;
+    wp.locked_to = 0x12345678;
+    wp.latitude_i = -335000000;
+    wp.longitude_i = 1512000000;
+    packets.push_back(makePacket(meshtastic_PortNum_WAYPOINT_APP, &meshtastic_Waypoint_msg, &wp));
+
+    meshtastic_NeighborInfo ni = meshtastic_NeighborInfo_init_default;
+    ni.node_id = 0x12345678;
+    ni.last_sent_by_id = 0x87654321;
+    ni.node_broadcast_interval_secs = 900;
+    packets.push_back(makePacket(meshtastic_PortNum_NEIGHBORINFO_APP, &meshtastic_NeighborInfo_msg, &ni));
+    ni.neighbors_count = 3;
+    for (int i = 0; i < 3; i++)
+        ni.neighbors[i] = {.node_id = 0x1000u + i, .snr = -5.5f + 4 * i};
+    packets.push_back(makePacket(meshtastic_PortNum_NEIGHBORINFO_APP, &meshtastic_NeighborInfo_msg, &ni));
+
+    meshtastic_RouteDiscovery rd = meshtastic_RouteDiscovery_init_default;
+    rd.route_count = rd.snr_towards_count = 3;
+    rd.route_back_count = rd.snr_back_count = 2;
+    for (int i = 0; i < 3; i++) {
+        rd.route[i] = 100 + i;
+        rd.snr_towards[i] = -20 + 7 * i;
+    }
+    for (int i = 0; i < 2; i++) {
+        rd.route_back[i] = 200 + i;
+        rd.snr_back[i] = 9 - i;
+    }
+    meshtastic_MeshPacket trace = makePacket(meshtastic_PortNum_TRACEROUTE_APP, &meshtastic_RouteDiscovery_msg, &rd);
+    packets.push_back(trace); // A request, no payload
+    trace.decoded.request_id = 1234;
+    packets.push_back(trace);
+
+    meshtastic_HardwareMessage hw = meshtastic_HardwareMessage_init_default;
+    hw.gpio_value = 0xff00;
+    hw.gpio_mask = 0x0ff0;
+    for (auto type : {meshtastic_HardwareMessage_Type_GPIOS_CHANGED, meshtastic_HardwareMessage_Type_READ_GPIOS_REPLY,
+                      meshtastic_HardwareMessage_Type_WATCH_GPIOS}) {
+        hw.type = type;
+        packets.push_back(makePacket(meshtastic_PortNum_REMOTE_HARDWARE_APP, &meshtastic_HardwareMessage_msg, &hw));
+    }
+
+    // Undecodable payloads, a portnum without JSON and a packet without hops or signal readings
+    meshtastic_MeshPacket bad = makeText(meshtastic_PortNum_POSITION_APP, "\xff\xff\xff");
+    packets.push_back(bad);
+    bad.decoded.portnum = meshtastic_PortNum_TELEMETRY_APP;
+    packets.push_back(bad);
+    bad.decoded.portnum = meshtastic_PortNum_PRIVATE_APP;
+    bad.rx_snr = 0;
+    bad.rx_rssi = 0;
+    bad.hop_start = 0;
+    packets.push_back(bad);
+
+    return packets;
+}
+
+std::string withoutMember(std::string json, const char *name)
+{
+    size_t start = json.find(std::string("\"") + name + "\":");
+    if (start != std::string::npos)
+        json.erase(start, json.find(',', start) + 1 - start);
+    return json;
+}
+} // namespace
+
+void setUp(void)
+{
+    owner = meshtastic_User{.id = "!12345678"};
+}
+
+void tearDown(void) {}
+
+void test_matchesTreeSerializer(void)
+{
+    for (const auto &p : samplePackets()) {
+        std::string expected = treeSerialize(&p, false);
+        std::string actual = MeshPacketSerializer::JsonSerialize(&p, false);
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), actual.c_str());
+    }
+}
+
+void test_encryptedMatchesTreeSerializer(void)
+{
+    meshtastic_MeshPacket p = makePacket(meshtastic_PortNum_UNKNOWN_APP, NULL, NULL);
+    p.which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+    p.want_ack = true;
+    p.encrypted.size = sizeof(p.encrypted.bytes);
+    for (size_t i = 0; i < p.encrypted.size; i++)
+        p.encrypted.bytes[i] = i * 37;
+
+    // time_ms is millis() and may tick between the two calls
+    std::string expected = withoutMember(treeSerializeEncrypted(&p), "time_ms");
+    std::string actual = withoutMember(MeshPacketSerializer::JsonSerializeEncrypted(&p), "time_ms");
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), actual.c_str());
+}
+
+void test_bufferTooSmall(void)
+{
+    meshtastic_MeshPacket p = makeText(meshtastic_PortNum_TEXT_MESSAGE_APP, "Hello mesh");
+    std::string expected = MeshPacketSerializer::JsonSerialize(&p, false);
+
+    std::vector<char> buf(expected.length() + 1);
+    TEST_ASSERT_EQUAL(expected.length(), MeshPacketSerializer::JsonSerialize(&p, buf.data(), buf.size(), false));
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), buf.data());
+    TEST_ASSERT_EQUAL(0, MeshPacketSerializer::JsonSerialize(&p, buf.data(), buf.size() - 1, false));
+}
+
+void test_longTextFallsBackToHeap(void)
+{
+    // Every byte escaped as \u00xx takes 6 chars, far more than the stack buffer
+    meshtastic_MeshPacket p = makeText(meshtastic_PortNum_DETECTION_SENSOR_APP, "");
+    p.decoded.payload.size = sizeof(p.decoded.payload.bytes);
+    memset(p.decoded.payload.bytes, 0x01, p.decoded.payload.size);
+
+    std::string expected = treeSerialize(&p, false);
+    TEST_ASSERT_GREATER_THAN(MESHPACKET_JSON_BUFFER, expected.length());
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), MeshPacketSerializer::JsonSerialize(&p, false).c_str());
+}
+
+void test_benchmarkSerialize(void)
+{
+    const int rounds = 2000;
+    const auto packets = samplePackets();
+    char buf[MESHPACKET_JSON_BUFFER];
+    volatile size_t sink = 0;
+
+    uint32_t start = micros();
+    for (int i = 0; i < rounds; i++)
+        for (const auto &p : packets)
+            sink += treeSerialize(&p, false).length();
+    uint32_t treeUs = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < rounds; i++)
+        for (const auto &p : packets)
+            sink += MeshPacketSerializer::JsonSerialize(&p, false).length();
+    uint32_t stringUs = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < rounds; i++)
+        for (const auto &p : packets)
+            sink += MeshPacketSerializer::JsonSerialize(&p, buf, sizeof(buf), false);
+    uint32_t bufferUs = micros() - start;
+
+    const float n = (float)rounds * packets.size();
+    LOG_INFO("JSON serialize, %u packets: JSONValue tree %.3f us/packet, JSONWriter to std::string %.3f us/packet, to "
+             "buffer %.3f us/packet",
+             (uint32_t)packets.size(), treeUs / n, stringUs / n, bufferUs / n);
+}
+
+void setup()
+{
+    initializeTestEnvironment();
+    const std::unique_ptr<MockNodeDB> mockNodeDB(new MockNodeDB());
+    nodeDB = mockNodeDB.get();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_matchesTreeSerializer);
+    RUN_TEST(test_encryptedMatchesTreeSerializer);
+    RUN_TEST(test_bufferTooSmall);
+    RUN_TEST(test_longTextFallsBackToHeap);
+    RUN_TEST(test_benchmarkSerialize);
+    exit(UNITY_END());
+}
+#else
+void setup()
+{
+    initializeTestEnvironment();
+    LOG_WARN("This test requires the ARCH_PORTDUINO variant of NodeDB");
+    UNITY_BEGIN();
+    exit(UNITY_END());
+}
+#endif
+void loop() {}